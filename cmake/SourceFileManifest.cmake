@@ -1,9 +1,15 @@
 set(MYPROJ_LIB_SOURCE_MANIFEST
+  src/mgfw/Capture.cpp
   src/mgfw/Clock.cpp
   src/mgfw/Injector.cpp
+  src/mgfw/MappedFile.cpp
+  src/mgfw/Mapping.cpp
   src/mgfw/Scheduler.cpp
+  src/mgfw/SharedMemory.cpp
+  src/mgfw/SharedMQHive.cpp
   src/mgfw/SpdlogLogger.cpp
   src/mgfw/Window.cpp
+  src/mgfw/WorkerPool.cpp
 )
 
 set(MYPROJ_EXE_SOURCE_MANIFEST
@@ -13,4 +19,6 @@ set(MYPROJ_EXE_SOURCE_MANIFEST
 # Relative to test/integration
 set(MYPROJ_INTEGRATION_SOURCE_MANIFEST
   bulkmsg.cpp
+  hivelookup.cpp
+  variantdispatch.cpp
 )
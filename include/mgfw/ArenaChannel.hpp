@@ -0,0 +1,302 @@
+#pragma once
+
+#include "mgfw/SyncCell.hpp"
+#include "mgfw/TypeHash.hpp"
+#include "mgfw/defer.hpp"
+#include "mgfw/fnv1a.hpp"
+#include "mgfw/types.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mgfw {
+
+namespace detail_ {
+  template<typename T>
+  constexpr bool is_span_ = false;
+
+  template<typename T>
+  constexpr bool is_span_<std::span<T>> = true;
+}  // namespace detail_
+
+/**
+ * Values that can be stored in an ArenaChannel as a plain copy of their bytes. Pointers and views
+ * are excluded, since copying them would not copy what they point to; strings and spans have their
+ * own publish overloads.
+ */
+template<typename T>
+concept ArenaValue = std::is_trivially_copyable_v<T> && !std::is_pointer_v<T> && !std::is_array_v<T>
+                  && !std::convertible_to<T, std::string_view> && !detail_::is_span_<T>;
+
+/**
+ * One record read from an ArenaChannel: a type tag plus the payload bytes, which live in the arena
+ * and are only valid for the duration of the drain callback.
+ *
+ * Records are written as one of
+ *  - an ArenaValue T, read back via as<T>() (which copies it out)
+ *  - a string, read back via as<std::string_view>()
+ *  - an array of ArenaValue U, read back via as<std::span<const U>>()
+ * and is<...>() checks the tag using the same type the record is read back as.
+ */
+class ArenaRecord {
+public:
+  ArenaRecord(const Hash_t tag, std::span<const std::byte> payload)
+    : tag_(tag), payload_(payload) { }
+
+  Hash_t tag() const { return tag_; }
+
+  std::span<const std::byte> payload() const { return payload_; }
+
+  template<typename T>
+  bool is() const {
+    return tag_ == TypeHash<T>;
+  }
+
+  template<typename T>
+  T as() const {
+    assert(is<T>());
+
+    if constexpr(std::same_as<T, std::string_view>) {
+      return {reinterpret_cast<const char *>(payload_.data()), payload_.size()};
+    }
+    else if constexpr(detail_::is_span_<T>) {
+      using Element_t = typename T::element_type;
+      static_assert(std::is_const_v<Element_t>, "Arena payloads are read-only");
+      return {reinterpret_cast<Element_t *>(payload_.data()), payload_.size() / sizeof(Element_t)};
+    }
+    else {
+      static_assert(ArenaValue<T>, "ArenaRecord::as only supports ArenaValues, strings and spans");
+      T value;
+      std::memcpy(&value, payload_.data(), sizeof(T));
+      return value;
+    }
+  }
+
+private:
+  Hash_t                     tag_;
+  std::span<const std::byte> payload_;
+};
+
+/**
+ * Channel carrying messages of any (supported) type and size, serialized back to back into a
+ * chunked byte arena.
+ *
+ * Each record is a small header holding the TypeHash tag and payload size, followed by the payload
+ * itself, padded to RECORD_ALIGNMENT. Strings and arrays are stored inline, so unlike a
+ * MessageQueue<std::string> neither writing nor draining allocates per message. Readers dispatch
+ * on each record's tag; see ArenaRecord.
+ *
+ * Writers append under a mutex. Draining swaps out the filled chunks, so callbacks run without
+ * holding up writers, and hands the chunks back for reuse afterwards; once the arena has grown to
+ * fit the traffic between two drains it stops allocating. Records too large for a chunk get a
+ * dedicated chunk, which is freed after draining.
+ */
+class ArenaChannel {
+public:
+  static constexpr std::size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+  static constexpr std::size_t RECORD_ALIGNMENT   = 8;
+
+  explicit ArenaChannel(const U64 id, const std::size_t chunkSize = DEFAULT_CHUNK_SIZE)
+    : id_(id), chunkSize_(std::max(chunkSize, HEADER_SIZE)) { }
+
+  ArenaChannel(const ArenaChannel &)            = delete;
+  ArenaChannel &operator=(const ArenaChannel &) = delete;
+  ArenaChannel(ArenaChannel &&)                 = delete;
+  ArenaChannel &operator=(ArenaChannel &&)      = delete;
+  ~ArenaChannel()                               = default;
+
+  /**
+   * Number of records waiting to be drained
+   */
+  std::size_t size_approx() { return stateCell_.get_locked()->records; }
+
+  template<ArenaValue T>
+  void publish(const T &value) {
+    append_(TypeHash<T>, std::as_bytes(std::span(&value, 1)));
+  }
+
+  void publish(std::string_view str) {
+    append_(TypeHash<std::string_view>, std::as_bytes(std::span<const char>(str)));
+  }
+
+  template<ArenaValue T>
+  requires(alignof(T) <= RECORD_ALIGNMENT)
+  void publish(std::span<const T> values) {
+    append_(TypeHash<std::span<const T>>, std::as_bytes(values));
+  }
+
+  template<ArenaValue T>
+  requires(alignof(T) <= RECORD_ALIGNMENT)
+  void publish(const std::vector<T> &values) {
+    publish(std::span<const T>(values));
+  }
+
+  /**
+   * Invoke a callback on each record written since the last drain, in order
+   */
+  template<typename Callback_t>
+  requires std::invocable<Callback_t, const ArenaRecord &>
+  void drain(const Callback_t &callback) {
+    const std::scoped_lock drainLock(drainMutex_);
+    {
+      auto state = stateCell_.get_locked();
+      std::swap(state->filled, draining_);
+      state->records = 0;
+    }
+
+    const defer recycle([this] { recycle_drained_(); });
+    for(const Chunk_ &chunk : draining_) {
+      std::size_t offset = 0;
+      while(offset < chunk.used) {
+        Header_ header;
+        std::memcpy(&header, chunk.bytes.get() + offset, HEADER_SIZE);
+        callback(ArenaRecord(header.tag, {chunk.bytes.get() + offset + HEADER_SIZE, header.size}));
+        offset += record_size_(header.size);
+      }
+    }
+  }
+
+private:
+  struct Header_ {
+    Hash_t tag;
+    U32    size;
+  };
+
+  static constexpr std::size_t HEADER_SIZE = sizeof(Header_);
+  static_assert(HEADER_SIZE % RECORD_ALIGNMENT == 0);
+
+  struct Chunk_ {
+    std::unique_ptr<std::byte[]> bytes;
+    std::size_t                  capacity = 0;
+    std::size_t                  used     = 0;
+  };
+
+  struct State_ {
+    std::vector<Chunk_> filled;
+    std::vector<Chunk_> spare;
+    std::size_t         records = 0;
+  };
+
+  static constexpr std::size_t record_size_(const std::size_t payloadSize) {
+    return HEADER_SIZE + (payloadSize + RECORD_ALIGNMENT - 1) / RECORD_ALIGNMENT * RECORD_ALIGNMENT;
+  }
+
+  static Chunk_ make_chunk_(const std::size_t capacity) {
+    return {.bytes = std::make_unique_for_overwrite<std::byte[]>(capacity), .capacity = capacity};
+  }
+
+  void append_(const Hash_t tag, std::span<const std::byte> payload) {
+    if(payload.size() > std::numeric_limits<U32>::max()) {
+      throw std::length_error(
+        std::format("ArenaChannel {}: {} byte record is too large", id_, payload.size()));
+    }
+
+    const Header_     header{.tag = tag, .size = static_cast<U32>(payload.size())};
+    const std::size_t size  = record_size_(payload.size());
+    auto              state = stateCell_.get_locked();
+
+    if(state->filled.empty() || state->filled.back().capacity - state->filled.back().used < size)
+    {
+      if(size > chunkSize_) {
+        state->filled.push_back(make_chunk_(size));
+      }
+      else if(!state->spare.empty()) {
+        state->filled.push_back(std::move(state->spare.back()));
+        state->spare.pop_back();
+      }
+      else {
+        state->filled.push_back(make_chunk_(chunkSize_));
+      }
+    }
+
+    Chunk_ &chunk = state->filled.back();
+    std::memcpy(chunk.bytes.get() + chunk.used, &header, HEADER_SIZE);
+    if(!payload.empty()) {
+      std::memcpy(chunk.bytes.get() + chunk.used + HEADER_SIZE, payload.data(), payload.size());
+    }
+    chunk.used += size;
+    ++state->records;
+  }
+
+  void recycle_drained_() {
+    auto state = stateCell_.get_locked();
+    for(Chunk_ &chunk : draining_) {
+      // Oversized chunks were only made for a single record
+      if(chunk.capacity == chunkSize_) {
+        chunk.used = 0;
+        state->spare.push_back(std::move(chunk));
+      }
+    }
+    draining_.clear();
+  }
+
+  const U64         id_;
+  const std::size_t chunkSize_;
+
+  SyncCell<State_> stateCell_;
+
+  // Only touched by drain
+  std::mutex          drainMutex_;
+  std::vector<Chunk_> draining_;
+};
+
+/**
+ * Write-only sender end of an ArenaChannel
+ */
+class ArenaWriter {
+public:
+  explicit ArenaWriter(ArenaChannel &channel) : channel_(channel) { }
+
+  ArenaWriter(const ArenaWriter &)            = delete;
+  ArenaWriter &operator=(const ArenaWriter &) = delete;
+  ArenaWriter(ArenaWriter &&)                 = default;
+  ArenaWriter &operator=(ArenaWriter &&)      = default;
+  ~ArenaWriter()                              = default;
+
+  template<typename T>
+  requires requires(ArenaChannel &channel, const T &message) { channel.publish(message); }
+  void write(const T &message) {
+    channel_.publish(message);
+  }
+
+private:
+  ArenaChannel &channel_;
+};
+
+/**
+ * Read-only receiver end of an ArenaChannel
+ */
+class ArenaReader {
+public:
+  explicit ArenaReader(ArenaChannel &channel) : channel_(channel) { }
+
+  ArenaReader(const ArenaReader &)            = delete;
+  ArenaReader &operator=(const ArenaReader &) = delete;
+  ArenaReader(ArenaReader &&)                 = default;
+  ArenaReader &operator=(ArenaReader &&)      = default;
+  ~ArenaReader()                              = default;
+
+  template<typename Callback>
+  requires std::invocable<Callback, const ArenaRecord &>
+  void drain(Callback &&callback) {
+    channel_.drain(std::forward<Callback>(callback));
+  }
+
+private:
+  ArenaChannel &channel_;
+};
+
+}  // namespace mgfw
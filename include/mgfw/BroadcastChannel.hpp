@@ -0,0 +1,241 @@
+#pragma once
+
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/types.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <format>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace mgfw {
+
+/**
+ * Multicast channel where every subscribed reader sees every message.
+ *
+ * Disruptor-style ring buffer: each message is written once into a slot, and read in place by all
+ * subscribers. Every subscriber owns a sequence cursor; writers may not claim a slot until the
+ * slowest subscriber has moved past the message it previously held, so a stalled subscriber
+ * eventually stalls the writers (rather than losing messages or growing without bound).
+ *
+ * Subscribers only see messages written after they subscribed. With no subscribers, writers simply
+ * overwrite the ring, though a writer still waits for the previous write to its slot to finish.
+ */
+template<MessageType T>
+class BroadcastChannel {
+public:
+  static constexpr std::size_t DEFAULT_CAPACITY = 1024;
+  static constexpr std::size_t MAX_SUBSCRIBERS  = 32;
+
+  BroadcastChannel(const U64 id, const std::size_t capacity = DEFAULT_CAPACITY)
+    : id_(id),
+      mask_(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1),
+      slots_(std::make_unique<Slot_[]>(mask_ + 1)) { }
+
+  BroadcastChannel(const BroadcastChannel &)            = delete;
+  BroadcastChannel &operator=(const BroadcastChannel &) = delete;
+  BroadcastChannel(BroadcastChannel &&)                 = delete;
+  BroadcastChannel &operator=(BroadcastChannel &&)      = delete;
+  ~BroadcastChannel()                                   = default;
+
+  std::size_t capacity() const { return mask_ + 1; }
+
+  /**
+   * Write a message into the next slot, waiting for the slowest subscriber if the ring is full.
+   * Safe to call from any number of threads.
+   */
+  template<typename U>
+  requires std::assignable_from<T &, U &&>
+  void publish(U &&message) {
+    const U64 seq = claim_.fetch_add(1, std::memory_order::seq_cst);
+    wait_for_room_(seq);
+
+    // Writers a lap apart claim the same slot, and nothing above holds them back when there are no
+    // subscribers, so also wait for the slot's previous writer to be done with it
+    Slot_    &slot     = slots_[seq & mask_];
+    const U64 previous = seq >= capacity() ? seq - capacity() : INACTIVE;
+    while(slot.sequence.load(std::memory_order::acquire) != previous) {
+      std::this_thread::yield();
+    }
+
+    slot.value = std::forward<U>(message);
+    slot.sequence.store(seq, std::memory_order::release);
+  }
+
+  /**
+   * Register a new subscriber, which will see every message published from here on. Returns a
+   * handle to pass to drain/unsubscribe.
+   */
+  std::size_t subscribe() {
+    for(std::size_t i = 0; i < MAX_SUBSCRIBERS; ++i) {
+      auto &cursor   = cursors_[i].next;
+      U64   expected = INACTIVE;
+
+      // Writers that claimed a sequence before they could see this cursor may be about to overwrite
+      // anything before the claim position we read afterwards, so we start there.
+      if(cursor.compare_exchange_strong(
+           expected, claim_.load(std::memory_order::seq_cst), std::memory_order::seq_cst))
+      {
+        cursor.store(claim_.load(std::memory_order::seq_cst), std::memory_order::seq_cst);
+        return i;
+      }
+    }
+
+    throw std::runtime_error(std::format(
+      "BroadcastChannel {} cannot accept more than {} subscribers", id_, MAX_SUBSCRIBERS));
+  }
+
+  void unsubscribe(const std::size_t subscriber) {
+    cursors_[subscriber].next.store(INACTIVE, std::memory_order::release);
+  }
+
+  /**
+   * Invoke a callback on each message the subscriber hasn't seen yet, reading it in place
+   */
+  template<MessageDrainCallback<T> Callback_t>
+  void drain(const std::size_t subscriber, const Callback_t &callback) {
+    auto &cursor = cursors_[subscriber].next;
+    U64   next   = cursor.load(std::memory_order::relaxed);
+
+    while(true) {
+      const Slot_ &slot = slots_[next & mask_];
+      if(slot.sequence.load(std::memory_order::acquire) != next) {
+        break;
+      }
+
+      callback(slot.value);
+      ++next;
+
+      // Let waiting writers make progress without waiting on the rest of the drain
+      if((next & mask_) == 0) {
+        cursor.store(next, std::memory_order::release);
+      }
+    }
+
+    cursor.store(next, std::memory_order::release);
+  }
+
+private:
+  static constexpr U64 INACTIVE = std::numeric_limits<U64>::max();
+
+  struct Slot_ {
+    std::atomic<U64> sequence{INACTIVE};
+    T                value;
+  };
+
+  struct alignas(CACHE_LINE_SIZE) Cursor_ {
+    // The next sequence this subscriber will read; everything before it has been consumed
+    std::atomic<U64> next{INACTIVE};
+  };
+
+  /**
+   * Wait until every subscriber has consumed the message that previously occupied `seq`'s slot.
+   */
+  void wait_for_room_(const U64 seq) {
+    while(seq >= gate_.load(std::memory_order::acquire) + capacity()) {
+      // No subscribers means no-one to wait for
+      U64 slowest = seq;
+      for(const auto &cursor : cursors_) {
+        slowest = std::min(slowest, cursor.next.load(std::memory_order::seq_cst));
+      }
+
+      // The slowest cursor only ever moves forward, so any value computed here stays a valid lower
+      // bound even if it races with another writer's (older) store
+      gate_.store(slowest, std::memory_order::release);
+
+      if(seq >= slowest + capacity()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  const U64            id_;
+  const std::size_t    mask_;
+  std::unique_ptr<Slot_[]> slots_;
+
+  alignas(CACHE_LINE_SIZE) std::atomic<U64> claim_{0};
+  alignas(CACHE_LINE_SIZE) std::atomic<U64> gate_{0};
+
+  std::array<Cursor_, MAX_SUBSCRIBERS> cursors_;
+};
+
+/**
+ * Write-only sender end of a BroadcastChannel
+ */
+template<MessageType T>
+class BroadcastWriter {
+public:
+  explicit BroadcastWriter(BroadcastChannel<T> &channel) : channel_(channel) { }
+
+  BroadcastWriter(const BroadcastWriter &)            = delete;
+  BroadcastWriter &operator=(const BroadcastWriter &) = delete;
+  BroadcastWriter(BroadcastWriter &&)                 = default;
+  BroadcastWriter &operator=(BroadcastWriter &&)      = default;
+  ~BroadcastWriter()                                  = default;
+
+  void write(const T &message) { channel_.publish(message); }
+
+  void write(T &&message) { channel_.publish(std::move(message)); }
+
+  template<typename... Args>
+  requires std::constructible_from<T, Args...>
+  void emplace(Args &&...args) {
+    channel_.publish(T{std::forward<Args>(args)...});
+  }
+
+private:
+  BroadcastChannel<T> &channel_;
+};
+
+/**
+ * Read-only subscriber end of a BroadcastChannel. Subscribes on construction, and unsubscribes on
+ * destruction.
+ */
+template<MessageType T>
+class BroadcastReader {
+public:
+  explicit BroadcastReader(BroadcastChannel<T> &channel)
+    : channel_(&channel), subscriber_(channel.subscribe()) { }
+
+  ~BroadcastReader() {
+    if(channel_ != nullptr) {
+      channel_->unsubscribe(subscriber_);
+    }
+  }
+
+  BroadcastReader(const BroadcastReader &)            = delete;
+  BroadcastReader &operator=(const BroadcastReader &) = delete;
+
+  BroadcastReader(BroadcastReader &&other) noexcept
+    : channel_(std::exchange(other.channel_, nullptr)), subscriber_(other.subscriber_) { }
+
+  BroadcastReader &operator=(BroadcastReader &&other) noexcept {
+    if(this != &other) {
+      if(channel_ != nullptr) {
+        channel_->unsubscribe(subscriber_);
+      }
+      channel_    = std::exchange(other.channel_, nullptr);
+      subscriber_ = other.subscriber_;
+    }
+    return *this;
+  }
+
+  template<MessageDrainCallback<T> Callback>
+  void drain(Callback &&callback) {
+    channel_->drain(subscriber_, std::forward<Callback>(callback));
+  }
+
+private:
+  BroadcastChannel<T> *channel_;
+  std::size_t          subscriber_;
+};
+
+}  // namespace mgfw
@@ -0,0 +1,286 @@
+#pragma once
+
+#include "mgfw/EventWriter.hpp"
+#include "mgfw/IClock.hpp"
+#include "mgfw/MQHive.hpp"
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/Scheduler.hpp"
+#include "mgfw/TypeHash.hpp"
+#include "mgfw/types.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mgfw {
+
+/**
+ * Messages that can be captured as a plain copy of their bytes
+ */
+template<typename T>
+concept CaptureMessage = MessageType<T> && std::is_trivially_copyable_v<T>;
+
+namespace detail_ {
+  /**
+   * One message in a capture file. On disk, each record is the fields below (in native byte order,
+   * without padding) followed by `size` payload bytes; the file starts with CAPTURE_MAGIC.
+   */
+  struct CaptureRecord {
+    Duration_t             offset{};  // Since the recording started
+    U64                    channel  = 0;
+    Hash_t                 typeHash = 0;
+    Priority               priority = Priority::Normal;
+    std::vector<std::byte> payload;
+  };
+
+  constexpr std::array<char, 8> CAPTURE_MAGIC{'M', 'G', 'F', 'W', 'C', 'A', 'P', '1'};
+
+  // Size of a record on disk, not counting its payload
+  constexpr std::size_t CAPTURE_HEADER_BYTES =
+    sizeof(S64) + sizeof(U64) + sizeof(Hash_t) + sizeof(U32) + sizeof(U8);
+}  // namespace detail_
+
+/**
+ * Taps MessageQueues in an MQHive and writes every message that goes into them, timestamped, to a
+ * capture file that a Replayer can play back.
+ *
+ * On the producer's thread, a tap only stamps the message and copies it, already laid out as a file
+ * record, into a byte ring of PRODUCER_BUFFER_BYTES that belongs to that thread (allocated the
+ * first time the thread records something). A producer only waits if its own ring is full. Every
+ * WRITE_INTERVAL, a background thread merges the rings into the file by offset; a record that
+ * shows up late is written with the latest offset so far, so offsets never go backwards.
+ *
+ * The recorder must be destroyed before the hive; destroying it removes its taps and writes out
+ * the rest of the file.
+ */
+class Recorder {
+public:
+  static constexpr Duration_t  WRITE_INTERVAL        = std::chrono::milliseconds(10);
+  static constexpr std::size_t PRODUCER_BUFFER_BYTES = std::size_t{1} << 20U;
+
+  Recorder(MQHive &hive, IClock &clock, const std::filesystem::path &path);
+
+  Recorder(const Recorder &)            = delete;
+  Recorder &operator=(const Recorder &) = delete;
+  Recorder(Recorder &&)                 = delete;
+  Recorder &operator=(Recorder &&)      = delete;
+
+  ~Recorder();
+
+  /**
+   * Start recording the MessageQueue with the given ID (replacing any tap it already has)
+   */
+  template<CaptureMessage Raw_t, typename T = std::decay_t<Raw_t>>
+  void record(U64 id) {
+    static_assert(detail_::CAPTURE_HEADER_BYTES + sizeof(T) <= PRODUCER_BUFFER_BYTES,
+                  "Message too large for the recorder's buffers");
+
+    hive_.set_tap<T>(id, [this, id](const T &message, const Priority priority) {
+      append_(id, TypeHash<T>, priority, std::as_bytes(std::span(&message, 1)));
+    });
+    untaps_.emplace_back([&hive = hive_, id] { hive.set_tap<T>(id, nullptr); });
+  }
+
+  /**
+   * Number of messages recorded so far. Writes out the buffered ones first, so this counts every
+   * message whose write has returned.
+   */
+  U64 recorded();
+
+  /**
+   * Write out the buffered messages and flush the file
+   */
+  void flush();
+
+private:
+  struct ProducerBuffer_;
+
+  // Where the writer is in one producer's buffer
+  struct Cursor_ {
+    ProducerBuffer_ *buffer;
+    U64              tail;
+    U64              head;
+  };
+
+  void append_(U64                        channel,
+               Hash_t                     typeHash,
+               Priority                   priority,
+               std::span<const std::byte> payload);
+
+  // The calling thread's buffer, created on first use
+  ProducerBuffer_ &buffer_();
+
+  void run_writer_(std::stop_token stop);
+
+  // Must hold fileMutex_
+  void write_pending_();
+
+  MQHive           &hive_;
+  IClock           &clock_;
+  const TimePoint_t start_;
+
+  // Unique across recorders, unlike their addresses; keys each thread's cached buffer
+  const U64 id_;
+
+  std::vector<std::function<void()>> untaps_;
+
+  // Buffers are only added, and live as long as the recorder
+  std::mutex                                                            buffersMutex_;
+  std::unordered_map<std::thread::id, std::unique_ptr<ProducerBuffer_>> buffers_;
+
+  std::mutex           fileMutex_;
+  std::ofstream        file_;
+  std::vector<Cursor_> cursors_;
+  S64                  lastOffset_ = 0;
+  U64                  recorded_   = 0;
+
+  // Set by a producer that finds its buffer full, to have the writer come round early
+  std::atomic<bool>           backlogged_{false};
+  std::mutex                  wakeMutex_;
+  std::condition_variable_any wake_;
+  std::jthread                writerThread_;
+};
+
+/**
+ * How a Replayer spaces out the messages it re-injects
+ */
+enum class ReplayTiming : U8 {
+  Original,          // As recorded
+  Scaled,            // As recorded, sped up by ReplayConfig::speed
+  AsFastAsPossible,  // Back to back
+};
+
+struct ReplayConfig {
+  ReplayTiming timing = ReplayTiming::Original;
+
+  // Only used with ReplayTiming::Scaled; 2.0 replays twice as fast as recorded
+  double speed = 1.0;
+
+  // Called on the scheduler thread once every message has been replayed
+  std::function<void()> onFinished;
+};
+
+struct ReplayStats {
+  U64 replayed = 0;
+
+  // Messages for channels without a route, whose type doesn't match their route, or that their
+  // queue refused (see OverflowPolicy)
+  U64 skipped = 0;
+};
+
+/**
+ * Plays a capture file written by a Recorder back into an MQHive, through EventWriters.
+ *
+ * Each recorded channel to be replayed needs a route(), which names its message type. Replay runs
+ * as jobs on a Scheduler, timed by the scheduler's clock, and starts with the first message right
+ * away. The replayer must outlive the replay.
+ */
+class Replayer {
+public:
+  /**
+   * Messages injected per scheduler job at most, so a fast replay doesn't hog the scheduler
+   */
+  static constexpr std::size_t MAX_BATCH = 1024;
+
+  Replayer(MQHive &hive, const std::filesystem::path &path);
+
+  Replayer(const Replayer &)            = delete;
+  Replayer &operator=(const Replayer &) = delete;
+  Replayer(Replayer &&)                 = delete;
+  Replayer &operator=(Replayer &&)      = delete;
+  ~Replayer()                           = default;
+
+  /**
+   * Replay the recorded messages of channel `id` into the hive's MessageQueue<T> with that ID
+   */
+  template<CaptureMessage Raw_t, typename T = std::decay_t<Raw_t>>
+  void route(U64 id) {
+    routes_.insert_or_assign(id, std::make_unique<Route_<T>>(hive_.get_writer<T>(id)));
+  }
+
+  /**
+   * Start replaying; `clock` must be the one `scheduler` runs on
+   */
+  void start(Scheduler &scheduler, IClock &clock, ReplayConfig config = {});
+
+  bool finished() const { return finished_.load(std::memory_order::acquire); }
+
+  ReplayStats stats() const {
+    return {
+      .replayed = replayed_.load(std::memory_order::relaxed),
+      .skipped  = skipped_.load(std::memory_order::relaxed),
+    };
+  }
+
+private:
+  struct RouteBase_ {
+    RouteBase_()          = default;
+    virtual ~RouteBase_() = default;
+
+    RouteBase_(const RouteBase_ &)            = delete;
+    RouteBase_(RouteBase_ &&)                 = delete;
+    RouteBase_ &operator=(const RouteBase_ &) = delete;
+    RouteBase_ &operator=(RouteBase_ &&)      = delete;
+
+    // Returns false if the record doesn't hold the route's message type, or the queue refused it
+    virtual bool inject(const detail_::CaptureRecord &record) = 0;
+  };
+
+  template<CaptureMessage T>
+  struct Route_ : public RouteBase_ {
+    explicit Route_(EventWriter<T> writerArg) : writer(std::move(writerArg)) { }
+
+    bool inject(const detail_::CaptureRecord &record) override {
+      if(record.typeHash != TypeHash<T> || record.payload.size() != sizeof(T)) {
+        return false;
+      }
+
+      T message;
+      std::memcpy(&message, record.payload.data(), sizeof(T));
+      return writer.write(message, record.priority);
+    }
+
+    EventWriter<T> writer;
+  };
+
+  bool read_next_();
+
+  TimePoint_t due_(const detail_::CaptureRecord &record) const;
+
+  void step_();
+
+  MQHive       &hive_;
+  std::ifstream file_;
+
+  std::unordered_map<U64, std::unique_ptr<RouteBase_>> routes_;
+
+  // Replay state, only touched by the scheduler thread once started
+  Scheduler             *scheduler_ = nullptr;
+  IClock                *clock_     = nullptr;
+  ReplayConfig           config_;
+  TimePoint_t            replayStart_;
+  Duration_t             firstOffset_{};
+  detail_::CaptureRecord next_;
+  bool                   hasNext_ = false;
+
+  std::atomic<bool> finished_{false};
+  std::atomic<U64>  replayed_{0};
+  std::atomic<U64>  skipped_{0};
+};
+
+}  // namespace mgfw
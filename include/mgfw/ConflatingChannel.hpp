@@ -0,0 +1,192 @@
+#pragma once
+
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/SyncCell.hpp"
+#include "mgfw/defer.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mgfw {
+
+template<typename KeyFn_t, typename T>
+using MessageKey_t = std::remove_cvref_t<std::invoke_result_t<const KeyFn_t &, const T &>>;
+
+/**
+ * Stateless functor that maps a message to the key it is conflated on
+ */
+template<typename KeyFn_t, typename T>
+concept MessageKeyExtractor = std::default_initializable<KeyFn_t>
+                           && std::invocable<const KeyFn_t &, const T &>
+                           && std::equality_comparable<MessageKey_t<KeyFn_t, T>>
+                           && requires(const MessageKey_t<KeyFn_t, T> &key) {
+                                { std::hash<MessageKey_t<KeyFn_t, T>>{}(key) }
+                                  -> std::convertible_to<std::size_t>;
+                              };
+
+/**
+ * Keyed channel that only keeps the latest value per key.
+ *
+ * A write overwrites whatever value is still pending for its message's key, and a drain yields
+ * each key that was updated since the previous drain exactly once, with its newest value, in the
+ * order the keys were first updated. The amount of pending data is thus bounded by the number of
+ * keys rather than by the update rate, which suits state updates (positions, quotes, ...) where
+ * intermediate values don't matter.
+ *
+ * Pending values sit behind a mutex. Draining swaps them for a second set of buffers, so callbacks
+ * run without holding up writers. Every key keeps its slot in both buffers once it has been seen,
+ * and slots are reset rather than freed after a drain, so once the set of keys stops growing,
+ * publishing and draining don't allocate (beyond what assigning a T itself does). Keys are only
+ * copied the first time they're seen.
+ */
+template<MessageType T, MessageKeyExtractor<T> KeyFn_t>
+class ConflatingChannel {
+public:
+  using Key_t = MessageKey_t<KeyFn_t, T>;
+
+  ConflatingChannel() = default;
+
+  ConflatingChannel(const ConflatingChannel &)            = delete;
+  ConflatingChannel &operator=(const ConflatingChannel &) = delete;
+  ConflatingChannel(ConflatingChannel &&)                 = delete;
+  ConflatingChannel &operator=(ConflatingChannel &&)      = delete;
+  ~ConflatingChannel()                                    = default;
+
+  /**
+   * Number of keys with a value waiting to be drained
+   */
+  std::size_t pending_keys() { return pendingCell_.get_locked()->buffer.order.size(); }
+
+  void publish(const T &message) { publish_(message); }
+
+  void publish(T &&message) { publish_(std::move(message)); }
+
+  /**
+   * Invoke a callback on the latest value of every key updated since the last drain
+   */
+  template<MessageDrainCallback<T> Callback_t>
+  void drain(const Callback_t &callback) {
+    const std::scoped_lock drainLock(drainMutex_);
+    std::swap(pendingCell_.get_locked()->buffer, drained_);
+
+    const defer resetDrained([this] { drained_.reset(); });
+    for(const std::size_t slot : drained_.order) {
+      callback(drained_.values[slot]);
+    }
+  }
+
+private:
+  // Values and pending flags by slot, plus the pending slots in first-update order
+  struct Buffer_ {
+    // Values stay put, so their storage gets reused by the next update of the same key
+    void reset() {
+      for(const std::size_t slot : order) {
+        pending[slot] = false;
+      }
+      order.clear();
+    }
+
+    std::vector<T>           values;
+    std::vector<bool>        pending;
+    std::vector<std::size_t> order;
+  };
+
+  struct Pending_ {
+    // Slot of every key seen so far; keys are never removed
+    std::unordered_map<Key_t, std::size_t> slots;
+    Buffer_                                buffer;
+  };
+
+  template<typename U>
+  void publish_(U &&message) {
+    // Only materialise a Key_t for keys that are new
+    decltype(auto) key     = keyFn_(message);
+    auto           pending = pendingCell_.get_locked();
+
+    auto it = pending->slots.find(key);
+    if(it == pending->slots.end()) {
+      it = pending->slots
+             .emplace(Key_t(std::forward<decltype(key)>(key)), pending->slots.size())
+             .first;
+    }
+
+    const std::size_t slot   = it->second;
+    Buffer_          &buffer = pending->buffer;
+    if(slot >= buffer.values.size()) {
+      buffer.values.resize(pending->slots.size());
+      buffer.pending.resize(pending->slots.size());
+    }
+
+    buffer.values[slot] = std::forward<U>(message);
+    if(!buffer.pending[slot]) {
+      buffer.pending[slot] = true;
+      buffer.order.push_back(slot);
+    }
+  }
+
+  const KeyFn_t      keyFn_{};
+  SyncCell<Pending_> pendingCell_;
+
+  // Only touched by drain
+  std::mutex drainMutex_;
+  Buffer_    drained_;
+};
+
+/**
+ * Write-only sender end of a ConflatingChannel
+ */
+template<MessageType T, MessageKeyExtractor<T> KeyFn_t>
+class ConflatingWriter {
+public:
+  explicit ConflatingWriter(ConflatingChannel<T, KeyFn_t> &channel) : channel_(channel) { }
+
+  ConflatingWriter(const ConflatingWriter &)            = delete;
+  ConflatingWriter &operator=(const ConflatingWriter &) = delete;
+  ConflatingWriter(ConflatingWriter &&)                 = default;
+  ConflatingWriter &operator=(ConflatingWriter &&)      = default;
+  ~ConflatingWriter()                                   = default;
+
+  void write(const T &message) { channel_.publish(message); }
+
+  void write(T &&message) { channel_.publish(std::move(message)); }
+
+  template<typename... Args>
+  requires std::constructible_from<T, Args...>
+  void emplace(Args &&...args) {
+    channel_.publish(T{std::forward<Args>(args)...});
+  }
+
+private:
+  ConflatingChannel<T, KeyFn_t> &channel_;
+};
+
+/**
+ * Read-only receiver end of a ConflatingChannel
+ */
+template<MessageType T, MessageKeyExtractor<T> KeyFn_t>
+class ConflatingReader {
+public:
+  explicit ConflatingReader(ConflatingChannel<T, KeyFn_t> &channel) : channel_(channel) { }
+
+  ConflatingReader(const ConflatingReader &)            = delete;
+  ConflatingReader &operator=(const ConflatingReader &) = delete;
+  ConflatingReader(ConflatingReader &&)                 = default;
+  ConflatingReader &operator=(ConflatingReader &&)      = default;
+  ~ConflatingReader()                                   = default;
+
+  template<MessageDrainCallback<T> Callback>
+  void drain(Callback &&callback) {
+    channel_.drain(std::forward<Callback>(callback));
+  }
+
+private:
+  ConflatingChannel<T, KeyFn_t> &channel_;
+};
+
+}  // namespace mgfw
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <utility>
+
+namespace mgfw {
+
+/**
+ * Something that runs jobs on its own thread(s) soon after they're handed over, like a Scheduler.
+ * Awaitables use an executor to resume their coroutine once they have something for it.
+ */
+template<typename T>
+concept Executor = requires(T &executor, std::function<void()> job) {
+  executor.do_now(std::move(job));
+};
+
+/**
+ * Return type for fire-and-forget coroutines. The coroutine starts running right away and frees
+ * itself once it finishes; an exception escaping it terminates the program.
+ */
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() noexcept { return {}; }
+
+    std::suspend_never initial_suspend() noexcept { return {}; }
+
+    std::suspend_never final_suspend() noexcept { return {}; }
+
+    void return_void() noexcept { }
+
+    [[noreturn]] void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+}  // namespace mgfw
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "mgfw/MessageQueue.hpp"
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace mgfw {
+
+/**
+ * Overload set built from several lambdas, e.g. for dispatch()
+ */
+template<typename... Fns_t>
+struct Overloaded : Fns_t... {
+  using Fns_t::operator()...;
+};
+
+namespace detail_ {
+  template<typename T>
+  inline constexpr bool is_variant_ = false;
+
+  template<typename... Ts>
+  inline constexpr bool is_variant_<std::variant<Ts...>> = true;
+
+  template<typename Visitor_t, typename Variant_t, typename Indices_t>
+  inline constexpr bool visits_all_ = false;
+
+  template<typename Visitor_t, typename Variant_t, std::size_t... is>
+  inline constexpr bool visits_all_<Visitor_t, Variant_t, std::index_sequence<is...>> =
+    (std::invocable<Visitor_t &, const std::variant_alternative_t<is, Variant_t> &> && ...);
+
+  template<typename Variant_t, typename Visitor_t, std::size_t i>
+  void dispatch_one_(Visitor_t &visitor, const Variant_t &message) {
+    visitor(*std::get_if<i>(&message));
+  }
+
+  template<typename Variant_t, typename Visitor_t, typename Indices_t>
+  struct DispatchTable_;
+
+  // One entry per alternative, indexed by variant::index()
+  template<typename Variant_t, typename Visitor_t, std::size_t... is>
+  struct DispatchTable_<Variant_t, Visitor_t, std::index_sequence<is...>> {
+    static constexpr std::array<void (*)(Visitor_t &, const Variant_t &), sizeof...(is)> ENTRIES{
+      &dispatch_one_<Variant_t, Visitor_t, is>...};
+  };
+}  // namespace detail_
+
+/**
+ * A std::variant used as the message type of a MessageQueue, so that a single queue carries several
+ * kinds of message in the order they were written
+ */
+template<typename T>
+concept VariantMessage = MessageType<T> && detail_::is_variant_<T>;
+
+/**
+ * Visitor that handles every alternative of Variant_t
+ */
+template<typename Visitor_t, typename Variant_t>
+concept VariantVisitor =
+  VariantMessage<Variant_t>
+  && detail_::visits_all_<Visitor_t,
+                          Variant_t,
+                          std::make_index_sequence<std::variant_size_v<Variant_t>>>;
+
+/**
+ * Call `visitor` with the alternative held by `message`, through a table of function pointers built
+ * at compile time. Does nothing if the variant is valueless.
+ */
+template<VariantMessage Variant_t, VariantVisitor<Variant_t> Visitor_t>
+void dispatch(const Variant_t &message, Visitor_t &visitor) {
+  using Table_t = detail_::DispatchTable_<Variant_t,
+                                          Visitor_t,
+                                          std::make_index_sequence<std::variant_size_v<Variant_t>>>;
+
+  const std::size_t index = message.index();
+  if(index != std::variant_npos) {
+    Table_t::ENTRIES[index](visitor, message);
+  }
+}
+
+}  // namespace mgfw
@@ -1,16 +1,48 @@
 #pragma once
 
+#include "mgfw/Coroutine.hpp"
+#include "mgfw/Dispatch.hpp"
+#include "mgfw/Expiring.hpp"
+#include "mgfw/IClock.hpp"
 #include "mgfw/MessageQueue.hpp"
+#include "mgfw/types.hpp"
+
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace mgfw {
 
 /**
- * Read-only receiver end of a MessageQueue
+ * Read-only receiver end of a MessageQueue.
+ *
+ * Each reader owns a consumer token for its queue, so a given reader must not be drained from more
+ * than one thread at a time; use one reader per consuming thread instead.
+ *
+ * Coroutines can `co_await` next() or next_batch() instead of polling. These take messages right
+ * away if there are any; otherwise the coroutine is suspended until a message arrives, and then
+ * resumed on the given Executor (e.g. a Scheduler). A reader must only have one such await pending
+ * at a time, and both the reader and the executor must outlive it. Destroying a coroutine while it
+ * is suspended in such an await cancels it, leaving later messages in the queue; do so from the
+ * executor's thread, so that it can't race with the coroutine being resumed.
  */
 template<MessageType T>
 class EventReader {
+  template<Executor Executor_t, typename Result_t>
+  class Awaitable_;
+
 public:
-  explicit EventReader(MessageQueue<T> &queue) : queue_(queue) { }
+  static constexpr std::size_t DEFAULT_MAX_BATCH = 256;
+
+  explicit EventReader(MessageQueue<T> &queue)
+    : queue_(queue), token_(queue.make_consumer_token()) { }
 
   EventReader(const EventReader &)            = delete;
   EventReader &operator=(const EventReader &) = delete;
@@ -20,11 +52,226 @@ public:
 
   template<MessageDrainCallback<T> Callback>
   void drain(Callback &&callback) {
-    queue_.drain(std::forward<Callback>(callback));
+    queue_.drain(token_, std::forward<Callback>(callback));
+  }
+
+  /**
+   * For queues of Expiring messages: drain the queue, but only pass on the messages whose deadline
+   * hasn't passed yet. The clock is read once per call, so messages that expire during a long drain
+   * still get through. Skipped messages are counted in expired().
+   */
+  template<typename Callback, ExpiringMessage U = T>
+  requires MessageDrainCallback<Callback, typename U::Message_t>
+  void drain(const IClock &clock, Callback &&callback) {
+    const TimePoint_t now     = clock.now();
+    U64               skipped = 0;
+    queue_.drain(token_, [&](const T &entry) {
+      if(entry.expired(now)) {
+        ++skipped;
+      }
+      else {
+        callback(entry.message);
+      }
+    });
+    expired_ += skipped;
+  }
+
+  /**
+   * For queues of std::variant messages: drain the queue, passing each message to whichever of
+   * `handlers` takes its alternative, e.g.
+   *
+   *   reader.dispatch([](const Tick &tick) { ... }, [](const Fill &fill) { ... });
+   *
+   * Every alternative needs a handler, which is checked at compile time. Messages are handled in
+   * queue order whatever their kind.
+   */
+  template<typename... Handlers_t>
+  requires VariantMessage<T> && VariantVisitor<Overloaded<std::decay_t<Handlers_t>...>, T>
+  void dispatch(Handlers_t &&...handlers) {
+    Overloaded<std::decay_t<Handlers_t>...> visitor{std::forward<Handlers_t>(handlers)...};
+    queue_.drain(token_, [&](const T &message) { mgfw::dispatch(message, visitor); });
+  }
+
+  /**
+   * Number of expired messages skipped by this reader so far
+   */
+  U64 expired() const { return expired_; }
+
+  std::size_t size_approx() const { return queue_.size_approx(); }
+
+  /**
+   * Block until messages are available or the timeout passes; see MessageQueue::wait_for_any.
+   */
+  bool wait_for_any(const Duration_t timeout) { return queue_.wait_for_any(timeout); }
+
+  /**
+   * Get called back once messages are available; see MessageQueue::notify_when_any.
+   */
+  void notify_when_any(std::function<void()> callback) {
+    queue_.notify_when_any(std::move(callback));
+  }
+
+  /**
+   * Wait up to `timeout` for messages to arrive, then drain the queue. Returns whether there were
+   * messages available.
+   */
+  template<MessageDrainCallback<T> Callback>
+  bool wait_and_drain(const Duration_t timeout, Callback &&callback) {
+    if(!queue_.wait_for_any(timeout)) {
+      return false;
+    }
+
+    drain(std::forward<Callback>(callback));
+    return true;
+  }
+
+  /**
+   * Drain the queue in batches of up to `maxBatch` messages. The batch buffer is owned by the
+   * reader and reused across calls, so steady-state draining does not allocate.
+   */
+  template<MessageBulkDrainCallback<T> Callback>
+  void drain_bulk(Callback &&callback, const std::size_t maxBatch = DEFAULT_MAX_BATCH) {
+    if(batchBuffer_.size() < maxBatch) {
+      batchBuffer_.resize(maxBatch);
+    }
+
+    queue_.drain_bulk(
+      token_, std::span<T>(batchBuffer_.data(), maxBatch), std::forward<Callback>(callback));
+  }
+
+  /**
+   * Access the oldest message in place, then remove it with release(); see MessageQueue::peek.
+   */
+  T *peek() { return queue_.peek(token_); }
+
+  void release() { queue_.release(token_); }
+
+  /**
+   * Move up to `maxCount` messages out of the queue onto the end of `out`, highest lanes first.
+   * Returns how many were taken.
+   */
+  std::size_t take_bulk(std::vector<T> &out, const std::size_t maxCount) {
+    std::size_t taken = 0;
+    for(; taken < maxCount; ++taken) {
+      T *message = peek();
+      if(message == nullptr) {
+        break;
+      }
+
+      out.push_back(std::move(*message));
+      release();
+    }
+    return taken;
+  }
+
+  /**
+   * Awaitable yielding the next message, which it moves out of the queue
+   */
+  template<Executor Executor_t>
+  [[nodiscard]] Awaitable_<Executor_t, std::optional<T>> next(Executor_t &executor) {
+    return {*this, executor, 1};
+  }
+
+  /**
+   * Awaitable yielding between 1 and `maxCount` (which must be positive) messages, as many as are
+   * queued when it resumes
+   */
+  template<Executor Executor_t>
+  [[nodiscard]] Awaitable_<Executor_t, std::vector<T>> next_batch(Executor_t       &executor,
+                                                                  const std::size_t maxCount) {
+    assert(maxCount > 0);
+    return {*this, executor, maxCount};
   }
 
 private:
-  MessageQueue<T> &queue_;
+  template<Executor Executor_t, typename Result_t>
+  class Awaitable_ {
+  public:
+    Awaitable_(EventReader &reader, Executor_t &executor, const std::size_t maxCount)
+      : reader_(reader), executor_(executor), maxCount_(maxCount) { }
+
+    bool await_ready() { return reader_.take_(result_, maxCount_); }
+
+    void await_suspend(const std::coroutine_handle<> handle) {
+      parked_ = std::make_shared<Parked_>(reader_, executor_, maxCount_, handle);
+      park_(parked_);
+    }
+
+    auto await_resume() {
+      Result_t &result = parked_ ? parked_->result : result_;
+      if constexpr(std::is_same_v<Result_t, std::optional<T>>) {
+        return std::move(*result);
+      }
+      else {
+        return std::move(result);
+      }
+    }
+
+  private:
+    // What the callbacks need while the coroutine is suspended. They only hold weak references, so
+    // destroying the suspended coroutine (and with it this awaitable) turns them into no-ops.
+    struct Parked_ {
+      Parked_(EventReader                  &eventReader,
+              Executor_t                   &jobExecutor,
+              const std::size_t             count,
+              const std::coroutine_handle<> coroutine)
+        : reader(eventReader), executor(jobExecutor), maxCount(count), handle(coroutine) { }
+
+      EventReader            &reader;
+      Executor_t             &executor;
+      const std::size_t       maxCount;
+      std::coroutine_handle<> handle;
+      Result_t                result{};
+    };
+
+    static void park_(const std::shared_ptr<Parked_> &parked) {
+      // The queue calls back on whichever thread spots a message, so hop onto the executor before
+      // touching the reader. Another consumer may beat us to it, in which case we park again.
+      parked->reader.queue_.notify_when_any([weakParked = std::weak_ptr(parked)] {
+        if(const auto notified = weakParked.lock()) {
+          notified->executor.do_now([weakParked] {
+            const auto current = weakParked.lock();
+            if(!current) {
+              return;
+            }
+
+            if(current->reader.take_(current->result, current->maxCount)) {
+              current->handle.resume();
+            }
+            else {
+              park_(current);
+            }
+          });
+        }
+      });
+    }
+
+    EventReader             &reader_;
+    Executor_t              &executor_;
+    const std::size_t        maxCount_;
+    Result_t                 result_;
+    std::shared_ptr<Parked_> parked_;
+  };
+
+  bool take_(std::optional<T> &out, [[maybe_unused]] const std::size_t maxCount) {
+    T *message = peek();
+    if(message == nullptr) {
+      return false;
+    }
+
+    out.emplace(std::move(*message));
+    release();
+    return true;
+  }
+
+  bool take_(std::vector<T> &out, const std::size_t maxCount) {
+    return take_bulk(out, maxCount - out.size()) > 0;
+  }
+
+  MessageQueue<T>                           &queue_;
+  typename MessageQueue<T>::ConsumerToken_t token_;
+  std::vector<T>                            batchBuffer_;
+  U64                                       expired_ = 0;
 };
 
 }  // namespace mgfw
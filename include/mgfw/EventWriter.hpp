@@ -1,18 +1,29 @@
 #pragma once
 
+#include "mgfw/Expiring.hpp"
+#include "mgfw/IClock.hpp"
 #include "mgfw/MessageQueue.hpp"
+#include "mgfw/types.hpp"
 
 #include <concepts>
+#include <cstddef>
+#include <initializer_list>
+#include <ranges>
+#include <utility>
 
 namespace mgfw {
 
 /**
- * Write-only sender end of a MessageQueue
+ * Write-only sender end of a MessageQueue.
+ *
+ * Each writer owns a producer token for its queue, so a given writer must not be written to from
+ * more than one thread at a time; use one writer per producing thread instead.
  */
 template<MessageType T>
 class EventWriter {
 public:
-  explicit EventWriter(MessageQueue<T> &queue) : queue_(queue) { }
+  explicit EventWriter(MessageQueue<T> &queue)
+    : queue_(queue), token_(queue.make_producer_token()) { }
 
   EventWriter(const EventWriter &)            = delete;
   EventWriter &operator=(const EventWriter &) = delete;
@@ -20,20 +31,66 @@ public:
   EventWriter &operator=(EventWriter &&)      = default;
   ~EventWriter()                              = default;
 
-  void write(const T &message) { queue_.enqueue(message); }
+  /**
+   * The write functions report whether the message(s) made it into the queue, which only fails for
+   * bounded queues; see MessageQueue and OverflowPolicy. The priority picks the queue's lane; see
+   * QueueConfig::lanes.
+   */
+  bool write(const T &message, const Priority priority = Priority::Normal) {
+    return queue_.enqueue(token_, message, priority);
+  }
+
+  bool write(T &&message, const Priority priority = Priority::Normal) {
+    return queue_.enqueue(token_, std::move(message), priority);
+  }
+
+  /**
+   * For queues of Expiring messages: write a message that readers should skip if they only get to
+   * it after `deadline`, or after `ttl` from now according to `clock`
+   */
+  template<ExpiringMessage U = T>
+  bool write(typename U::Message_t message,
+             const TimePoint_t     deadline,
+             const Priority        priority = Priority::Normal) {
+    return write(T{.message = std::move(message), .deadline = deadline}, priority);
+  }
 
-  void write(const T &&message) { queue_.enqueue(std::move(message)); }
+  template<ExpiringMessage U = T>
+  bool write(typename U::Message_t message,
+             const Duration_t      ttl,
+             const IClock         &clock,
+             const Priority        priority = Priority::Normal) {
+    return write(std::move(message), clock.now() + ttl, priority);
+  }
 
-  void write_bulk(const std::vector<T> &messages) { queue_.enqueue_bulk(messages); }
+  /**
+   * Write any sized range of messages; see MessageQueue::enqueue_bulk for when they are moved
+   */
+  template<std::ranges::sized_range Range_t = std::initializer_list<T>>
+  requires std::constructible_from<T, std::ranges::range_reference_t<Range_t>>
+  std::size_t write_bulk(Range_t &&messages, const Priority priority = Priority::Normal) {
+    return queue_.enqueue_bulk(token_, std::forward<Range_t>(messages), priority);
+  }
 
   template<typename... Args>
   requires std::constructible_from<T, Args...>
-  void emplace(Args &&...args) {
-    queue_.emplace(std::forward<Args>(args)...);
+  bool emplace(Args &&...args) {
+    return queue_.emplace(token_, std::forward<Args>(args)...);
   }
 
+  /**
+   * Build the next message directly in queue storage, then publish it with commit(); see
+   * MessageQueue::reserve.
+   */
+  T &reserve(const Priority priority = Priority::Normal) {
+    return queue_.reserve(token_, priority);
+  }
+
+  bool commit() { return queue_.commit(token_); }
+
 private:
-  MessageQueue<T> &queue_;
+  MessageQueue<T>                           &queue_;
+  typename MessageQueue<T>::ProducerToken_t token_;
 };
 
 }  // namespace mgfw
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/types.hpp"
+
+namespace mgfw {
+
+/**
+ * Message that stops being worth processing after a deadline, e.g. a market tick that has since
+ * been superseded. Use it as the message type of a MessageQueue; EventWriter and EventReader then
+ * offer overloads to stamp the deadline and to skip expired messages while draining.
+ */
+template<MessageType T>
+struct Expiring {
+  using Message_t = T;
+
+  T           message{};
+  TimePoint_t deadline = TimePoint_t::max();
+
+  bool expired(const TimePoint_t now) const noexcept { return deadline < now; }
+};
+
+namespace detail_ {
+  template<typename T>
+  inline constexpr bool is_expiring_ = false;
+
+  template<MessageType T>
+  inline constexpr bool is_expiring_<Expiring<T>> = true;
+}  // namespace detail_
+
+template<typename T>
+concept ExpiringMessage = detail_::is_expiring_<T>;
+
+}  // namespace mgfw
@@ -0,0 +1,380 @@
+#pragma once
+
+#include "mgfw/ILogger.hpp"
+#include "mgfw/JournalConfig.hpp"
+#include "mgfw/MappedFile.hpp"
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/TypeHash.hpp"
+#include "mgfw/TypeString.hpp"
+#include "mgfw/types.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mgfw {
+
+namespace detail_ {
+  /**
+   * Start of every journal segment file. The counters are only accessed through std::atomic_ref.
+   */
+  struct JournalHeader {
+    static constexpr U64 MAGIC = 0x4c4e'524a'5746'474d;  // "MGFWJRNL"
+
+    U64 magic;
+    U32 typeHash;
+    U32 recordSize;
+    U64 capacity;
+
+    // Messages written to the segment so far
+    alignas(CACHE_LINE_SIZE) U64 written;
+
+    // Messages the reader has finished processing
+    alignas(CACHE_LINE_SIZE) U64 consumed;
+  };
+}  // namespace detail_
+
+/**
+ * Channel for trivially copyable messages that persists everything written to it, so that
+ * messages still in flight survive a crash.
+ *
+ * Messages are memcpy'd into append-only, memory-mapped segment files of `segmentCapacity`
+ * messages each. Each segment's header holds the number of messages written and the reader's
+ * committed offset, both of which are updated after the fact, so a torn write is simply never
+ * seen. A message is committed once the callback it was handed to returns, which makes delivery
+ * at-least-once: a message whose callback was cut short is delivered again after a restart.
+ *
+ * Since the mapping is shared, writes reach the page cache immediately and survive a process crash
+ * without any syscalls; syncEvery (or calling sync()) batches the flushes needed to also survive an
+ * OS crash or power loss. Fully consumed segments are deleted.
+ *
+ * Any number of threads may write, and drains are serialized.
+ */
+template<JournalMessage T>
+class JournalChannel {
+public:
+  JournalChannel(ILogger &logger, const U64 id, JournalConfig config)
+    : logger_(logger), id_(id), config_(std::move(config)) {
+    std::filesystem::create_directories(config_.directory);
+
+    std::optional<U64>                 first;
+    std::optional<U64>                 last;
+    std::vector<std::filesystem::path> stale;
+    for(const auto &entry : std::filesystem::directory_iterator(config_.directory)) {
+      const std::string name = entry.path().filename().string();
+      if(const auto index = parse_segment_index_(name)) {
+        first = std::min(first.value_or(*index), *index);
+        last  = std::max(last.value_or(*index), *index);
+      }
+      else if(is_unpublished_segment_(name)) {
+        stale.push_back(entry.path());
+      }
+    }
+
+    // Left behind by a crash in the middle of publish_segment_(); never seen by anyone
+    for(const auto &path : stale) {
+      logger_.info(
+        std::format("JournalChannel {} removing unpublished segment {}", id_, path.string()));
+      std::filesystem::remove(path);
+    }
+
+    if(!first) {
+      publish_segment_(0);
+      first = last = 0;
+    }
+
+    readSegment_.emplace(open_segment_(*first));
+    writeSegment_.emplace(open_segment_(*last));
+    syncedUpTo_ = writeSegment_->written().load(std::memory_order::relaxed);
+
+    const U64 consumed = readSegment_->consumed().load(std::memory_order::relaxed);
+    if(*first != *last || consumed < syncedUpTo_) {
+      logger_.info(
+        std::format("JournalChannel {} resuming with unconsumed messages in segments {} to {}",
+                    id_,
+                    *first,
+                    *last));
+    }
+  }
+
+  JournalChannel(const JournalChannel &)            = delete;
+  JournalChannel &operator=(const JournalChannel &) = delete;
+  JournalChannel(JournalChannel &&)                 = delete;
+  JournalChannel &operator=(JournalChannel &&)      = delete;
+
+  ~JournalChannel() {
+    try {
+      sync();
+    }
+    catch(const std::exception &e) {
+      logger_.error(std::format("JournalChannel {} failed to sync on shutdown: {}", id_, e.what()));
+    }
+  }
+
+  void publish(const T &message) {
+    const std::scoped_lock writeLock(writeMutex_);
+
+    U64 written = writeSegment_->written().load(std::memory_order::relaxed);
+    if(written == writeSegment_->capacity()) {
+      roll_write_segment_();
+      written = 0;
+    }
+
+    std::memcpy(writeSegment_->record(written), &message, sizeof(T));
+    writeSegment_->written().store(written + 1, std::memory_order::release);
+
+    if(config_.syncEvery > 0 && written + 1 - syncedUpTo_ >= config_.syncEvery) {
+      flush_written_();
+    }
+  }
+
+  /**
+   * Invoke a callback on each message not yet consumed, committing each one after its callback
+   * returns
+   */
+  template<MessageDrainCallback<T> Callback_t>
+  void drain(const Callback_t &callback) {
+    const std::scoped_lock drainLock(drainMutex_);
+
+    while(true) {
+      Segment_ &segment  = *readSegment_;
+      U64       consumed = segment.consumed().load(std::memory_order::relaxed);
+      const U64 written  = segment.written().load(std::memory_order::acquire);
+
+      for(; consumed < written; ++consumed) {
+        T message;
+        std::memcpy(&message, segment.record(consumed), sizeof(T));
+        callback(message);
+        segment.consumed().store(consumed + 1, std::memory_order::release);
+      }
+
+      if(written < segment.capacity() || !advance_read_segment_()) {
+        break;
+      }
+    }
+  }
+
+  /**
+   * Flush everything written and consumed so far to storage
+   */
+  void sync() {
+    {
+      const std::scoped_lock writeLock(writeMutex_);
+      flush_written_();
+    }
+
+    const std::scoped_lock drainLock(drainMutex_);
+    readSegment_->file.sync(0, sizeof(detail_::JournalHeader));
+  }
+
+private:
+  static constexpr std::size_t RECORDS_OFFSET = sizeof(detail_::JournalHeader);
+
+  struct Segment_ {
+    detail_::JournalHeader &header() const {
+      return *reinterpret_cast<detail_::JournalHeader *>(file.bytes().data());
+    }
+
+    U64 capacity() const { return header().capacity; }
+
+    std::atomic_ref<U64> written() const { return std::atomic_ref<U64>(header().written); }
+
+    std::atomic_ref<U64> consumed() const { return std::atomic_ref<U64>(header().consumed); }
+
+    std::byte *record(const U64 i) const {
+      return file.bytes().data() + RECORDS_OFFSET + i * sizeof(T);
+    }
+
+    U64        index;
+    MappedFile file;
+  };
+
+  std::filesystem::path segment_path_(const U64 index) const {
+    return config_.directory / std::format("{}.{:010}.journal", id_, index);
+  }
+
+  /**
+   * Segment index from a file name, if it is one of our segments
+   */
+  std::optional<U64> parse_segment_index_(std::string_view name) const {
+    const std::string      prefix = std::format("{}.", id_);
+    const std::string_view suffix = ".journal";
+    if(!name.starts_with(prefix) || !name.ends_with(suffix)) {
+      return std::nullopt;
+    }
+
+    name.remove_prefix(prefix.size());
+    name.remove_suffix(suffix.size());
+
+    U64 index = 0;
+    const auto [end, ec] = std::from_chars(name.data(), name.data() + name.size(), index);
+    if(ec != std::errc() || end != name.data() + name.size()) {
+      return std::nullopt;
+    }
+    return index;
+  }
+
+  bool is_unpublished_segment_(std::string_view name) const {
+    const std::string_view suffix = ".tmp";
+    if(!name.ends_with(suffix)) {
+      return false;
+    }
+    name.remove_suffix(suffix.size());
+    return parse_segment_index_(name).has_value();
+  }
+
+  /**
+   * Create an empty segment. It is set up under a temporary name and then renamed, so that readers
+   * never see a half-initialized segment.
+   */
+  void publish_segment_(const U64 index) const {
+    const std::filesystem::path path = segment_path_(index);
+    std::filesystem::path       tmp  = path;
+    tmp += ".tmp";
+
+    {
+      const MappedFile file =
+        MappedFile::create(tmp, RECORDS_OFFSET + config_.segmentCapacity * sizeof(T));
+      auto &header      = *reinterpret_cast<detail_::JournalHeader *>(file.bytes().data());
+      header.magic      = detail_::JournalHeader::MAGIC;
+      header.typeHash   = TypeHash<T>;
+      header.recordSize = sizeof(T);
+      header.capacity   = config_.segmentCapacity;
+      file.sync();
+    }
+
+    std::filesystem::rename(tmp, path);
+  }
+
+  Segment_ open_segment_(const U64 index) const {
+    Segment_ segment{.index = index, .file = MappedFile::open(segment_path_(index))};
+
+    const std::size_t size = segment.file.bytes().size();
+    if(size < RECORDS_OFFSET || segment.header().magic != detail_::JournalHeader::MAGIC
+       || size != RECORDS_OFFSET + segment.capacity() * sizeof(T))
+    {
+      throw std::runtime_error(
+        std::format("JournalChannel {}: {} is not a valid journal segment",
+                    id_,
+                    segment.file.path().string()));
+    }
+
+    if(segment.header().typeHash != TypeHash<T> || segment.header().recordSize != sizeof(T)) {
+      throw std::runtime_error(
+        std::format("Type mismatch on JournalChannel {} (segment = {}, currentType = {})",
+                    id_,
+                    segment.file.path().string(),
+                    TypeString<T>));
+    }
+
+    return segment;
+  }
+
+  void roll_write_segment_() {
+    flush_written_();
+
+    const U64 next = writeSegment_->index + 1;
+    publish_segment_(next);
+    writeSegment_.emplace(open_segment_(next));
+    syncedUpTo_ = 0;
+  }
+
+  /**
+   * Move the reader on to the next segment, if the writer has created it, and delete the one it
+   * just finished
+   */
+  bool advance_read_segment_() {
+    const U64 next = readSegment_->index + 1;
+    if(!std::filesystem::exists(segment_path_(next))) {
+      return false;
+    }
+
+    const std::filesystem::path finished = readSegment_->file.path();
+    readSegment_.emplace(open_segment_(next));
+    std::filesystem::remove(finished);
+    return true;
+  }
+
+  void flush_written_() {
+    const U64 written = writeSegment_->written().load(std::memory_order::relaxed);
+    if(written == syncedUpTo_) {
+      return;
+    }
+
+    writeSegment_->file.sync(RECORDS_OFFSET + syncedUpTo_ * sizeof(T),
+                             (written - syncedUpTo_) * sizeof(T));
+    writeSegment_->file.sync(0, sizeof(detail_::JournalHeader));
+    syncedUpTo_ = written;
+  }
+
+  ILogger            &logger_;
+  const U64           id_;
+  const JournalConfig config_;
+
+  // Writer state
+  std::mutex              writeMutex_;
+  std::optional<Segment_> writeSegment_;
+  U64                     syncedUpTo_ = 0;
+
+  // Reader state
+  std::mutex              drainMutex_;
+  std::optional<Segment_> readSegment_;
+};
+
+/**
+ * Write-only sender end of a JournalChannel
+ */
+template<JournalMessage T>
+class JournalWriter {
+public:
+  explicit JournalWriter(JournalChannel<T> &channel) : channel_(channel) { }
+
+  JournalWriter(const JournalWriter &)            = delete;
+  JournalWriter &operator=(const JournalWriter &) = delete;
+  JournalWriter(JournalWriter &&)                 = default;
+  JournalWriter &operator=(JournalWriter &&)      = default;
+  ~JournalWriter()                                = default;
+
+  void write(const T &message) { channel_.publish(message); }
+
+private:
+  JournalChannel<T> &channel_;
+};
+
+/**
+ * Read-only receiver end of a JournalChannel
+ */
+template<JournalMessage T>
+class JournalReader {
+public:
+  explicit JournalReader(JournalChannel<T> &channel) : channel_(channel) { }
+
+  JournalReader(const JournalReader &)            = delete;
+  JournalReader &operator=(const JournalReader &) = delete;
+  JournalReader(JournalReader &&)                 = default;
+  JournalReader &operator=(JournalReader &&)      = default;
+  ~JournalReader()                                = default;
+
+  template<MessageDrainCallback<T> Callback>
+  void drain(Callback &&callback) {
+    channel_.drain(std::forward<Callback>(callback));
+  }
+
+private:
+  JournalChannel<T> &channel_;
+};
+
+}  // namespace mgfw
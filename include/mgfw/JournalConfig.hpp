@@ -0,0 +1,30 @@
+#pragma once
+
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/types.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <type_traits>
+
+namespace mgfw {
+
+template<typename T>
+concept JournalMessage =
+  MessageType<T> && std::is_trivially_copyable_v<T> && alignof(T) <= CACHE_LINE_SIZE;
+
+/**
+ * Creation-time options for a JournalChannel.
+ */
+struct JournalConfig {
+  // Where the segment files live; created if needed
+  std::filesystem::path directory;
+
+  // Messages per segment file. Only applies to new segments; existing ones keep their size.
+  std::size_t segmentCapacity = 64 * 1024;
+
+  // Flush written messages to storage after every N writes; 0 leaves flushing to sync() and the OS
+  U32 syncEvery = 0;
+};
+
+}  // namespace mgfw
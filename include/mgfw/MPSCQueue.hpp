@@ -0,0 +1,364 @@
+#pragma once
+
+#include "mgfw/types.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <format>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace mgfw {
+
+/**
+ * Unbounded multi-producer/single-consumer queue, based on Dmitry Vyukov's node-based MPSC queue.
+ *
+ * Each message lives in a node that embeds its own link. Producers publish with a single atomic
+ * exchange on the head and never contend with the consumer, which simply follows the links from the
+ * tail. A producer that has been preempted between the exchange and linking its node makes the
+ * messages behind it invisible until it resumes; dequeues during that window return false, the same
+ * as if the queue were empty.
+ *
+ * Nodes come from a pool owned by the queue rather than from the heap. It is carved out of chunks
+ * that double in size as the queue grows (64, 128, 256, ... nodes) and keeps them until the queue
+ * is destroyed, so memory stays at its high-water mark. Free nodes sit on a lock-free stack whose
+ * head is tagged with a counter, like SlabPool's; only growing the pool takes a lock. A message
+ * lives in its node from enqueue until it is dequeued, after which the node goes back on the stack.
+ *
+ * The API mirrors the subset of moodycamel::ConcurrentQueue used by MessageQueue, plus two-phase
+ * reserve/commit and peek/pop operations that work directly on nodes. Only one thread may dequeue
+ * at any given time.
+ */
+template<typename T>
+class MPSCQueue {
+  struct Node_;
+
+public:
+  static constexpr std::size_t FIRST_CHUNK_NODES = 64;
+  static constexpr std::size_t MAX_CHUNKS        = 25;
+
+  /**
+   * A message under construction in its own (not yet linked) node. Owns the node until it is passed
+   * to commit(), and hands it back to the queue's pool otherwise, so it must not outlive the queue.
+   */
+  class Reservation {
+  public:
+    ~Reservation() { reset_(); }
+
+    Reservation(const Reservation &)            = delete;
+    Reservation &operator=(const Reservation &) = delete;
+
+    Reservation(Reservation &&other) noexcept
+      : queue_(other.queue_), node_(std::exchange(other.node_, nullptr)) { }
+
+    Reservation &operator=(Reservation &&other) noexcept {
+      if(this != &other) {
+        reset_();
+        queue_ = other.queue_;
+        node_  = std::exchange(other.node_, nullptr);
+      }
+      return *this;
+    }
+
+    T &value() { return *node_->value(); }
+
+  private:
+    friend class MPSCQueue;
+
+    Reservation(MPSCQueue &queue, Node_ *node) : queue_(&queue), node_(node) { }
+
+    void reset_() {
+      if(node_ != nullptr) {
+        std::destroy_at(node_->value());
+        queue_->release_(std::exchange(node_, nullptr));
+      }
+    }
+
+    MPSCQueue *queue_;
+    Node_     *node_;
+  };
+
+  MPSCQueue() : head_(&stub_), tail_(&stub_) {
+    const std::scoped_lock growLock(growMutex_);
+    grow_();
+  }
+
+  ~MPSCQueue() {
+    // The tail's message has been consumed already (or it is the stub); the chunks free the nodes
+    for(Node_ *node = tail_->next.load(std::memory_order::relaxed); node != nullptr;
+        node        = node->next.load(std::memory_order::relaxed))
+    {
+      std::destroy_at(node->value());
+    }
+  }
+
+  MPSCQueue(const MPSCQueue &)            = delete;
+  MPSCQueue &operator=(const MPSCQueue &) = delete;
+  MPSCQueue(MPSCQueue &&)                 = delete;
+  MPSCQueue &operator=(MPSCQueue &&)      = delete;
+
+  bool enqueue(const T &message) {
+    Node_ *node = make_node_(message);
+    link_(node, node, 1);
+    return true;
+  }
+
+  bool enqueue(T &&message) {
+    Node_ *node = make_node_(std::move(message));
+    link_(node, node, 1);
+    return true;
+  }
+
+  /**
+   * Chain the new nodes together privately, so that the whole batch is published with one exchange
+   */
+  template<typename It_t>
+  bool enqueue_bulk(It_t first, const std::size_t count) {
+    if(count == 0) {
+      return true;
+    }
+
+    Node_ *chainFirst = make_node_(*first);
+    Node_ *chainLast  = chainFirst;
+    ++first;
+    try {
+      for(std::size_t i = 1; i < count; ++i, ++first) {
+        Node_ *node = make_node_(*first);
+        chainLast->next.store(node, std::memory_order::relaxed);
+        chainLast = node;
+      }
+    }
+    catch(...) {
+      // Nothing was published yet, so hand the chain back
+      for(Node_ *node = chainFirst; node != nullptr;) {
+        Node_ *next = node->next.load(std::memory_order::relaxed);
+        std::destroy_at(node->value());
+        release_(node);
+        node = next;
+      }
+      throw;
+    }
+
+    link_(chainFirst, chainLast, count);
+    return true;
+  }
+
+  /**
+   * Two-phase enqueue: the message is built directly in its node, which commit() then links in.
+   */
+  Reservation reserve() { return Reservation(*this, make_node_()); }
+
+  void commit(Reservation &reservation) {
+    Node_ *node = std::exchange(reservation.node_, nullptr);
+    link_(node, node, 1);
+  }
+
+  template<typename U>
+  bool try_dequeue(U &out) {
+    return try_dequeue_bulk(&out, 1) == 1;
+  }
+
+  template<typename It_t>
+  std::size_t try_dequeue_bulk(It_t out, const std::size_t max) {
+    std::size_t count = 0;
+
+    while(count < max) {
+      // The node at the tail has always been consumed already (or is the stub); its successor holds
+      // the next message.
+      Node_ *tail = tail_;
+      Node_ *next = tail->next.load(std::memory_order::acquire);
+      if(next == nullptr) {
+        break;
+      }
+
+      *out = std::move(*next->value());
+      std::destroy_at(next->value());
+      ++out;
+      ++count;
+
+      tail_ = next;
+      if(tail != &stub_) {
+        release_(tail);
+      }
+    }
+
+    if(count > 0) {
+      dequeued_.store(dequeued_.load(std::memory_order::relaxed) + count,
+                      std::memory_order::relaxed);
+    }
+
+    return count;
+  }
+
+  /**
+   * Two-phase dequeue: peek() returns the oldest visible message (or nullptr) without removing it,
+   * so it can be processed in place. pop() then removes it; it may only be called after a
+   * successful peek().
+   */
+  T *peek() {
+    Node_ *next = tail_->next.load(std::memory_order::acquire);
+    return next == nullptr ? nullptr : next->value();
+  }
+
+  void pop() {
+    Node_ *tail = tail_;
+    tail_       = tail->next.load(std::memory_order::relaxed);
+    std::destroy_at(tail_->value());
+    if(tail != &stub_) {
+      release_(tail);
+    }
+    dequeued_.store(dequeued_.load(std::memory_order::relaxed) + 1, std::memory_order::relaxed);
+  }
+
+  std::size_t size_approx() const {
+    const std::size_t dequeued = dequeued_.load(std::memory_order::relaxed);
+    const std::size_t enqueued = enqueued_.load(std::memory_order::relaxed);
+    return enqueued > dequeued ? enqueued - dequeued : 0;
+  }
+
+private:
+  static constexpr U32 NIL = std::numeric_limits<U32>::max();
+
+  // The message is only alive between make_node_() and its dequeue
+  struct Node_ {
+    std::atomic<Node_ *> next{nullptr};
+    std::atomic<U32>     nextFree{NIL};
+    U32                  index = NIL;
+
+    alignas(T) std::array<std::byte, sizeof(T)> storage;
+
+    T *value() noexcept { return std::launder(reinterpret_cast<T *>(storage.data())); }
+  };
+
+  // Chunk k holds FIRST_CHUNK_NODES << k nodes, starting at index FIRST_CHUNK_NODES * (2^k - 1)
+  static std::size_t chunk_index_of_(const U32 index) noexcept {
+    return static_cast<std::size_t>(std::bit_width((index / FIRST_CHUNK_NODES) + 1)) - 1;
+  }
+
+  static std::size_t offset_of_(const U32 index) noexcept {
+    return index - (FIRST_CHUNK_NODES * ((std::size_t{1} << chunk_index_of_(index)) - 1));
+  }
+
+  static constexpr U64 pack_(const U32 index, const U32 tag) noexcept {
+    return (static_cast<U64>(tag) << 32U) | index;
+  }
+
+  static U32 index_of_(const U64 head) noexcept { return static_cast<U32>(head); }
+
+  static U32 tag_of_(const U64 head) noexcept { return static_cast<U32>(head >> 32U); }
+
+  Node_ *node_at_(const U32 index) const noexcept {
+    return &chunks_[chunk_index_of_(index)].load(std::memory_order::acquire)[offset_of_(index)];
+  }
+
+  template<typename... Args_t>
+  Node_ *make_node_(Args_t &&...args) {
+    Node_ *node = acquire_();
+    try {
+      std::construct_at(reinterpret_cast<T *>(node->storage.data()), std::forward<Args_t>(args)...);
+    }
+    catch(...) {
+      release_(node);
+      throw;
+    }
+    return node;
+  }
+
+  Node_ *acquire_() {
+    for(;;) {
+      U64 head = freeHead_.load(std::memory_order::acquire);
+      while(index_of_(head) != NIL) {
+        Node_ *node = node_at_(index_of_(head));
+        // If the node was popped and reused meanwhile, this reads a stale link, but the tag will
+        // have changed and the exchange fails
+        const U32 next = node->nextFree.load(std::memory_order::relaxed);
+        if(freeHead_.compare_exchange_weak(head,
+                                           pack_(next, tag_of_(head) + 1),
+                                           std::memory_order::acquire,
+                                           std::memory_order::acquire))
+        {
+          node->next.store(nullptr, std::memory_order::relaxed);
+          return node;
+        }
+      }
+
+      const std::scoped_lock growLock(growMutex_);
+      // Another producer may have grown the pool in the meantime
+      if(index_of_(freeHead_.load(std::memory_order::acquire)) == NIL) {
+        grow_();
+      }
+    }
+  }
+
+  void release_(Node_ *node) { release_(node, node); }
+
+  // Push a chain of nodes already linked through nextFree, in a single atomic operation
+  void release_(Node_ *first, Node_ *last) {
+    U64 head = freeHead_.load(std::memory_order::relaxed);
+    do {
+      last->nextFree.store(index_of_(head), std::memory_order::relaxed);
+    } while(!freeHead_.compare_exchange_weak(head,
+                                             pack_(first->index, tag_of_(head) + 1),
+                                             std::memory_order::release,
+                                             std::memory_order::relaxed));
+  }
+
+  // Must hold growMutex_
+  void grow_() {
+    const std::size_t k = owned_.size();
+    if(k == MAX_CHUNKS) {
+      throw std::runtime_error(std::format("MPSCQueue is full at {} nodes",
+                                           FIRST_CHUNK_NODES * ((std::size_t{1} << k) - 1)));
+    }
+
+    const std::size_t nodes = FIRST_CHUNK_NODES << k;
+    const std::size_t first = FIRST_CHUNK_NODES * ((std::size_t{1} << k) - 1);
+
+    auto chunk = std::make_unique<Node_[]>(nodes);
+    for(std::size_t i = 0; i < nodes; ++i) {
+      chunk[i].index = static_cast<U32>(first + i);
+      if(i + 1 < nodes) {
+        chunk[i].nextFree.store(static_cast<U32>(first + i + 1), std::memory_order::relaxed);
+      }
+    }
+
+    chunks_[k].store(chunk.get(), std::memory_order::release);
+    Node_ *chunkFirst = &chunk[0];
+    Node_ *chunkLast  = &chunk[nodes - 1];
+    owned_.push_back(std::move(chunk));
+    release_(chunkFirst, chunkLast);
+  }
+
+  void link_(Node_ *first, Node_ *last, const std::size_t count) {
+    Node_ *prev = head_.exchange(last, std::memory_order::acq_rel);
+    // head_ shares a cache line with enqueued_, which the exchange has just claimed anyways
+    enqueued_.fetch_add(count, std::memory_order::relaxed);
+    prev->next.store(first, std::memory_order::release);
+  }
+
+  // Producer end
+  alignas(CACHE_LINE_SIZE) std::atomic<Node_ *> head_;
+  std::atomic<std::size_t> enqueued_{0};
+
+  // Consumer end
+  alignas(CACHE_LINE_SIZE) Node_ *tail_;
+  std::atomic<std::size_t> dequeued_{0};
+
+  Node_ stub_{};
+
+  // Node pool
+  alignas(CACHE_LINE_SIZE) std::atomic<U64> freeHead_{pack_(NIL, 0)};
+  std::array<std::atomic<Node_ *>, MAX_CHUNKS> chunks_{};
+
+  std::mutex                            growMutex_;
+  std::vector<std::unique_ptr<Node_[]>> owned_;
+};
+
+}  // namespace mgfw
@@ -1,40 +1,215 @@
 #pragma once
 
+#include "mgfw/ArenaChannel.hpp"
+#include "mgfw/BroadcastChannel.hpp"
+#include "mgfw/ConflatingChannel.hpp"
 #include "mgfw/EventReader.hpp"
 #include "mgfw/EventWriter.hpp"
 #include "mgfw/ILogger.hpp"
+#include "mgfw/JournalConfig.hpp"
+#include "mgfw/PartitionedChannel.hpp"
+#include "mgfw/ReadMostlyIndex.hpp"
+#include "mgfw/SlabChannel.hpp"
 #include "mgfw/SyncCell.hpp"
 #include "mgfw/TypeHash.hpp"
 #include "mgfw/TypeString.hpp"
 #include "mgfw/types.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <format>
 #include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace mgfw {
 
+// Only declared, so that the hive doesn't drag in the memory-mapping code; callers of the journal
+// getters include mgfw/JournalChannel.hpp themselves
+template<JournalMessage T>
+class JournalChannel;
+template<JournalMessage T>
+class JournalWriter;
+template<JournalMessage T>
+class JournalReader;
+
 /**
  * Manages MessageQueues, and gives clients a facility to retrieve the reader/writer endpoints for
  * the MessageQueue corresponding to a given ID. MessageQueues are lazily initialized as they are
  * requested.
  *
+ * Besides MessageQueues, where each message goes to one reader, the hive can hold other kinds of
+ * channels (e.g. BroadcastChannel, ConflatingChannel, ArenaChannel, JournalChannel,
+ * PartitionedChannel, SlabChannel). All kinds share the same ID space.
+ *
  * It is considered a bug if a reader/writer for a given ID is requested for a
- * MessageQueue with a different type than the one that already exists in the MQHive.
+ * MessageQueue with a different type than the one that already exists in the MQHive. The same goes
+ * for requesting a different kind of channel than the one that already exists.
+ *
+ * The QueueConfig passed to get_writer/get_reader only takes effect when the call creates the
+ * MessageQueue; it is ignored for queues that already exist.
+ *
+ * Looking up a channel that already exists doesn't take any locks (see ReadMostlyIndex); the
+ * hive's mutex is only taken to create channels.
  */
 class MQHive {
 public:
+  /**
+   * One channel's entry in snapshot()
+   */
+  struct ChannelStats {
+    U64              id;
+    std::string_view typeString;
+
+    // Only MessageQueues keep stats; other kinds of channels are listed without them
+    std::optional<QueueStats> stats;
+  };
+
   explicit MQHive(ILogger &logger) : logger_(logger) { }
 
+  /**
+   * Current stats of every channel in the hive, ordered by ID
+   */
+  std::vector<ChannelStats> snapshot() {
+    std::vector<ChannelStats> result;
+
+    {
+      auto queueMap = queueMapCell_.get_locked();
+      result.reserve(queueMap->size());
+      for(const auto &[id, container] : *queueMap) {
+        result.push_back(
+          {.id = id, .typeString = container->typeString, .stats = container->stats()});
+      }
+    }
+
+    std::ranges::sort(result, {}, &ChannelStats::id);
+    return result;
+  }
+
+  template<MessageType Raw_t, typename T = std::decay_t<Raw_t>>
+  EventWriter<T> get_writer(U64 id, const QueueConfig &config = {}) {
+    return EventWriter<T>(get_or_create_queue<T>(id, config));
+  }
+
+  template<MessageType Raw_t, typename T = std::decay_t<Raw_t>>
+  EventReader<T> get_reader(U64 id, const QueueConfig &config = {}) {
+    return EventReader<T>(get_or_create_queue<T>(id, config));
+  }
+
+  /**
+   * Install (or with an empty function, remove) the tap of a MessageQueue; see
+   * MessageQueue::set_tap. Creates the queue with the given config if it doesn't exist yet.
+   */
+  template<MessageType Raw_t, typename T = std::decay_t<Raw_t>>
+  void set_tap(U64 id, typename MessageQueue<T>::Tap_t tap, const QueueConfig &config = {}) {
+    get_or_create_queue<T>(id, config).set_tap(std::move(tap));
+  }
+
+  /**
+   * Endpoints for a BroadcastChannel, where every reader sees every message. The capacity only
+   * takes effect when the call creates the channel.
+   */
+  template<MessageType Raw_t, typename T = std::decay_t<Raw_t>>
+  BroadcastWriter<T> get_broadcast_writer(
+    U64 id, const std::size_t capacity = BroadcastChannel<T>::DEFAULT_CAPACITY) {
+    return BroadcastWriter<T>(get_or_create_channel<BroadcastChannel<T>>(id, id, capacity));
+  }
+
+  template<MessageType Raw_t, typename T = std::decay_t<Raw_t>>
+  BroadcastReader<T> get_broadcast_reader(
+    U64 id, const std::size_t capacity = BroadcastChannel<T>::DEFAULT_CAPACITY) {
+    return BroadcastReader<T>(get_or_create_channel<BroadcastChannel<T>>(id, id, capacity));
+  }
+
+  /**
+   * Endpoints for a ConflatingChannel, which only keeps the latest value for each key extracted by
+   * KeyFn_t. The key extractor is part of the channel's type.
+   */
+  template<MessageType Raw_t,
+           MessageKeyExtractor<std::decay_t<Raw_t>> KeyFn_t,
+           typename T = std::decay_t<Raw_t>>
+  ConflatingWriter<T, KeyFn_t> get_conflating_writer(U64 id) {
+    return ConflatingWriter<T, KeyFn_t>(get_or_create_channel<ConflatingChannel<T, KeyFn_t>>(id));
+  }
+
+  template<MessageType Raw_t,
+           MessageKeyExtractor<std::decay_t<Raw_t>> KeyFn_t,
+           typename T = std::decay_t<Raw_t>>
+  ConflatingReader<T, KeyFn_t> get_conflating_reader(U64 id) {
+    return ConflatingReader<T, KeyFn_t>(get_or_create_channel<ConflatingChannel<T, KeyFn_t>>(id));
+  }
+
+  /**
+   * Endpoints for a PartitionedChannel, which routes each message to one of several MessageQueues
+   * by the hash of the key extracted by KeyFn_t. Each partition gets its own reader, and should
+   * only be drained by one consumer. The config only takes effect when the call creates the
+   * channel.
+   */
+  template<MessageType Raw_t,
+           MessageKeyExtractor<std::decay_t<Raw_t>> KeyFn_t,
+           typename T = std::decay_t<Raw_t>>
+  PartitionedWriter<T, KeyFn_t> get_partitioned_writer(U64 id, const PartitionConfig &config = {}) {
+    return PartitionedWriter<T, KeyFn_t>(
+      get_or_create_channel<PartitionedChannel<T, KeyFn_t>>(id, logger_, id, config));
+  }
+
+  template<MessageType Raw_t,
+           MessageKeyExtractor<std::decay_t<Raw_t>> KeyFn_t,
+           typename T = std::decay_t<Raw_t>>
+  EventReader<T> get_partitioned_reader(U64                    id,
+                                        const std::size_t      partition,
+                                        const PartitionConfig &config = {}) {
+    return EventReader<T>(
+      get_or_create_channel<PartitionedChannel<T, KeyFn_t>>(id, logger_, id, config)
+        .partition(partition));
+  }
+
+  /**
+   * Endpoints for a SlabChannel, which passes large messages by handle to a shared pool. The config
+   * only takes effect when the call creates the channel.
+   */
   template<MessageType Raw_t, typename T = std::decay_t<Raw_t>>
-  EventWriter<T> get_writer(U64 id) {
-    return EventWriter<T>(get_or_create_queue<T>(id));
+  SlabWriter<T> get_slab_writer(U64 id, const SlabConfig &config = {}) {
+    return SlabWriter<T>(get_or_create_channel<SlabChannel<T>>(id, logger_, id, config));
   }
 
   template<MessageType Raw_t, typename T = std::decay_t<Raw_t>>
-  EventReader<T> get_reader(U64 id) {
-    return EventReader<T>(get_or_create_queue<T>(id));
+  SlabReader<T> get_slab_reader(U64 id, const SlabConfig &config = {}) {
+    return SlabReader<T>(get_or_create_channel<SlabChannel<T>>(id, logger_, id, config));
+  }
+
+  /**
+   * Endpoints for an ArenaChannel, which carries variable-size messages of mixed types. The chunk
+   * size only takes effect when the call creates the channel.
+   */
+  ArenaWriter get_arena_writer(U64 id,
+                               const std::size_t chunkSize = ArenaChannel::DEFAULT_CHUNK_SIZE) {
+    return ArenaWriter(get_or_create_channel<ArenaChannel>(id, id, chunkSize));
+  }
+
+  ArenaReader get_arena_reader(U64 id,
+                               const std::size_t chunkSize = ArenaChannel::DEFAULT_CHUNK_SIZE) {
+    return ArenaReader(get_or_create_channel<ArenaChannel>(id, id, chunkSize));
+  }
+
+  /**
+   * Endpoints for a JournalChannel, which persists its messages to memory-mapped files. The config
+   * only takes effect when the call creates the channel. Needs mgfw/JournalChannel.hpp, and linking
+   * MappedFile.cpp and Mapping.cpp.
+   */
+  template<JournalMessage Raw_t, typename T = std::decay_t<Raw_t>>
+  JournalWriter<T> get_journal_writer(U64 id, const JournalConfig &config) {
+    return JournalWriter<T>(get_or_create_channel<JournalChannel<T>>(id, logger_, id, config));
+  }
+
+  template<JournalMessage Raw_t, typename T = std::decay_t<Raw_t>>
+  JournalReader<T> get_journal_reader(U64 id, const JournalConfig &config) {
+    return JournalReader<T>(get_or_create_channel<JournalChannel<T>>(id, logger_, id, config));
   }
 
 private:
@@ -49,43 +224,78 @@ private:
     MQContainerBase &operator=(const MQContainerBase &) = delete;
     MQContainerBase &operator=(MQContainerBase &&)      = delete;
 
+    virtual std::optional<QueueStats> stats() const = 0;
+
     const Hash_t     typeHash;
     std::string_view typeString;
   };
 
-  template<typename T>
+  // N.B. the type info is that of the whole channel (e.g. MessageQueue<T>), not just the message
+  template<typename Channel_t>
   struct MQContainer : public MQContainerBase {
-    MQContainer(ILogger &logger, const U64 id)
-      : MQContainerBase(TypeHash<T>, TypeString<T>), mq(logger, id) { }
+    template<typename... Args>
+    explicit MQContainer(Args &&...args)
+      : MQContainerBase(TypeHash<Channel_t>, TypeString<Channel_t>),
+        channel(std::forward<Args>(args)...) { }
+
+    std::optional<QueueStats> stats() const override {
+      if constexpr(requires { channel.stats(); }) {
+        return channel.stats();
+      }
+      else {
+        return std::nullopt;
+      }
+    }
 
-    MessageQueue<T> mq;
+    Channel_t channel;
   };
 
   template<typename T>
-  MessageQueue<T> &get_or_create_queue(U64 id) {
-    auto queueMap = queueMapCell_.get_locked();
-    auto it       = queueMap->find(id);
+  MessageQueue<T> &get_or_create_queue(U64 id, const QueueConfig &config) {
+    return get_or_create_channel<MessageQueue<T>>(id, logger_, id, config);
+  }
+
+  /**
+   * Look up the channel for `id`, constructing it from `args` if it doesn't exist yet
+   */
+  template<typename Channel_t, typename... Args>
+  Channel_t &get_or_create_channel(U64 id, Args &&...args) {
+    MQContainerBase *container = channelIndex_.find(id);
+
+    if(container == nullptr) {
+      auto queueMap = queueMapCell_.get_locked();
+      auto it       = queueMap->find(id);
 
-    if(it == queueMap->end()) {
-      auto mqContainer = std::make_unique<MQContainer<T>>(logger_, id);
-      [[maybe_unused]] auto [resultIt, success] =
-        queueMap->insert(std::pair{id, std::move(mqContainer)});
+      // Someone else may have created the channel since we checked the index
+      if(it == queueMap->end()) {
+        auto mqContainer = std::make_unique<MQContainer<Channel_t>>(std::forward<Args>(args)...);
+        [[maybe_unused]] auto [resultIt, success] =
+          queueMap->insert(std::pair{id, std::move(mqContainer)});
 
-      it = resultIt;
+        it = resultIt;
+        channelIndex_.insert(id, it->second.get());
+      }
+
+      container = it->second.get();
     }
-    else if(it->second->typeHash != TypeHash<T>) {
-      throw std::runtime_error(std::format(
-        "Type mismatch on MQHive::get_or_create_queue (id = {}, storedType = {}, currentType = {})",
-        id,
-        it->second->typeString,
-        TypeString<T>));
+
+    if(container->typeHash != TypeHash<Channel_t>) {
+      throw std::runtime_error(
+        std::format("Type mismatch on MQHive::get_or_create_channel (id = {}, storedType = {}, "
+                    "currentType = {})",
+                    id,
+                    container->typeString,
+                    TypeString<Channel_t>));
     }
 
-    return static_cast<MQContainer<T> *>(it->second.get())->mq;
+    return static_cast<MQContainer<Channel_t> *>(container)->channel;
   }
 
   SyncCell<std::unordered_map<U64, std::unique_ptr<MQContainerBase>>> queueMapCell_;
 
+  // Lock-free view of queueMapCell_ for lookups; only inserted into under its lock
+  ReadMostlyIndex<MQContainerBase> channelIndex_;
+
   ILogger &logger_;
 };
 }  // namespace mgfw
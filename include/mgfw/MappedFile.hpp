@@ -0,0 +1,56 @@
+#pragma once
+
+#include "mgfw/Mapping.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace mgfw {
+
+/**
+ * Read-write, shared memory mapping of a whole file (POSIX only). Writes through the mapping land
+ * in the page cache right away, so they survive the process crashing; sync() additionally flushes
+ * them to storage.
+ *
+ * Failures throw std::system_error.
+ */
+class MappedFile {
+public:
+  /**
+   * Map an existing file in its entirety
+   */
+  static MappedFile open(const std::filesystem::path &path);
+
+  /**
+   * Create a file of `size` zeroed bytes (replacing any existing file), and map it
+   */
+  static MappedFile create(const std::filesystem::path &path, std::size_t size);
+
+  MappedFile(const MappedFile &)            = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&)                 = default;
+  MappedFile &operator=(MappedFile &&)      = default;
+  ~MappedFile()                             = default;
+
+  const std::filesystem::path &path() const { return path_; }
+
+  std::span<std::byte> bytes() const { return mapping_.bytes(); }
+
+  /**
+   * Block until the given byte range (widened to whole pages) has been written to storage
+   */
+  void sync(const std::size_t offset, const std::size_t length) const {
+    mapping_.sync(offset, length);
+  }
+
+  void sync() const { sync(0, bytes().size()); }
+
+private:
+  MappedFile(std::filesystem::path path, int fd, std::size_t size);
+
+  std::filesystem::path path_;
+  Mapping               mapping_;
+};
+
+}  // namespace mgfw
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace mgfw {
+
+/**
+ * Owner of a file descriptor and a read-write, shared memory mapping of its first `size` bytes
+ * (POSIX only). MappedFile and SharedMemory differ only in how they come by the descriptor, and
+ * both keep it in one of these.
+ *
+ * Failures throw std::system_error, with messages of the form "<owner>: <what> <name>".
+ */
+class Mapping {
+public:
+  Mapping() = default;
+
+  /**
+   * Take ownership of `fd` and map it; the descriptor is closed if mapping fails. An empty mapping
+   * maps nothing.
+   */
+  Mapping(std::string_view owner, std::string name, int fd, std::size_t size);
+
+  ~Mapping();
+
+  Mapping(const Mapping &)            = delete;
+  Mapping &operator=(const Mapping &) = delete;
+  Mapping(Mapping &&other) noexcept;
+  Mapping &operator=(Mapping &&other) noexcept;
+
+  const std::string &name() const { return name_; }
+
+  std::span<std::byte> bytes() const { return {data_, size_}; }
+
+  /**
+   * Block until the given byte range (widened to whole pages) has been written to storage
+   */
+  void sync(std::size_t offset, std::size_t length) const;
+
+  /**
+   * Throw a std::system_error for the current errno
+   */
+  [[noreturn]] static void throw_errno(std::string_view owner,
+                                       std::string_view what,
+                                       std::string_view name);
+
+private:
+  void close_() noexcept;
+
+  std::string_view owner_;
+  std::string      name_;
+  int              fd_   = -1;
+  std::byte       *data_ = nullptr;
+  std::size_t      size_ = 0;
+};
+
+}  // namespace mgfw
@@ -9,14 +9,48 @@
 #pragma GCC diagnostic pop
 #endif
 
+#if defined(__SANITIZE_THREAD__)
+#define MGFW_TSAN_ENABLED 1
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define MGFW_TSAN_ENABLED 1
+#endif
+#endif
+
 #include "mgfw/ILogger.hpp"
+#include "mgfw/MPSCQueue.hpp"
+#include "mgfw/SPSCQueue.hpp"
+#include "mgfw/defer.hpp"
 #include "mgfw/types.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <concepts>
+#include <cstddef>
 #include <format>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <semaphore>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <type_traits>
 #include <utility>
+#include <variant>
 #include <vector>
 
 namespace mgfw {
@@ -28,39 +62,526 @@ template<typename Fn_t, typename T>
 concept MessageDrainCallback =
   std::invocable<Fn_t, const T &> && std::same_as<std::invoke_result_t<Fn_t, const T &>, void>;
 
+template<typename Fn_t, typename T>
+concept MessageBulkDrainCallback = std::invocable<Fn_t, std::span<T>>
+                                && std::same_as<std::invoke_result_t<Fn_t, std::span<T>>, void>;
+
+/**
+ * The data structure backing a MessageQueue. Pick the least general backend that fits how many
+ * endpoints will be attached to the queue; the SPSC and MPSC backends are considerably cheaper than
+ * the MPMC one.
+ */
+enum class QueueBackend : U8 {
+  MPMC,  // moodycamel::ConcurrentQueue; any number of producers and consumers
+  SPSC,  // SPSCQueue; at most one producer endpoint and one consumer endpoint
+  MPSC,  // MPSCQueue; any number of producers, at most one consumer endpoint
+};
+
+/**
+ * What a bounded MessageQueue does with a message that arrives while the queue is at capacity.
+ */
+enum class OverflowPolicy : U8 {
+  Block,            // Wait until a consumer makes room
+  Fail,             // Refuse the message and leave it with the caller
+  DropNewest,       // Discard the incoming message
+  OverwriteOldest,  // Discard the oldest queued message to make room; MPMC backend only
+};
+
+/**
+ * Priority lanes of a MessageQueue. Consumers always empty higher lanes before lower ones.
+ */
+enum class Priority : U8 {
+  High,
+  Normal,
+  Low,
+};
+
+constexpr std::size_t PRIORITY_LANES = 3;
+
+/**
+ * Creation-time options for a MessageQueue.
+ */
+struct QueueConfig {
+  QueueBackend backend = QueueBackend::MPMC;
+
+  // Number of priority lanes, from 1 to PRIORITY_LANES. Each lane is a separate backend instance;
+  // when there are fewer lanes than priorities, the lowest priorities share the last lane.
+  std::size_t lanes = 1;
+
+  // Maximum number of messages in the queue; 0 means unbounded
+  std::size_t    capacity = 0;
+  OverflowPolicy overflow = OverflowPolicy::Block;
+
+  // Sample the write-to-drain latency of every Nth message of each lane; 0 disables latency
+  // sampling
+  U32 latencySampleInterval = 0;
+};
+
+/**
+ * Running totals of how often a bounded MessageQueue has had to apply its OverflowPolicy.
+ */
+struct OverflowStats {
+  U64 dropped  = 0;  // Messages discarded by DropNewest/OverwriteOldest
+  U64 rejected = 0;  // Messages refused by Fail
+  U64 blocked  = 0;  // Enqueue calls that had to wait under Block
+};
+
+/**
+ * Histogram of sampled write-to-drain latencies. Bucket i counts latencies in [2^(i-1), 2^i) ns;
+ * bucket 0 counts sub-nanosecond latencies, and the last bucket everything that doesn't fit.
+ */
+struct LatencyHistogram {
+  static constexpr std::size_t BUCKETS = 40;
+
+  static std::size_t bucket_of(const Duration_t latency) {
+    const auto ns = static_cast<U64>(std::max<Duration_t::rep>(latency.count(), 0));
+    const auto width =
+      static_cast<std::size_t>(std::numeric_limits<U64>::digits - std::countl_zero(ns));
+    return std::min(width, BUCKETS - 1);
+  }
+
+  U64 samples() const { return std::accumulate(counts.begin(), counts.end(), U64{0}); }
+
+  /**
+   * Upper bound of the bucket holding the given quantile (in [0, 1]) of the samples, or zero if
+   * there are no samples
+   */
+  Duration_t quantile(const double q) const {
+    const U64 total = samples();
+    if(total == 0) {
+      return Duration_t::zero();
+    }
+
+    const auto target =
+      std::max<U64>(static_cast<U64>(std::ceil(q * static_cast<double>(total))), 1);
+    U64 seen = 0;
+    for(std::size_t i = 0; i < BUCKETS; ++i) {
+      seen += counts[i];
+      if(seen >= target) {
+        return Duration_t(Duration_t::rep{1} << i);
+      }
+    }
+    return Duration_t(Duration_t::rep{1} << (BUCKETS - 1));
+  }
+
+  std::array<U64, BUCKETS> counts{};
+};
+
+/**
+ * Point-in-time health of a MessageQueue.
+ */
+struct QueueStats {
+  U64         enqueued      = 0;  // Messages accepted by the queue
+  U64         dequeued      = 0;  // Messages handed to consumers
+  std::size_t depth         = 0;  // Approximate number of messages currently queued
+  std::size_t highWaterMark = 0;  // Deepest the queue was seen by a consumer (see note_depth_)
+
+  OverflowStats overflow;
+
+  // Only present if the queue samples latencies; see QueueConfig::latencySampleInterval
+  std::optional<LatencyHistogram> latency;
+};
+
+namespace detail_ {
+  /**
+   * Full memory barrier. ThreadSanitizer doesn't model standalone fences (and GCC refuses to
+   * compile them under -fsanitize=thread -Werror), so sanitized builds use a no-op RMW on `anchor`
+   * instead.
+   */
+  inline void full_fence([[maybe_unused]] std::atomic<U32> &anchor) noexcept {
+#ifdef MGFW_TSAN_ENABLED
+    anchor.fetch_add(0, std::memory_order::seq_cst);
+#else
+    std::atomic_thread_fence(std::memory_order::seq_cst);
+#endif
+  }
+
+  /**
+   * Small number handed out to each thread the first time it asks, for spreading a counter that
+   * many threads bump over several cache lines
+   */
+  inline std::size_t thread_stripe() noexcept {
+    static std::atomic<std::size_t> nextStripe{0};
+    thread_local const std::size_t  stripe = nextStripe.fetch_add(1, std::memory_order::relaxed);
+    return stripe;
+  }
+
+  /**
+   * Holds one claim on an endpoint counter, and gives it back on destruction.
+   */
+  class EndpointLease {
+  public:
+    EndpointLease() = default;
+
+    explicit EndpointLease(std::atomic<U32> &count) : count_(&count) { }
+
+    ~EndpointLease() { reset(); }
+
+    EndpointLease(const EndpointLease &)            = delete;
+    EndpointLease &operator=(const EndpointLease &) = delete;
+
+    EndpointLease(EndpointLease &&other) noexcept : count_(std::exchange(other.count_, nullptr)) { }
+
+    EndpointLease &operator=(EndpointLease &&other) noexcept {
+      if(this != &other) {
+        reset();
+        count_ = std::exchange(other.count_, nullptr);
+      }
+      return *this;
+    }
+
+    void reset() noexcept {
+      if(count_ != nullptr) {
+        count_->fetch_sub(1, std::memory_order::acq_rel);
+        count_ = nullptr;
+      }
+    }
+
+  private:
+    std::atomic<U32> *count_ = nullptr;
+  };
+}  // namespace detail_
+
 /**
  * Simple message queue.
+ *
+ * The backend is chosen at construction time via QueueConfig. Backends that only support a single
+ * producer and/or consumer enforce that at the endpoint level: requesting a second producer (or
+ * consumer) token from such a queue is considered a bug and throws.
+ *
+ * A queue may optionally be bounded, in which case an atomic depth counter is maintained alongside
+ * the backend and the configured OverflowPolicy kicks in when it reaches capacity. The enqueue
+ * functions report whether the message made it into the queue. Unbounded queues skip all of this
+ * bookkeeping.
+ *
+ * Consumers may block until messages arrive via wait_for_any/wait_until_any, or ask to be called
+ * back instead via notify_when_any. Producers only touch the underlying semaphore (or callback
+ * list) while a consumer is actually parked on it, so the cost to producers when nobody waits is a
+ * fence and two loads. Only the first producer to find consumers parked posts a wake-up; the rest
+ * of a burst sees it already posted until a consumer parks again.
+ *
+ * A queue may also be split into priority lanes (see QueueConfig::lanes). Each lane has its own
+ * backend, so writing to a lane costs the same as writing to a single-lane queue. Draining checks
+ * the higher lanes for new messages after every message (or batch) taken from a lower lane, so a
+ * high-priority message never waits behind more than one lower-priority callback. Ordering is only
+ * preserved within a lane. Capacity and overflow accounting is shared by all lanes.
+ *
+ * Every queue keeps a few relaxed counters for telemetry (see stats()). The enqueue count is split
+ * over several cache lines, so that MPMC producers don't all bump the same one. Latency sampling
+ * stamps every Nth enqueue to a lane and matches it up with the Nth dequeue from that lane, which
+ * is exact for the SPSC and MPSC backends. MPMC lanes only keep each producer's messages in order,
+ * so with several producers or consumers the samples there are only approximate.
+ *
+ * A tap (see set_tap()) observes every message that makes it into the queue, e.g. for recording
+ * traffic. Without one installed, producers only pay for a relaxed load. With one installed, they
+ * read it RCU-style, so a tap doesn't make producers take turns.
  */
 template<MessageType T>
 class MessageQueue {
+  using Mpmc_t    = moodycamel::ConcurrentQueue<T>;
+  using Backend_t = std::variant<Mpmc_t, SPSCQueue<T>, MPSCQueue<T>>;
+
+  template<typename Backend>
+  static constexpr bool is_mpmc_ = std::same_as<std::remove_cvref_t<Backend>, Mpmc_t>;
+
 public:
-  MessageQueue(ILogger &logger, const U64 id) : logger_(logger), id_(id) { }
+  /**
+   * Per-endpoint producer state. Holds a moodycamel::ProducerToken per lane for MPMC queues, which
+   * lets the token-aware overloads below skip the implicit-producer lookup, and the producer
+   * endpoint claim for single-producer queues. A token must not be used by more than one thread at
+   * a time.
+   */
+  class ProducerToken {
+  private:
+    friend class MessageQueue;
+    ProducerToken() = default;
+
+    std::array<std::optional<moodycamel::ProducerToken>, PRIORITY_LANES> mpmcTokens_;
+    detail_::EndpointLease                                               lease_;
+
+    // Outstanding reserve(), for backends that can't hand out their own storage
+    std::optional<typename MPSCQueue<T>::Reservation> mpscReservation_;
+    std::optional<T>                                  staging_;
+    std::size_t                                       reservedLane_ = 0;
+    Priority                                          reservedPriority_ = Priority::Normal;
+  };
+
+  /**
+   * Per-endpoint consumer state; the counterpart of ProducerToken.
+   */
+  class ConsumerToken {
+  private:
+    friend class MessageQueue;
+    ConsumerToken() = default;
+
+    std::array<std::optional<moodycamel::ConsumerToken>, PRIORITY_LANES> mpmcTokens_;
+    detail_::EndpointLease                                               lease_;
+
+    // Message handed out by peek() on MPMC queues, which can't be read in place
+    std::optional<T> staging_;
+    std::size_t      peekedLane_ = 0;
+
+    // peek() calls left until it next checks the queue's depth
+    U32 peeksUntilDepth_ = 0;
+  };
+
+  using ProducerToken_t = ProducerToken;
+  using ConsumerToken_t = ConsumerToken;
+
+  /**
+   * Called with each message accepted by the queue and the priority it was written with (not that
+   * of the lane it went to, which is coarser when there are fewer lanes than priorities)
+   */
+  using Tap_t = std::function<void(const T &, Priority)>;
+
+  /**
+   * `label`, if given, follows the ID in diagnostics, to tell apart queues that share an ID (e.g.
+   * the partitions of a PartitionedChannel)
+   */
+  MessageQueue(ILogger               &logger,
+               const U64              id,
+               const QueueConfig      &config = {},
+               const std::string_view label  = {})
+    : logger_(logger),
+      name_(label.empty() ? std::to_string(id) : std::format("{} {}", id, label)),
+      config_(config) {
+    if(config_.lanes == 0 || config_.lanes > PRIORITY_LANES) {
+      throw std::invalid_argument(std::format(
+        "MessageQueue {}: lane count must be between 1 and {}", name_, PRIORITY_LANES));
+    }
 
+    if(config_.overflow == OverflowPolicy::OverwriteOldest && config_.capacity > 0
+       && config_.backend != QueueBackend::MPMC)
+    {
+      // Evicting the oldest message means dequeueing from the producer side
+      throw std::invalid_argument(std::format(
+        "MessageQueue {}: OverflowPolicy::OverwriteOldest requires the MPMC backend", name_));
+    }
+
+    for(std::size_t lane = 0; lane < config_.lanes; ++lane) {
+      emplace_backend_(lanes_[lane], config_.backend);
+    }
+
+    if(config_.latencySampleInterval > 0) {
+      latency_ = std::make_unique<LatencySampler_>();
+    }
+  }
+
+  // Endpoints hold references (and tokens) into the queue, so it stays put once created
   MessageQueue(const MessageQueue &)            = delete;
   MessageQueue &operator=(const MessageQueue &) = delete;
-  MessageQueue(MessageQueue &&)                 = default;
-  MessageQueue &operator=(MessageQueue &&)      = default;
+  MessageQueue(MessageQueue &&)                 = delete;
+  MessageQueue &operator=(MessageQueue &&)      = delete;
 
   ~MessageQueue() {
-    if(const auto approxSize = messages_.size_approx(); approxSize > 0) {
+    if(const auto approxSize = size_approx(); approxSize > 0) {
       logger_.warn(std::format(
         "MessageQueue {} destroyed with approximately {} unprocessed message(s) remaining",
-        id_,
+        name_,
         approxSize));
     }
   }
 
+  QueueBackend backend() const { return config_.backend; }
+
+  std::size_t lanes() const { return config_.lanes; }
+
+  std::size_t capacity() const { return config_.capacity; }
+
+  /**
+   * Install a tap, replacing any previous one, or remove it by passing an empty function. Taps run
+   * on the producer's thread before the message is enqueued, concurrently if there are several
+   * producers, so they must be thread-safe. Once set_tap() returns, the previous tap is no longer
+   * running and won't be called again.
+   *
+   * Producers announce themselves on a reader counter (one per thread stripe and epoch parity)
+   * before loading the tap. Replacing it flips the epoch twice, waiting each time for the readers
+   * of the old parity to leave, which covers every producer that could have loaded the old tap.
+   */
+  void set_tap(Tap_t tap) {
+    const std::scoped_lock tapLock(tapMutex_);
+
+    auto next = tap ? std::make_unique<const Tap_t>(std::move(tap)) : nullptr;
+    tap_.store(next.get(), std::memory_order::seq_cst);
+    tapped_.store(next != nullptr, std::memory_order::relaxed);
+
+    for(int phase = 0; phase < 2; ++phase) {
+      const U32 parity = tapEpoch_.fetch_add(1, std::memory_order::seq_cst) & 1U;
+      for(const TapReaders_ &readers : tapReaders_) {
+        while(readers.count[parity].load(std::memory_order::acquire) != 0) {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+    ownedTap_ = std::move(next);
+  }
+
+  OverflowStats overflow_stats() const {
+    return {
+      .dropped  = dropped_.load(std::memory_order::relaxed),
+      .rejected = rejected_.load(std::memory_order::relaxed),
+      .blocked  = blocked_.load(std::memory_order::relaxed),
+    };
+  }
+
+  QueueStats stats() const {
+    U64 enqueued = 0;
+    for(const StripedCounter_ &stripe : enqueued_) {
+      enqueued += stripe.value.load(std::memory_order::relaxed);
+    }
+
+    QueueStats stats{
+      .enqueued      = enqueued,
+      .dequeued      = dequeued_.load(std::memory_order::relaxed),
+      .depth         = size_approx(),
+      .highWaterMark = highWaterMark_.load(std::memory_order::relaxed),
+      .overflow      = overflow_stats(),
+      .latency       = std::nullopt,
+    };
+
+    if(latency_ != nullptr) {
+      LatencyHistogram &histogram = stats.latency.emplace();
+      for(std::size_t i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+        histogram.counts[i] = latency_->counts[i].load(std::memory_order::relaxed);
+      }
+    }
+
+    return stats;
+  }
+
+  std::size_t size_approx() const {
+    std::size_t size = 0;
+    for(std::size_t lane = 0; lane < config_.lanes; ++lane) {
+      size += lane_size_approx_(lane);
+    }
+    return size;
+  }
+
+  /**
+   * Block until the queue looks non-empty, or until the timeout/deadline passes. Returns whether
+   * there are messages available. May return true spuriously if another consumer gets to the
+   * messages first.
+   */
+  bool wait_for_any(const Duration_t timeout) {
+    return wait_until_any(std::chrono::steady_clock::now() + timeout);
+  }
+
+  bool wait_until_any(const TimePoint_t deadline) {
+    if(size_approx() > 0) {
+      return true;
+    }
+
+    parkedWaiters_.fetch_add(1, std::memory_order::seq_cst);
+    const defer unpark([this] { parkedWaiters_.fetch_sub(1, std::memory_order::relaxed); });
+
+    while(true) {
+      // Let the next producer post a wake-up again
+      wakePosted_.store(false, std::memory_order::seq_cst);
+
+      // Pairs with the fence in signal_waiters_(): either the producer sees us parked with the
+      // wake-up re-armed, or we see its message
+      detail_::full_fence(parkedWaiters_);
+      if(size_approx() > 0) {
+        return true;
+      }
+
+      if(!wakeSignal_.try_acquire_until(deadline)) {
+        return size_approx() > 0;
+      }
+    }
+  }
+
+  /**
+   * Asynchronous counterpart of wait_until_any: `callback` runs once, as soon as the queue looks
+   * non-empty. That's either right away on the calling thread or later on the thread of the
+   * producer whose message arrives, so callbacks should do little more than hand off to an
+   * executor. As with wait_until_any, another consumer may get to the messages first.
+   */
+  void notify_when_any(std::function<void()> callback) {
+    {
+      const std::scoped_lock asyncLock(asyncMutex_);
+      asyncCallbacks_.push_back(std::move(callback));
+      asyncWaiters_.fetch_add(1, std::memory_order::seq_cst);
+    }
+
+    // Same handshake as wait_until_any
+    detail_::full_fence(parkedWaiters_);
+
+    if(size_approx() > 0) {
+      wake_async_waiters_();
+    }
+  }
+
+  /**
+   * Create a token for a long-lived producer/consumer endpoint.
+   */
+  ProducerToken_t make_producer_token() {
+    ProducerToken_t token;
+    if(config_.backend == QueueBackend::MPMC) {
+      for(std::size_t lane = 0; lane < config_.lanes; ++lane) {
+        token.mpmcTokens_[lane].emplace(std::get<Mpmc_t>(*lanes_[lane]));
+      }
+    }
+    else if(config_.backend == QueueBackend::SPSC) {
+      token.lease_ = claim_endpoint_(producerEndpoints_, "producer");
+    }
+    return token;
+  }
+
+  ConsumerToken_t make_consumer_token() {
+    ConsumerToken_t token;
+    if(config_.backend == QueueBackend::MPMC) {
+      for(std::size_t lane = 0; lane < config_.lanes; ++lane) {
+        token.mpmcTokens_[lane].emplace(std::get<Mpmc_t>(*lanes_[lane]));
+      }
+    }
+    else {
+      token.lease_ = claim_endpoint_(consumerEndpoints_, "consumer");
+    }
+    return token;
+  }
+
   /**
-   * Enqueue a message
+   * Enqueue a message. Returns false if a bounded queue refused or dropped the message.
    */
-  void enqueue(const T &message) { messages_.enqueue(message); }
+  bool enqueue(const T &message, const Priority priority = Priority::Normal) {
+    return enqueue_(nullptr, priority, message);
+  }
+
+  bool enqueue(T &&message, const Priority priority = Priority::Normal) {
+    return enqueue_(nullptr, priority, std::move(message));
+  }
 
-  void enqueue(T &&message) { messages_.enqueue(std::move(message)); }
+  bool enqueue(ProducerToken_t &token,
+               const T         &message,
+               const Priority   priority = Priority::Normal) {
+    return enqueue_(&token, priority, message);
+  }
 
-  // No need to write an rvalue version since we wouldn't be moving the vector itself; rvalue refs
-  // will simply bind to the const ref argument and live until this function ends.
-  void enqueue_bulk(const std::vector<T> &messages) {
-    messages_.enqueue_bulk(messages.begin(), messages.size());
+  bool enqueue(ProducerToken_t &token, T &&message, const Priority priority = Priority::Normal) {
+    return enqueue_(&token, priority, std::move(message));
+  }
+
+  /**
+   * Enqueue several messages at once. Returns the number of messages that made it into the queue.
+   *
+   * Accepts any sized range (the default template argument lets braced lists through). Elements are
+   * moved rather than copied out of rvalue containers, and out of ranges whose elements are rvalues
+   * (e.g. a subrange of std::move_iterators).
+   */
+  template<std::ranges::sized_range Range_t = std::initializer_list<T>>
+  requires std::constructible_from<T, std::ranges::range_reference_t<Range_t>>
+  std::size_t enqueue_bulk(Range_t &&messages, const Priority priority = Priority::Normal) {
+    return enqueue_range_(nullptr, priority, std::forward<Range_t>(messages));
+  }
+
+  template<std::ranges::sized_range Range_t = std::initializer_list<T>>
+  requires std::constructible_from<T, std::ranges::range_reference_t<Range_t>>
+  std::size_t enqueue_bulk(ProducerToken_t &token,
+                           Range_t        &&messages,
+                           const Priority   priority = Priority::Normal) {
+    return enqueue_range_(&token, priority, std::forward<Range_t>(messages));
   }
 
   /**
@@ -68,8 +589,149 @@ public:
    */
   template<typename... Args>
   requires std::constructible_from<T, Args...>
-  void emplace(Args &&...args) {
-    messages_.enqueue(T{std::forward<Args>(args)...});
+  bool emplace(Args &&...args) {
+    return enqueue(T{std::forward<Args>(args)...});
+  }
+
+  template<typename... Args>
+  requires std::constructible_from<T, Args...>
+  bool emplace(ProducerToken_t &token, Args &&...args) {
+    return enqueue(token, T{std::forward<Args>(args)...});
+  }
+
+  /**
+   * Two-phase enqueue for building a message in place: reserve() hands out storage for the next
+   * message, which the producer fills in before commit() publishes it. The SPSC and MPSC backends
+   * hand out their own storage; MPMC queues stage the message in the token and move it in on
+   * commit. Calling reserve() again before commit() returns the same storage, and the storage
+   * contents are unspecified until filled in.
+   *
+   * commit() applies the overflow policy like enqueue and returns false if the message did not make
+   * it into the queue. Under OverflowPolicy::Fail the reservation is kept so the commit can be
+   * retried; otherwise it is discarded.
+   */
+  T &reserve(ProducerToken_t &token, const Priority priority = Priority::Normal) {
+    token.reservedLane_     = lane_of_(priority);
+    token.reservedPriority_ = priority;
+    return std::visit(
+      [&]<typename Backend>(Backend &backend) -> T & {
+        if constexpr(std::same_as<Backend, SPSCQueue<T>>) {
+          return backend.reserve();
+        }
+        else if constexpr(std::same_as<Backend, MPSCQueue<T>>) {
+          if(!token.mpscReservation_) {
+            token.mpscReservation_.emplace(backend.reserve());
+          }
+          return token.mpscReservation_->value();
+        }
+        else {
+          if(!token.staging_) {
+            token.staging_.emplace();
+          }
+          return *token.staging_;
+        }
+      },
+      *lanes_[token.reservedLane_]);
+  }
+
+  bool commit(ProducerToken_t &token) {
+    if(config_.capacity > 0 && !admit_()) {
+      if(config_.overflow != OverflowPolicy::Fail) {
+        token.mpscReservation_.reset();
+        token.staging_.reset();
+      }
+      return false;
+    }
+
+    const std::size_t lane     = token.reservedLane_;
+    const Priority    priority = token.reservedPriority_;
+    on_enqueued_(1, lane);
+    std::visit(
+      [&]<typename Backend>(Backend &backend) {
+        if constexpr(std::same_as<Backend, SPSCQueue<T>>) {
+          run_tap_(backend.reserve(), priority);
+          backend.commit();
+        }
+        else if constexpr(std::same_as<Backend, MPSCQueue<T>>) {
+          assert(token.mpscReservation_);
+          run_tap_(token.mpscReservation_->value(), priority);
+          backend.commit(*token.mpscReservation_);
+          token.mpscReservation_.reset();
+        }
+        else {
+          assert(token.staging_);
+          run_tap_(*token.staging_, priority);
+          backend_push_(backend, &token, lane, std::move(*token.staging_));
+          token.staging_.reset();
+        }
+      },
+      *lanes_[lane]);
+    signal_waiters_();
+    return true;
+  }
+
+  /**
+   * Two-phase dequeue for processing a message in place: peek() returns the oldest message of the
+   * highest non-empty lane without removing it (or nullptr if the queue is empty), and release()
+   * removes it once the consumer is done with it. The SPSC and MPSC backends return their own
+   * storage; MPMC queues dequeue into the token. Calling peek() again before release() returns the
+   * same message, unless a higher-priority one arrived in the meantime; release() always removes
+   * the message returned last.
+   */
+  T *peek(ConsumerToken_t &token) {
+    if(token.staging_) {
+      return &*token.staging_;
+    }
+
+    if(token.peeksUntilDepth_ == 0) {
+      note_depth_();
+      token.peeksUntilDepth_ = PEEK_DEPTH_INTERVAL;
+    }
+    --token.peeksUntilDepth_;
+
+    for(std::size_t lane = 0; lane < config_.lanes; ++lane) {
+      T *message = std::visit(
+        [&]<typename Backend>(Backend &backend) -> T * {
+          if constexpr(is_mpmc_<Backend>) {
+            token.staging_.emplace();
+            if(!backend_pop_(backend, &token, lane, *token.staging_)) {
+              token.staging_.reset();
+              return nullptr;
+            }
+            // The message has left the backend, so make room for producers right away
+            on_dequeued_(1, lane);
+            return &*token.staging_;
+          }
+          else {
+            return backend.peek();
+          }
+        },
+        *lanes_[lane]);
+
+      if(message != nullptr) {
+        token.peekedLane_ = lane;
+        return message;
+      }
+    }
+
+    // Check again as soon as messages come back
+    token.peeksUntilDepth_ = 0;
+    return nullptr;
+  }
+
+  void release(ConsumerToken_t &token) {
+    std::visit(
+      [&]<typename Backend>(Backend &backend) {
+        if constexpr(is_mpmc_<Backend>) {
+          assert(token.staging_);
+          token.staging_.reset();
+        }
+        else {
+          backend.pop();
+          on_dequeued_(1, token.peekedLane_);
+        }
+      },
+      *lanes_[token.peekedLane_]);
   }
 
   /**
@@ -77,16 +739,572 @@ public:
    */
   template<MessageDrainCallback<T> Callback_t>
   void drain(const Callback_t &callback) {
-    T msg;
-    while(messages_.try_dequeue(msg)) {
-      callback(msg);
-    }
+    drain_(nullptr, callback);
+  }
+
+  template<MessageDrainCallback<T> Callback_t>
+  void drain(ConsumerToken_t &token, const Callback_t &callback) {
+    drain_(&token, callback);
+  }
+
+  /**
+   * Dequeue messages in batches of up to `buffer.size()` elements into `buffer`, and invoke a
+   * callback on each batch, until the queue is empty. The callback receives a mutable span over the
+   * front of `buffer`, so it is free to move elements out.
+   */
+  template<MessageBulkDrainCallback<T> Callback_t>
+  void drain_bulk(std::span<T> buffer, const Callback_t &callback) {
+    drain_bulk_(nullptr, buffer, callback);
+  }
+
+  template<MessageBulkDrainCallback<T> Callback_t>
+  void drain_bulk(ConsumerToken_t &token, std::span<T> buffer, const Callback_t &callback) {
+    drain_bulk_(&token, buffer, callback);
   }
 
 private:
-  moodycamel::ConcurrentQueue<T> messages_;
-  ILogger                       &logger_;
-  const U64                      id_;
+  static void emplace_backend_(std::optional<Backend_t> &lane, const QueueBackend backend) {
+    switch(backend) {
+      case QueueBackend::SPSC:
+        lane.emplace(std::in_place_type<SPSCQueue<T>>);
+        return;
+      case QueueBackend::MPSC:
+        lane.emplace(std::in_place_type<MPSCQueue<T>>);
+        return;
+      case QueueBackend::MPMC:
+        break;
+    }
+    lane.emplace(std::in_place_type<Mpmc_t>);
+  }
+
+  std::size_t lane_of_(const Priority priority) const {
+    return std::min<std::size_t>(std::to_underlying(priority), config_.lanes - 1);
+  }
+
+  std::size_t lane_size_approx_(const std::size_t lane) const {
+    return std::visit([](const auto &backend) -> std::size_t { return backend.size_approx(); },
+                      *lanes_[lane]);
+  }
+
+  /**
+   * Whether any lane above `lane` looks non-empty
+   */
+  bool higher_lanes_pending_(const std::size_t lane) const {
+    for(std::size_t higher = 0; higher < lane; ++higher) {
+      if(lane_size_approx_(higher) > 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Thin wrappers that use the moodycamel token when the backend supports it (and one was given)
+   */
+  template<typename Backend, typename U>
+  static void backend_push_(Backend          &backend,
+                            ProducerToken_t  *token,
+                            const std::size_t lane,
+                            U               &&message) {
+    if constexpr(is_mpmc_<Backend>) {
+      if(token != nullptr) {
+        backend.enqueue(*token->mpmcTokens_[lane], std::forward<U>(message));
+        return;
+      }
+    }
+    backend.enqueue(std::forward<U>(message));
+  }
+
+  template<typename Backend, typename It_t>
+  static void backend_push_bulk_(Backend          &backend,
+                                 ProducerToken_t  *token,
+                                 const std::size_t lane,
+                                 It_t              first,
+                                 const std::size_t count) {
+    if constexpr(is_mpmc_<Backend>) {
+      if(token != nullptr) {
+        backend.enqueue_bulk(*token->mpmcTokens_[lane], first, count);
+        return;
+      }
+    }
+    backend.enqueue_bulk(first, count);
+  }
+
+  template<typename Backend>
+  static bool backend_pop_(Backend          &backend,
+                           ConsumerToken_t  *token,
+                           const std::size_t lane,
+                           T                &out) {
+    if constexpr(is_mpmc_<Backend>) {
+      if(token != nullptr) {
+        return backend.try_dequeue(*token->mpmcTokens_[lane], out);
+      }
+    }
+    return backend.try_dequeue(out);
+  }
+
+  template<typename Backend, typename It_t>
+  static std::size_t backend_pop_bulk_(Backend          &backend,
+                                       ConsumerToken_t  *token,
+                                       const std::size_t lane,
+                                       It_t              out,
+                                       const std::size_t max) {
+    if constexpr(is_mpmc_<Backend>) {
+      if(token != nullptr) {
+        return backend.try_dequeue_bulk(*token->mpmcTokens_[lane], out, max);
+      }
+    }
+    return backend.try_dequeue_bulk(out, max);
+  }
+
+  template<typename U>
+  bool enqueue_(ProducerToken_t *token, const Priority priority, U &&message) {
+    if(config_.capacity > 0 && !admit_()) {
+      return false;
+    }
+
+    const std::size_t lane = lane_of_(priority);
+    on_enqueued_(1, lane);
+    run_tap_(message, priority);
+    std::visit(
+      [&](auto &backend) { backend_push_(backend, token, lane, std::forward<U>(message)); },
+      *lanes_[lane]);
+    signal_waiters_();
+    return true;
+  }
+
+  template<typename Range_t>
+  std::size_t enqueue_range_(ProducerToken_t *token, const Priority priority, Range_t &&messages) {
+    const auto count = static_cast<std::size_t>(std::ranges::size(messages));
+
+    // Views don't own their elements, so only containers handed over as rvalues are fair game
+    if constexpr(std::is_rvalue_reference_v<Range_t &&>
+                 && !std::ranges::view<std::remove_cvref_t<Range_t>>)
+    {
+      return enqueue_bulk_(
+        token, priority, std::make_move_iterator(std::ranges::begin(messages)), count);
+    }
+    else {
+      return enqueue_bulk_(token, priority, std::ranges::begin(messages), count);
+    }
+  }
+
+  template<typename It_t>
+  std::size_t enqueue_bulk_(ProducerToken_t  *token,
+                            const Priority    priority,
+                            It_t              first,
+                            const std::size_t count) {
+    const std::size_t lane     = lane_of_(priority);
+    Backend_t        &messages = *lanes_[lane];
+
+    if(config_.capacity == 0) {
+      on_enqueued_(count, lane);
+      run_tap_bulk_(first, count, priority);
+      std::visit([&](auto &backend) { backend_push_bulk_(backend, token, lane, first, count); },
+                 messages);
+      signal_waiters_();
+      return count;
+    }
+
+    // Push as much as fits in one go, then let the overflow policy handle the remainder one
+    // message at a time
+    const std::size_t granted = reserve_up_to_(count);
+    if(granted > 0) {
+      on_enqueued_(granted, lane);
+      run_tap_bulk_(first, granted, priority);
+      std::visit(
+        [&](auto &backend) { backend_push_bulk_(backend, token, lane, first, granted); },
+        messages);
+    }
+
+    std::size_t accepted = granted;
+    std::advance(first, granted);
+    for(std::size_t i = granted; i < count; ++i, ++first) {
+      if(admit_()) {
+        on_enqueued_(1, lane);
+        run_tap_(*first, priority);
+        std::visit([&](auto &backend) { backend_push_(backend, token, lane, *first); }, messages);
+        ++accepted;
+      }
+    }
+
+    if(accepted > 0) {
+      signal_waiters_();
+    }
+
+    return accepted;
+  }
+
+  /**
+   * Drain lanes from the top. Whenever a message (or batch) from a lower lane has been handled and
+   * a higher lane has filled up in the meantime, start over from the top.
+   */
+  template<typename Callback_t>
+  void drain_(ConsumerToken_t *token, const Callback_t &callback) {
+    note_depth_();
+
+    T           msg;
+    std::size_t lane = 0;
+    while(lane < config_.lanes) {
+      const bool preempted = std::visit(
+        [&](auto &backend) {
+          while(backend_pop_(backend, token, lane, msg)) {
+            on_dequeued_(1, lane);
+            callback(msg);
+            if(higher_lanes_pending_(lane)) {
+              return true;
+            }
+          }
+          return false;
+        },
+        *lanes_[lane]);
+
+      lane = preempted ? 0 : lane + 1;
+    }
+  }
+
+  template<typename Callback_t>
+  void drain_bulk_(ConsumerToken_t *token, std::span<T> buffer, const Callback_t &callback) {
+    assert(!buffer.empty());
+    note_depth_();
+
+    std::size_t lane = 0;
+    while(lane < config_.lanes) {
+      const bool preempted = std::visit(
+        [&](auto &backend) {
+          while(true) {
+            const std::size_t count =
+              backend_pop_bulk_(backend, token, lane, buffer.begin(), buffer.size());
+            if(count == 0) {
+              return false;
+            }
+
+            on_dequeued_(count, lane);
+            callback(buffer.first(count));
+            if(higher_lanes_pending_(lane)) {
+              return true;
+            }
+          }
+        },
+        *lanes_[lane]);
+
+      lane = preempted ? 0 : lane + 1;
+    }
+  }
+
+  /**
+   * Claim room for up to `count` messages in a bounded queue. Returns how many were claimed.
+   */
+  std::size_t reserve_up_to_(const std::size_t count) {
+    std::size_t depth   = depth_.load(std::memory_order::relaxed);
+    std::size_t granted = 0;
+    do {
+      granted = depth < config_.capacity ? std::min(count, config_.capacity - depth) : 0;
+      if(granted == 0) {
+        return 0;
+      }
+    } while(!depth_.compare_exchange_weak(depth, depth + granted, std::memory_order::relaxed));
+
+    return granted;
+  }
+
+  /**
+   * Claim room for one message in a bounded queue, applying the overflow policy if it's full.
+   * Returns false if the message should not be enqueued.
+   */
+  bool admit_() {
+    bool waited = false;
+
+    while(reserve_up_to_(1) == 0) {
+      switch(config_.overflow) {
+        case OverflowPolicy::Fail:
+          rejected_.fetch_add(1, std::memory_order::relaxed);
+          return false;
+
+        case OverflowPolicy::DropNewest:
+          dropped_.fetch_add(1, std::memory_order::relaxed);
+          return false;
+
+        case OverflowPolicy::OverwriteOldest:
+          // The evicted message's room is handed straight to the new one. If a consumer beat us to
+          // it then there should be room now, so just try again.
+          if(evict_oldest_()) {
+            dropped_.fetch_add(1, std::memory_order::relaxed);
+            return true;
+          }
+          break;
+
+        case OverflowPolicy::Block:
+          if(!waited) {
+            blocked_.fetch_add(1, std::memory_order::relaxed);
+            waited = true;
+          }
+          if(const auto depth = depth_.load(std::memory_order::relaxed);
+             depth >= config_.capacity)
+          {
+            depth_.wait(depth, std::memory_order::relaxed);
+          }
+          break;
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * Dequeue and discard a message from the lowest non-empty lane of an MPMC queue
+   */
+  bool evict_oldest_() {
+    T victim;
+    for(std::size_t lane = config_.lanes; lane-- > 0;) {
+      if(std::get<Mpmc_t>(*lanes_[lane]).try_dequeue(victim)) {
+        // Keep the lane's sample sequence in step with its messages
+        if(latency_ != nullptr) {
+          latency_->lanes[lane].dequeued.fetch_add(1, std::memory_order::relaxed);
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Wake any consumers parked in wait_until_any or notify_when_any. Permits are only posted once
+   * per park, by whichever producer flips wakePosted_, so a burst of writes doesn't leave a permit
+   * per message behind. The few that can still go unused (a waiter timing out, or finding a message
+   * before it blocks) cost a later waiter one extra check of the queue each.
+   */
+  void signal_waiters_() {
+    detail_::full_fence(parkedWaiters_);
+    if(parkedWaiters_.load(std::memory_order::relaxed) > 0
+       && !wakePosted_.load(std::memory_order::relaxed)
+       && !wakePosted_.exchange(true, std::memory_order::seq_cst))
+    {
+      // Count the waiters again: any that parked since the check above have re-armed the wake-up,
+      // and are only covered by this one
+      wakeSignal_.release(
+        static_cast<std::ptrdiff_t>(parkedWaiters_.load(std::memory_order::seq_cst)));
+    }
+    if(asyncWaiters_.load(std::memory_order::relaxed) > 0) [[unlikely]] {
+      wake_async_waiters_();
+    }
+  }
+
+  /**
+   * Run (and forget) every pending notify_when_any callback, outside the lock so that callbacks may
+   * register again right away
+   */
+  void wake_async_waiters_() {
+    std::vector<std::function<void()>> callbacks;
+    {
+      const std::scoped_lock asyncLock(asyncMutex_);
+      callbacks.swap(asyncCallbacks_);
+      asyncWaiters_.fetch_sub(static_cast<U32>(callbacks.size()), std::memory_order::relaxed);
+    }
+
+    for(const auto &callback : callbacks) {
+      callback();
+    }
+  }
+
+  /**
+   * Bookkeeping for `count` messages about to go into the queue
+   */
+  void on_enqueued_(const std::size_t count, const std::size_t lane) {
+    enqueued_[detail_::thread_stripe() % ENQUEUE_STRIPES].value.fetch_add(
+      count, std::memory_order::relaxed);
+    if(latency_ != nullptr) {
+      stamp_latency_samples_(lane, count);
+    }
+  }
+
+  void run_tap_(const T &message, const Priority priority) {
+    if(tapped_.load(std::memory_order::relaxed)) [[unlikely]] {
+      const U32 parity  = tapEpoch_.load(std::memory_order::seq_cst) & 1U;
+      auto     &readers = tapReaders_[detail_::thread_stripe() % ENQUEUE_STRIPES].count[parity];
+      readers.fetch_add(1, std::memory_order::seq_cst);
+      const defer leave([&] { readers.fetch_sub(1, std::memory_order::release); });
+
+      if(const Tap_t *tap = tap_.load(std::memory_order::seq_cst); tap != nullptr) {
+        (*tap)(message, priority);
+      }
+    }
+  }
+
+  template<typename It_t>
+  void run_tap_bulk_(It_t first, const std::size_t count, const Priority priority) {
+    if(tapped_.load(std::memory_order::relaxed)) [[unlikely]] {
+      for(std::size_t i = 0; i < count; ++i, ++first) {
+        run_tap_(*first, priority);
+      }
+    }
+  }
+
+  /**
+   * Bookkeeping for `count` messages taken out of the queue; in bounded queues this gives back
+   * their room
+   */
+  void on_dequeued_(const std::size_t count, const std::size_t lane) {
+    if(config_.capacity > 0) {
+      depth_.fetch_sub(count, std::memory_order::relaxed);
+      if(config_.overflow == OverflowPolicy::Block) {
+        depth_.notify_all();
+      }
+    }
+
+    dequeued_.fetch_add(count, std::memory_order::relaxed);
+    if(latency_ != nullptr) {
+      record_latency_samples_(lane, count);
+    }
+  }
+
+  /**
+   * Raise the high-water mark to the current depth, if needed. Drains check the depth when they
+   * start, and peek() (which take_bulk() and the awaitables go through) on its first call after
+   * finding the queue empty and every PEEK_DEPTH_INTERVAL calls after that.
+   */
+  void note_depth_() {
+    const std::size_t depth = size_approx();
+    std::size_t       mark  = highWaterMark_.load(std::memory_order::relaxed);
+    while(depth > mark
+          && !highWaterMark_.compare_exchange_weak(mark, depth, std::memory_order::relaxed))
+    {
+    }
+  }
+
+  static S64 latency_clock_() {
+    return std::chrono::duration_cast<Duration_t>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+  }
+
+  /**
+   * First sampled sequence number in [first, first + count), or first + count if there is none
+   */
+  U64 first_sample_(const U64 first, const std::size_t count) const {
+    const U64 interval = config_.latencySampleInterval;
+    return std::min<U64>((first + interval - 1) / interval * interval, first + count);
+  }
+
+  std::atomic<S64> &latency_stamp_(const std::size_t lane, const U64 seq) {
+    return latency_->lanes[lane]
+      .stamps[(seq / config_.latencySampleInterval) % LatencySampler_::STAMPS];
+  }
+
+  void stamp_latency_samples_(const std::size_t lane, const std::size_t count) {
+    const U64 first = latency_->lanes[lane].enqueued.fetch_add(count, std::memory_order::relaxed);
+    U64       seq   = first_sample_(first, count);
+    if(seq == first + count) {
+      return;
+    }
+
+    const S64 now = latency_clock_();
+    for(; seq < first + count; seq += config_.latencySampleInterval) {
+      latency_stamp_(lane, seq).store(now, std::memory_order::relaxed);
+    }
+  }
+
+  void record_latency_samples_(const std::size_t lane, const std::size_t count) {
+    auto     &sequences = latency_->lanes[lane];
+    const U64 first     = sequences.dequeued.fetch_add(count, std::memory_order::relaxed);
+    U64       seq       = first_sample_(first, count);
+    if(seq == first + count) {
+      return;
+    }
+
+    const S64 now    = latency_clock_();
+    const U64 window = U64{LatencySampler_::STAMPS} * config_.latencySampleInterval;
+    for(; seq < first + count; seq += config_.latencySampleInterval) {
+      // A consumer that lags too far behind may find its stamp overwritten by a later sample
+      if(sequences.enqueued.load(std::memory_order::relaxed) - seq >= window) {
+        continue;
+      }
+
+      if(const S64 stamp = latency_stamp_(lane, seq).exchange(0, std::memory_order::relaxed);
+         stamp != 0)
+      {
+        const std::size_t bucket = LatencyHistogram::bucket_of(Duration_t(now - stamp));
+        latency_->counts[bucket].fetch_add(1, std::memory_order::relaxed);
+      }
+    }
+  }
+
+  detail_::EndpointLease claim_endpoint_(std::atomic<U32> &count, std::string_view kind) {
+    if(count.fetch_add(1, std::memory_order::acq_rel) != 0) {
+      count.fetch_sub(1, std::memory_order::acq_rel);
+      throw std::runtime_error(
+        std::format("MessageQueue {} only supports a single {} endpoint", name_, kind));
+    }
+    return detail_::EndpointLease(count);
+  }
+
+  std::array<std::optional<Backend_t>, PRIORITY_LANES> lanes_;
+
+  ILogger          &logger_;
+  const std::string name_;
+  const QueueConfig config_;
+
+  std::atomic<U32> producerEndpoints_{0};
+  std::atomic<U32> consumerEndpoints_{0};
+
+  alignas(CACHE_LINE_SIZE) std::atomic<U32> parkedWaiters_{0};
+  std::atomic<bool>         wakePosted_{false};
+  std::counting_semaphore<> wakeSignal_{0};
+
+  std::atomic<U32>                   asyncWaiters_{0};
+  std::mutex                         asyncMutex_;
+  std::vector<std::function<void()>> asyncCallbacks_;
+
+  // Only used by bounded queues
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> depth_{0};
+  std::atomic<U64> dropped_{0};
+  std::atomic<U64> rejected_{0};
+  std::atomic<U64> blocked_{0};
+
+  // Telemetry; each counter sits on the side that writes it
+  static constexpr std::size_t ENQUEUE_STRIPES     = 8;
+  static constexpr U32         PEEK_DEPTH_INTERVAL = 64;
+
+  struct alignas(CACHE_LINE_SIZE) StripedCounter_ {
+    std::atomic<U64> value{0};
+  };
+
+  std::array<StripedCounter_, ENQUEUE_STRIPES> enqueued_;
+  alignas(CACHE_LINE_SIZE) std::atomic<U64> dequeued_{0};
+  std::atomic<std::size_t> highWaterMark_{0};
+
+  struct LatencySampler_ {
+    static constexpr std::size_t STAMPS = 64;
+
+    // Sequence numbers are per lane, since draining reorders messages across lanes
+    struct Lane_ {
+      alignas(CACHE_LINE_SIZE) std::atomic<U64> enqueued{0};
+      alignas(CACHE_LINE_SIZE) std::atomic<U64> dequeued{0};
+
+      // Enqueue time of recent sampled sequence numbers, or 0 once consumed
+      std::array<std::atomic<S64>, STAMPS> stamps{};
+    };
+
+    std::array<Lane_, PRIORITY_LANES>                       lanes;
+    std::array<std::atomic<U64>, LatencyHistogram::BUCKETS> counts{};
+  };
+
+  std::unique_ptr<LatencySampler_> latency_;
+
+  // Set while a tap is installed, so producers can skip the rest otherwise
+  std::atomic<bool> tapped_{false};
+
+  struct alignas(CACHE_LINE_SIZE) TapReaders_ {
+    std::array<std::atomic<U32>, 2> count{};
+  };
+
+  std::array<TapReaders_, ENQUEUE_STRIPES> tapReaders_;
+  std::atomic<U32>                         tapEpoch_{0};
+  std::atomic<const Tap_t *>               tap_{nullptr};
+
+  // Only touched by set_tap()
+  std::mutex                   tapMutex_;
+  std::unique_ptr<const Tap_t> ownedTap_;
 };
 
 }  // namespace mgfw
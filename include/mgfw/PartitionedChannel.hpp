@@ -0,0 +1,146 @@
+#pragma once
+
+#include "mgfw/ConflatingChannel.hpp"
+#include "mgfw/EventReader.hpp"
+#include "mgfw/EventWriter.hpp"
+#include "mgfw/ILogger.hpp"
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/types.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace mgfw {
+
+/**
+ * Creation-time options for a PartitionedChannel
+ */
+struct PartitionConfig {
+  static constexpr std::size_t DEFAULT_PARTITIONS = 8;
+
+  std::size_t partitions = DEFAULT_PARTITIONS;
+
+  // Applied to each partition's queue. Every partition has a single consumer, so MPSC is the
+  // natural backend.
+  QueueConfig queue{.backend = QueueBackend::MPSC};
+};
+
+/**
+ * Channel split into a fixed number of MessageQueues ("partitions"), with messages routed by the
+ * hash of a key extracted by KeyFn_t.
+ *
+ * Each partition is meant to be drained by exactly one consumer, so all messages for a given key
+ * are processed in the order they were written (per writer and priority lane, as with any
+ * MessageQueue), while adding partitions and consumers scales throughput. Writers hold an endpoint
+ * on every partition and route messages without any shared lock.
+ */
+template<MessageType T, MessageKeyExtractor<T> KeyFn_t>
+class PartitionedChannel {
+public:
+  PartitionedChannel(ILogger &logger, const U64 id, const PartitionConfig &config = {}) {
+    if(config.partitions == 0) {
+      throw std::invalid_argument(
+        std::format("PartitionedChannel {} needs at least one partition", id));
+    }
+
+    partitions_.reserve(config.partitions);
+    for(std::size_t i = 0; i < config.partitions; ++i) {
+      partitions_.push_back(std::make_unique<MessageQueue<T>>(
+        logger, id, config.queue, std::format("partition {}", i)));
+    }
+  }
+
+  PartitionedChannel(const PartitionedChannel &)            = delete;
+  PartitionedChannel &operator=(const PartitionedChannel &) = delete;
+  PartitionedChannel(PartitionedChannel &&)                 = delete;
+  PartitionedChannel &operator=(PartitionedChannel &&)      = delete;
+  ~PartitionedChannel()                                     = default;
+
+  std::size_t partitions() const { return partitions_.size(); }
+
+  std::size_t partition_of(const T &message) const {
+    return std::hash<MessageKey_t<KeyFn_t, T>>{}(keyFn_(message)) % partitions_.size();
+  }
+
+  MessageQueue<T> &partition(const std::size_t index) {
+    if(index >= partitions_.size()) {
+      throw std::out_of_range(std::format(
+        "Partition {} requested from a channel with {} partitions", index, partitions_.size()));
+    }
+    return *partitions_[index];
+  }
+
+  /**
+   * Totals over all partitions; latency histograms are merged bucket by bucket
+   */
+  QueueStats stats() const {
+    QueueStats total;
+    for(const auto &queue : partitions_) {
+      const QueueStats stats = queue->stats();
+
+      total.enqueued += stats.enqueued;
+      total.dequeued += stats.dequeued;
+      total.depth += stats.depth;
+      total.overflow.dropped += stats.overflow.dropped;
+      total.overflow.rejected += stats.overflow.rejected;
+      total.overflow.blocked += stats.overflow.blocked;
+
+      total.highWaterMark = std::max(total.highWaterMark, stats.highWaterMark);
+
+      if(stats.latency) {
+        LatencyHistogram &histogram = total.latency ? *total.latency : total.latency.emplace();
+        for(std::size_t i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+          histogram.counts[i] += stats.latency->counts[i];
+        }
+      }
+    }
+    return total;
+  }
+
+private:
+  const KeyFn_t                                 keyFn_{};
+  std::vector<std::unique_ptr<MessageQueue<T>>> partitions_;
+};
+
+/**
+ * Write-only sender end of a PartitionedChannel, holding a producer endpoint on every partition
+ */
+template<MessageType T, MessageKeyExtractor<T> KeyFn_t>
+class PartitionedWriter {
+public:
+  explicit PartitionedWriter(PartitionedChannel<T, KeyFn_t> &channel) : channel_(channel) {
+    writers_.reserve(channel.partitions());
+    for(std::size_t i = 0; i < channel.partitions(); ++i) {
+      writers_.emplace_back(channel.partition(i));
+    }
+  }
+
+  PartitionedWriter(const PartitionedWriter &)            = delete;
+  PartitionedWriter &operator=(const PartitionedWriter &) = delete;
+  PartitionedWriter(PartitionedWriter &&)                 = default;
+  PartitionedWriter &operator=(PartitionedWriter &&)      = default;
+  ~PartitionedWriter()                                    = default;
+
+  /**
+   * Route a message to its key's partition; see EventWriter::write
+   */
+  bool write(const T &message, const Priority priority = Priority::Normal) {
+    return writers_[channel_.partition_of(message)].write(message, priority);
+  }
+
+  bool write(T &&message, const Priority priority = Priority::Normal) {
+    return writers_[channel_.partition_of(message)].write(std::move(message), priority);
+  }
+
+private:
+  PartitionedChannel<T, KeyFn_t> &channel_;
+  std::vector<EventWriter<T>>     writers_;
+};
+
+}  // namespace mgfw
@@ -0,0 +1,343 @@
+#pragma once
+
+#include "mgfw/EventReader.hpp"
+#include "mgfw/EventWriter.hpp"
+#include "mgfw/ILogger.hpp"
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/WorkerPool.hpp"
+#include "mgfw/types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <format>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mgfw {
+
+struct StageConfig {
+  // Only used for stats and log messages
+  std::string name;
+
+  // Batches of this stage that may be processed at the same time; above 1, the stage function must
+  // be safe to call concurrently
+  std::size_t parallelism = 1;
+
+  // Messages taken from the input per job
+  std::size_t batchSize = 64;
+
+  // Write outputs in input order even when batches finish out of order. Unordered stages write each
+  // batch as soon as it's done.
+  bool ordered = true;
+};
+
+/**
+ * Running totals for one pipeline stage. A stage whose backlog keeps growing while it stays busy is
+ * the bottleneck.
+ */
+struct StageStats {
+  std::string name;
+  U64         processed = 0;  // Messages taken from the input
+  U64         emitted   = 0;  // Messages accepted by the output queue
+  U64         failed    = 0;  // Messages in batches whose stage function threw
+  std::size_t backlog   = 0;  // Approximate number of messages waiting in the input
+  Duration_t  busy{};         // Time spent in the stage function, summed over all workers
+};
+
+/**
+ * A graph of stages, each reading messages from an EventReader, passing them through a function,
+ * and (unless it's a sink) writing the results to an EventWriter. Stages are chained by connecting
+ * one stage's output queue to the next one's input.
+ *
+ * All stages run as jobs on a shared WorkerPool. A stage with nothing to read parks on its input
+ * queue (see MessageQueue::notify_when_any) rather than polling. Each job takes one batch, so busy
+ * stages take turns on the workers. If a stage function throws, the error is logged and the rest of
+ * its batch is dropped.
+ *
+ * The queues behind the stages' readers and writers must outlive the pipeline.
+ */
+class Pipeline {
+public:
+  Pipeline(ILogger &logger, const std::size_t workers)
+    : logger_(logger), pool_(std::make_shared<WorkerPool>(logger, workers)) { }
+
+  Pipeline(const Pipeline &)            = delete;
+  Pipeline &operator=(const Pipeline &) = delete;
+  Pipeline(Pipeline &&)                 = delete;
+  Pipeline &operator=(Pipeline &&)      = delete;
+
+  ~Pipeline() { stop(); }
+
+  /**
+   * Add a stage that maps each message of `input` to one message of `output`
+   */
+  template<MessageType In, MessageType Out, typename Fn_t>
+  requires std::convertible_to<std::invoke_result_t<Fn_t &, In &&>, Out>
+  Pipeline &add_stage(EventReader<In>  input,
+                      Fn_t             fn,
+                      EventWriter<Out> output,
+                      StageConfig      config = {}) {
+    return add_(std::make_shared<Stage_<In, Out, Fn_t>>(
+      logger_, pool_, std::move(input), std::move(fn), std::move(output), std::move(config)));
+  }
+
+  /**
+   * Add a final stage that consumes each message of `input`
+   */
+  template<MessageType In, typename Fn_t>
+  requires std::invocable<Fn_t &, In &&>
+  Pipeline &add_sink(EventReader<In> input, Fn_t fn, StageConfig config = {}) {
+    return add_(std::make_shared<Stage_<In, void, Fn_t>>(
+      logger_, pool_, std::move(input), std::move(fn), std::nullopt, std::move(config)));
+  }
+
+  /**
+   * Start running every stage; stages can't be added afterwards
+   */
+  void start() {
+    if(started_) {
+      throw std::logic_error("Pipeline already started");
+    }
+    started_ = true;
+
+    for(const auto &stage : stages_) {
+      stage->start();
+    }
+  }
+
+  /**
+   * Stop every stage, letting batches that are already being processed finish. Messages left in
+   * the queues stay there.
+   */
+  void stop() {
+    for(const auto &stage : stages_) {
+      stage->stop();
+    }
+    pool_->stop();
+  }
+
+  std::vector<StageStats> stats() const {
+    std::vector<StageStats> result;
+    result.reserve(stages_.size());
+    for(const auto &stage : stages_) {
+      result.push_back(stage->stats());
+    }
+    return result;
+  }
+
+private:
+  class StageBase_ {
+  public:
+    StageBase_()          = default;
+    virtual ~StageBase_() = default;
+
+    StageBase_(const StageBase_ &)            = delete;
+    StageBase_ &operator=(const StageBase_ &) = delete;
+    StageBase_(StageBase_ &&)                 = delete;
+    StageBase_ &operator=(StageBase_ &&)      = delete;
+
+    virtual void       start()       = 0;
+    virtual void       stop()        = 0;
+    virtual StageStats stats() const = 0;
+  };
+
+  // Out is void for sinks
+  template<MessageType In, typename Out, typename Fn_t>
+  class Stage_ : public StageBase_, public std::enable_shared_from_this<Stage_<In, Out, Fn_t>> {
+    static constexpr bool IS_SINK = std::is_void_v<Out>;
+
+    struct NoOutput_ { };
+
+    using Output_t = std::conditional_t<IS_SINK, NoOutput_, Out>;
+    using Writer_t = std::conditional_t<IS_SINK, NoOutput_, EventWriter<Output_t>>;
+
+  public:
+    Stage_(ILogger                    &logger,
+           std::shared_ptr<WorkerPool> pool,
+           EventReader<In>             input,
+           Fn_t                        fn,
+           std::optional<Writer_t>     output,
+           StageConfig                 config)
+      : logger_(logger),
+        pool_(std::move(pool)),
+        config_(std::move(config)),
+        fn_(std::move(fn)),
+        input_(std::move(input)),
+        output_(std::move(output)) {
+      if(config_.parallelism == 0 || config_.batchSize == 0) {
+        throw std::invalid_argument(std::format(
+          "Pipeline stage '{}' needs a positive parallelism and batch size", config_.name));
+      }
+    }
+
+    void start() override {
+      for(std::size_t i = 0; i < config_.parallelism; ++i) {
+        schedule_();
+      }
+    }
+
+    void stop() override { stopped_.store(true, std::memory_order::relaxed); }
+
+    StageStats stats() const override {
+      return {
+        .name      = config_.name,
+        .processed = processed_.load(std::memory_order::relaxed),
+        .emitted   = emitted_.load(std::memory_order::relaxed),
+        .failed    = failed_.load(std::memory_order::relaxed),
+        .backlog   = input_.size_approx(),
+        .busy      = Duration_t(busyNs_.load(std::memory_order::relaxed)),
+      };
+    }
+
+  private:
+    /**
+     * Queue one job for this stage. Jobs only hold a weak reference, so that jobs and callbacks
+     * outstanding when the pipeline goes away become no-ops.
+     */
+    void schedule_() {
+      pool_->do_now([weakSelf = this->weak_from_this()] {
+        if(const auto self = weakSelf.lock()) {
+          self->run_batch_();
+        }
+      });
+    }
+
+    void park_() {
+      input_.notify_when_any([weakSelf = this->weak_from_this()] {
+        if(const auto self = weakSelf.lock()) {
+          self->schedule_();
+        }
+      });
+    }
+
+    void run_batch_() {
+      if(stopped_.load(std::memory_order::relaxed)) {
+        return;
+      }
+
+      std::vector<In> batch;
+      U64             seq = 0;
+      {
+        const std::scoped_lock inputLock(inputMutex_);
+        if(input_.take_bulk(batch, config_.batchSize) == 0) {
+          park_();
+          return;
+        }
+        seq = nextInputSeq_++;
+      }
+      processed_.fetch_add(batch.size(), std::memory_order::relaxed);
+
+      std::vector<Output_t> results;
+      if constexpr(!IS_SINK) {
+        results.reserve(batch.size());
+      }
+
+      std::size_t done    = 0;
+      const auto  started = std::chrono::steady_clock::now();
+      try {
+        for(; done < batch.size(); ++done) {
+          if constexpr(IS_SINK) {
+            fn_(std::move(batch[done]));
+          }
+          else {
+            results.emplace_back(fn_(std::move(batch[done])));
+          }
+        }
+      }
+      catch(const std::exception &e) {
+        fail_(batch.size() - done, e.what());
+      }
+      catch(...) {
+        fail_(batch.size() - done, "unknown exception");
+      }
+      busyNs_.fetch_add(
+        static_cast<U64>(std::chrono::duration_cast<Duration_t>(std::chrono::steady_clock::now()
+                                                                - started)
+                           .count()),
+        std::memory_order::relaxed);
+
+      if constexpr(!IS_SINK) {
+        publish_(seq, std::move(results));
+      }
+
+      // Carry on in a fresh job, so other stages get a turn
+      schedule_();
+    }
+
+    void fail_(const std::size_t dropped, const std::string_view what) {
+      failed_.fetch_add(dropped, std::memory_order::relaxed);
+      logger_.error(
+        std::format("Pipeline stage '{}' dropped {} message(s): {}", config_.name, dropped, what));
+    }
+
+    void publish_(const U64 seq, std::vector<Output_t> results) {
+      const std::scoped_lock outputLock(outputMutex_);
+
+      if(!config_.ordered) {
+        write_(std::move(results));
+        return;
+      }
+
+      // Hold on to batches that finished early until their predecessors are written
+      pending_.emplace(seq, std::move(results));
+      while(!pending_.empty() && pending_.begin()->first == nextOutputSeq_) {
+        write_(std::move(pending_.begin()->second));
+        pending_.erase(pending_.begin());
+        ++nextOutputSeq_;
+      }
+    }
+
+    void write_(std::vector<Output_t> &&results) {
+      if(!results.empty()) {
+        emitted_.fetch_add(output_->write_bulk(std::move(results)), std::memory_order::relaxed);
+      }
+    }
+
+    ILogger                    &logger_;
+    std::shared_ptr<WorkerPool> pool_;
+    const StageConfig           config_;
+    Fn_t                        fn_;
+
+    std::mutex      inputMutex_;
+    EventReader<In> input_;
+    U64             nextInputSeq_ = 0;
+
+    std::mutex                           outputMutex_;
+    std::optional<Writer_t>              output_;
+    U64                                  nextOutputSeq_ = 0;
+    std::map<U64, std::vector<Output_t>> pending_;
+
+    std::atomic<bool> stopped_{false};
+    std::atomic<U64>  processed_{0};
+    std::atomic<U64>  emitted_{0};
+    std::atomic<U64>  failed_{0};
+    std::atomic<U64>  busyNs_{0};
+  };
+
+  Pipeline &add_(std::shared_ptr<StageBase_> stage) {
+    if(started_) {
+      throw std::logic_error("Can't add stages to a running pipeline");
+    }
+    stages_.push_back(std::move(stage));
+    return *this;
+  }
+
+  ILogger                                 &logger_;
+  std::shared_ptr<WorkerPool>              pool_;
+  std::vector<std::shared_ptr<StageBase_>> stages_;
+  bool                                     started_ = false;
+};
+
+}  // namespace mgfw
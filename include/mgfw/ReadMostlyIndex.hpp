@@ -0,0 +1,125 @@
+#pragma once
+
+#include "mgfw/types.hpp"
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace mgfw {
+
+/**
+ * Map from U64 keys to pointers, for lookups that vastly outnumber inserts.
+ *
+ * Lookups are lock-free: the entries live in an open-addressing table published through an atomic
+ * pointer. Inserts fill empty slots in place, which is safe because entries are never removed or
+ * changed. When the table gets half full, a table of twice the size is built and published in its
+ * place. Replaced tables are kept until the index is destroyed, since concurrent lookups may still
+ * be probing them; as sizes double, this at most doubles the memory used.
+ *
+ * Inserts must be serialized by the caller (e.g. under the lock guarding whatever owns the
+ * values), and a key must only be inserted once.
+ */
+template<typename Value_t>
+class ReadMostlyIndex {
+public:
+  static constexpr std::size_t INITIAL_CAPACITY = 64;
+
+  ReadMostlyIndex() : current_(add_table_(INITIAL_CAPACITY)) { }
+
+  ReadMostlyIndex(const ReadMostlyIndex &)            = delete;
+  ReadMostlyIndex &operator=(const ReadMostlyIndex &) = delete;
+  ReadMostlyIndex(ReadMostlyIndex &&)                 = delete;
+  ReadMostlyIndex &operator=(ReadMostlyIndex &&)      = delete;
+  ~ReadMostlyIndex()                                  = default;
+
+  /**
+   * The value for `key`, or nullptr if it hasn't been inserted (yet). May be called from any
+   * thread, concurrently with insert().
+   */
+  Value_t *find(const U64 key) const noexcept {
+    const Table_ *table = current_.load(std::memory_order::acquire);
+    for(std::size_t i = slot_of_(key, table->mask);; i = (i + 1) & table->mask) {
+      const Slot_ &slot  = table->slots[i];
+      Value_t     *value = slot.value.load(std::memory_order::acquire);
+      if(value == nullptr) {
+        return nullptr;
+      }
+      // The key was written before the value was published, and never changes afterwards
+      if(slot.key == key) {
+        return value;
+      }
+    }
+  }
+
+  void insert(const U64 key, Value_t *value) {
+    Table_ *table = current_.load(std::memory_order::relaxed);
+    if((size_ + 1) * 2 > table->mask + 1) {
+      table = grow_(*table);
+    }
+
+    place_(*table, key, value);
+    ++size_;
+  }
+
+  std::size_t size() const { return size_; }
+
+private:
+  struct Slot_ {
+    U64                    key = 0;
+    std::atomic<Value_t *> value{nullptr};
+  };
+
+  struct Table_ {
+    explicit Table_(const std::size_t capacity)
+      : mask(capacity - 1), slots(std::make_unique<Slot_[]>(capacity)) { }
+
+    const std::size_t        mask;
+    std::unique_ptr<Slot_[]> slots;
+  };
+
+  static std::size_t slot_of_(const U64 key, const std::size_t mask) noexcept {
+    // splitmix64's finalizer, since channel IDs tend to be small and sequential
+    U64 hash = key;
+    hash     = (hash ^ (hash >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    hash     = (hash ^ (hash >> 27U)) * 0x94D049BB133111EBULL;
+    hash     = hash ^ (hash >> 31U);
+    return static_cast<std::size_t>(hash) & mask;
+  }
+
+  static void place_(Table_ &table, const U64 key, Value_t *value) {
+    std::size_t i = slot_of_(key, table.mask);
+    while(table.slots[i].value.load(std::memory_order::relaxed) != nullptr) {
+      i = (i + 1) & table.mask;
+    }
+
+    table.slots[i].key = key;
+    table.slots[i].value.store(value, std::memory_order::release);
+  }
+
+  Table_ *add_table_(const std::size_t capacity) {
+    tables_.push_back(std::make_unique<Table_>(std::bit_ceil(capacity)));
+    return tables_.back().get();
+  }
+
+  Table_ *grow_(const Table_ &old) {
+    Table_ *table = add_table_((old.mask + 1) * 2);
+    for(std::size_t i = 0; i <= old.mask; ++i) {
+      if(Value_t *value = old.slots[i].value.load(std::memory_order::relaxed); value != nullptr) {
+        place_(*table, old.slots[i].key, value);
+      }
+    }
+
+    current_.store(table, std::memory_order::release);
+    return table;
+  }
+
+  // Every table ever published, the current one last
+  std::vector<std::unique_ptr<Table_>> tables_;
+  std::atomic<Table_ *>                current_;
+  std::size_t                          size_ = 0;
+};
+
+}  // namespace mgfw
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "mgfw/Coroutine.hpp"
+#include "mgfw/EventReader.hpp"
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/defer.hpp"
+#include "mgfw/types.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace mgfw {
+
+/**
+ * Drains an EventReader on an Executor (e.g. a Scheduler) whenever messages arrive, instead of
+ * polling it with Scheduler::set_interval.
+ *
+ * While the reader's queue is empty, the job is parked on it (see MessageQueue::notify_when_any),
+ * and the write that brings a message posts a single drain job to the executor. Writes that arrive
+ * before that job runs don't post any more, since the job only parks again once it's done. If
+ * messages came in while it was draining, parking again posts the next job right away.
+ *
+ * Destroying the job (or calling stop()) turns the drain jobs still in flight into no-ops, and
+ * waits for a drain that is already running on another thread, so the callback is no longer
+ * running once it returns. Called from the callback itself, it can't wait, and the current drain
+ * simply runs to completion. The reader's queue and the executor must outlive the job.
+ */
+template<MessageType T>
+class ReaderJob {
+public:
+  template<Executor Executor_t, MessageDrainCallback<T> Callback>
+  ReaderJob(Executor_t &executor, EventReader<T> reader, Callback callback)
+    : state_(std::make_shared<State_>(
+        [&executor](std::function<void()> job) { executor.do_now(std::move(job)); },
+        std::move(reader))) {
+    state_->drain = [&reader = state_->reader, callback = std::move(callback)]() mutable {
+      reader.drain(callback);
+    };
+    park_(state_);
+  }
+
+  ReaderJob(const ReaderJob &)            = delete;
+  ReaderJob &operator=(const ReaderJob &) = delete;
+  ReaderJob(ReaderJob &&)                 = default;
+  ReaderJob &operator=(ReaderJob &&)      = delete;
+
+  ~ReaderJob() { stop(); }
+
+  void stop() {
+    if(!state_) {
+      return;
+    }
+
+    // Set before looking for a running drain, which run_() announces before checking this
+    state_->stopped.store(true, std::memory_order::seq_cst);
+
+    std::thread::id drainer = state_->drainer.load(std::memory_order::seq_cst);
+    while(drainer != std::thread::id() && drainer != std::this_thread::get_id()) {
+      state_->drainer.wait(drainer, std::memory_order::acquire);
+      drainer = state_->drainer.load(std::memory_order::acquire);
+    }
+  }
+
+  /**
+   * Drain jobs that have run so far; always 0 for a moved-from job
+   */
+  U64 drains() const { return state_ ? state_->drains.load(std::memory_order::relaxed) : 0; }
+
+private:
+  struct State_ {
+    State_(std::function<void(std::function<void()>)> postFn, EventReader<T> &&eventReader)
+      : post(std::move(postFn)), reader(std::move(eventReader)) { }
+
+    std::function<void(std::function<void()>)> post;
+    EventReader<T>                             reader;
+    std::function<void()>                      drain;
+    std::atomic<bool>                          stopped{false};
+    std::atomic<U64>                           drains{0};
+
+    // Thread running a drain right now, if any
+    std::atomic<std::thread::id> drainer;
+  };
+
+  // Callbacks only hold weak references, so that they become no-ops once the job is gone
+  static void park_(const std::shared_ptr<State_> &state) {
+    state->reader.notify_when_any([weakState = std::weak_ptr(state)] {
+      if(const auto parked = weakState.lock(); parked && !parked->stopped) {
+        parked->post([weakState] { run_(weakState); });
+      }
+    });
+  }
+
+  static void run_(const std::weak_ptr<State_> &weakState) {
+    const auto state = weakState.lock();
+    if(!state) {
+      return;
+    }
+
+    state->drainer.store(std::this_thread::get_id(), std::memory_order::seq_cst);
+    const defer finished([&] {
+      state->drainer.store(std::thread::id(), std::memory_order::release);
+      state->drainer.notify_all();
+    });
+    if(state->stopped.load(std::memory_order::seq_cst)) {
+      return;
+    }
+
+    // Park again even if the callback throws, so the reader isn't left stranded
+    defer parkAgain([&] {
+      state->drains.fetch_add(1, std::memory_order::relaxed);
+      park_(state);
+    });
+    state->drain();
+  }
+
+  std::shared_ptr<State_> state_;
+};
+
+}  // namespace mgfw
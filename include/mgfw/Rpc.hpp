@@ -0,0 +1,424 @@
+#pragma once
+
+#include "mgfw/EventReader.hpp"
+#include "mgfw/EventWriter.hpp"
+#include "mgfw/IClock.hpp"
+#include "mgfw/MQHive.hpp"
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/types.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <expected>
+#include <format>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mgfw {
+
+/**
+ * Message sent on an RPC request channel. The correlation ID is opaque to servers, which only copy
+ * it into the response they write to the `replyTo` channel.
+ */
+template<MessageType Req>
+struct RpcRequest {
+  U64 correlationId = 0;
+  U64 replyTo       = 0;
+  Req payload{};
+};
+
+template<MessageType Resp>
+struct RpcResponse {
+  U64  correlationId = 0;
+  Resp payload{};
+};
+
+enum class RpcError {
+  TimedOut,  // No response arrived before the call's deadline
+  Rejected,  // The request queue didn't accept the request; see OverflowPolicy
+};
+
+struct RpcClientConfig {
+  // Calls that may be waiting for a response at once; their slots are allocated up front
+  std::size_t maxInFlight = 64;
+
+  Duration_t timeout = std::chrono::seconds(1);
+};
+
+/**
+ * Caller end of an RPC service: writes requests to the server's channel and matches the responses
+ * arriving on its own reply channel (one per client) back to the calls that are waiting for them.
+ *
+ * Each call takes a slot from a pool sized by RpcClientConfig::maxInFlight and returns a Future
+ * bound to it, which can be polled, waited on with get(), or co_awaited. Slots are recycled once
+ * their Future is done with, so making a call allocates nothing beyond the request message. A
+ * slot's generation is part of the correlation ID, so late responses to calls that were already
+ * given up on are discarded.
+ *
+ * Responses are only picked up, and deadlines only checked (against the given clock), when the
+ * client is pumped: by poll(), or by Future::get(). get() blocks in real-time steps of at most
+ * WAIT_STEP, checking the given clock in between, so it also keeps to deadlines on a clock that
+ * doesn't follow real time. A coroutine awaiting a call is resumed by whichever of these completes
+ * it. Like an EventReader, a client must only be used by one thread at a time, and it must outlive
+ * its Futures.
+ */
+template<MessageType Req, MessageType Resp>
+class RpcClient {
+  struct Slot_;
+
+public:
+  using Result_t = std::expected<Resp, RpcError>;
+
+  static constexpr Duration_t WAIT_STEP = std::chrono::milliseconds(1);
+
+  /**
+   * Handle on the result of one call. Dropping it gives up on the call.
+   */
+  class Future {
+  public:
+    Future(const Future &)            = delete;
+    Future &operator=(const Future &) = delete;
+
+    Future(Future &&other) noexcept
+      : client_(std::exchange(other.client_, nullptr)), index_(other.index_) { }
+
+    Future &operator=(Future &&other) noexcept {
+      if(this != &other) {
+        reset_();
+        client_ = std::exchange(other.client_, nullptr);
+        index_  = other.index_;
+      }
+      return *this;
+    }
+
+    ~Future() { reset_(); }
+
+    /**
+     * Whether the call completed, one way or the other; doesn't pump the client
+     */
+    bool ready() const { return client_ != nullptr && slot_().result.has_value(); }
+
+    /**
+     * Pump the client until the call completes, then return its result. The Future is empty
+     * afterwards.
+     */
+    Result_t get() {
+      if(client_ == nullptr) {
+        throw std::logic_error("RPC future has no call");
+      }
+
+      client_->wait_for_(index_);
+      Result_t result = std::move(*slot_().result);
+      reset_();
+      return result;
+    }
+
+    bool await_ready() const { return ready(); }
+
+    void await_suspend(const std::coroutine_handle<> handle) { slot_().waiter = handle; }
+
+    Result_t await_resume() { return get(); }
+
+  private:
+    friend class RpcClient;
+
+    Future(RpcClient &client, const U32 index) : client_(&client), index_(index) { }
+
+    Slot_ &slot_() const { return client_->slots_[index_]; }
+
+    void reset_() {
+      if(client_ != nullptr) {
+        std::exchange(client_, nullptr)->release_(index_);
+      }
+    }
+
+    RpcClient *client_ = nullptr;
+    U32        index_  = 0;
+  };
+
+  RpcClient(MQHive                &hive,
+            const U64              requestId,
+            const U64              replyId,
+            const IClock          &clock,
+            const RpcClientConfig &config = {})
+    : clock_(clock),
+      config_(config),
+      replyId_(replyId),
+      requests_(hive.get_writer<RpcRequest<Req>>(requestId)),
+      replies_(hive.get_reader<RpcResponse<Resp>>(replyId)),
+      slots_(config.maxInFlight) {
+    if(config.maxInFlight == 0 || config.maxInFlight > std::numeric_limits<U32>::max()) {
+      throw std::invalid_argument(
+        std::format("RpcClient on channel {} can't have {} calls in flight",
+                    requestId,
+                    config.maxInFlight));
+    }
+
+    // Hand out the lowest slots first
+    free_.reserve(config.maxInFlight);
+    for(std::size_t i = config.maxInFlight; i > 0; --i) {
+      free_.push_back(static_cast<U32>(i - 1));
+    }
+  }
+
+  RpcClient(const RpcClient &)            = delete;
+  RpcClient &operator=(const RpcClient &) = delete;
+  RpcClient(RpcClient &&)                 = delete;
+  RpcClient &operator=(RpcClient &&)      = delete;
+  ~RpcClient()                            = default;
+
+  Future call(Req request) { return call(std::move(request), config_.timeout); }
+
+  /**
+   * Send a request, which has to get a response within `timeout`. Throws if every slot is taken.
+   */
+  Future call(Req request, const Duration_t timeout) {
+    if(free_.empty()) {
+      throw std::runtime_error(
+        std::format("RpcClient replying on channel {} already has {} calls in flight",
+                    replyId_,
+                    slots_.size()));
+    }
+
+    const U32 index = free_.back();
+    free_.pop_back();
+
+    Slot_ &slot   = slots_[index];
+    slot.deadline = clock_.now() + timeout;
+    slot.pending  = true;
+    ++inFlight_;
+
+    if(!requests_.write({.correlationId = correlation_id_(index, slot.generation),
+                         .replyTo       = replyId_,
+                         .payload       = std::move(request)})) {
+      complete_(slot, std::unexpected(RpcError::Rejected));
+    }
+    return Future(*this, index);
+  }
+
+  /**
+   * Pick up the responses that have arrived and time out the calls whose deadline has passed,
+   * resuming the coroutines awaiting any of them. Returns how many calls completed.
+   */
+  std::size_t poll() {
+    std::size_t completed = 0;
+    replies_.drain_bulk([&](const std::span<RpcResponse<Resp>> responses) {
+      for(RpcResponse<Resp> &response : responses) {
+        completed += accept_(response) ? 1 : 0;
+      }
+    });
+
+    if(inFlight_ > 0) {
+      const TimePoint_t now = clock_.now();
+      for(Slot_ &slot : slots_) {
+        if(slot.pending && slot.deadline <= now) {
+          complete_(slot, std::unexpected(RpcError::TimedOut));
+          ++completed;
+        }
+      }
+    }
+
+    // Resume only once every slot is up to date, since the coroutines may well call back in here
+    if(completed > 0) {
+      for(Slot_ &slot : slots_) {
+        if(slot.result.has_value() && slot.waiter) {
+          std::exchange(slot.waiter, {}).resume();
+        }
+      }
+    }
+    return completed;
+  }
+
+  /**
+   * Calls sent that haven't completed yet
+   */
+  std::size_t in_flight() const { return inFlight_; }
+
+private:
+  struct Slot_ {
+    U32                     generation = 0;
+    bool                    pending    = false;
+    TimePoint_t             deadline{};
+    std::optional<Result_t> result;
+    std::coroutine_handle<> waiter;
+  };
+
+  static U64 correlation_id_(const U32 index, const U32 generation) {
+    return (static_cast<U64>(generation) << 32U) | index;
+  }
+
+  bool accept_(RpcResponse<Resp> &response) {
+    const auto index      = static_cast<U32>(response.correlationId);
+    const auto generation = static_cast<U32>(response.correlationId >> 32U);
+    if(index >= slots_.size()) {
+      return false;
+    }
+
+    Slot_ &slot = slots_[index];
+    if(!slot.pending || slot.generation != generation) {
+      return false;
+    }
+
+    complete_(slot, std::move(response.payload));
+    return true;
+  }
+
+  void complete_(Slot_ &slot, Result_t &&result) {
+    slot.pending = false;
+    slot.result.emplace(std::move(result));
+    --inFlight_;
+  }
+
+  void wait_for_(const U32 index) {
+    const Slot_ &slot = slots_[index];
+    while(slot.pending) {
+      const TimePoint_t now = clock_.now();
+      if(now < slot.deadline) {
+        // The deadline is on clock_, so only sleep a bounded step of real time on it
+        replies_.wait_for_any(std::min<Duration_t>(slot.deadline - now, WAIT_STEP));
+      }
+      poll();
+    }
+  }
+
+  void release_(const U32 index) {
+    Slot_ &slot = slots_[index];
+    if(slot.pending) {
+      slot.pending = false;
+      --inFlight_;
+    }
+    slot.result.reset();
+    slot.waiter = {};
+    ++slot.generation;
+    free_.push_back(index);
+  }
+
+  const IClock                  &clock_;
+  const RpcClientConfig          config_;
+  const U64                      replyId_;
+  EventWriter<RpcRequest<Req>>   requests_;
+  EventReader<RpcResponse<Resp>> replies_;
+  std::vector<Slot_>             slots_;
+  std::vector<U32>               free_;
+  std::size_t                    inFlight_ = 0;
+};
+
+/**
+ * Handler end of an RPC service: reads requests from its channel and writes each handler result to
+ * the channel of the client that sent the request. Like an EventReader, a server must only be used
+ * by one thread at a time; run several servers on the same channel to handle requests in parallel.
+ *
+ * The server keeps a writer for up to `maxReplyWriters` reply channels. Past that, the least
+ * recently used one is dropped, so clients coming and going don't make it grow without bound.
+ */
+template<MessageType Req, MessageType Resp>
+class RpcServer {
+public:
+  static constexpr std::size_t DEFAULT_REPLY_WRITERS = 64;
+
+  RpcServer(MQHive           &hive,
+            const U64         requestId,
+            const std::size_t maxReplyWriters = DEFAULT_REPLY_WRITERS)
+    : hive_(hive),
+      requests_(hive.get_reader<RpcRequest<Req>>(requestId)),
+      maxReplyWriters_(maxReplyWriters) {
+    if(maxReplyWriters == 0) {
+      throw std::invalid_argument(
+        std::format("RpcServer on channel {} needs room for at least one reply writer", requestId));
+    }
+  }
+
+  RpcServer(const RpcServer &)            = delete;
+  RpcServer &operator=(const RpcServer &) = delete;
+  RpcServer(RpcServer &&)                 = delete;
+  RpcServer &operator=(RpcServer &&)      = delete;
+  ~RpcServer()                            = default;
+
+  /**
+   * Handle every pending request and send back the responses. Returns how many were handled. A
+   * request whose handler throws gets no response, so its caller times out; the other requests are
+   * still served, and the first exception is rethrown once they have been.
+   */
+  template<typename Handler_t>
+  requires std::convertible_to<std::invoke_result_t<Handler_t &, Req &&>, Resp>
+  std::size_t serve(Handler_t &&handler) {
+    std::size_t        served = 0;
+    std::exception_ptr failure;
+    requests_.drain_bulk([&](const std::span<RpcRequest<Req>> requests) {
+      for(RpcRequest<Req> &request : requests) {
+        try {
+          reply_writer_(request.replyTo)
+            .write({.correlationId = request.correlationId,
+                    .payload       = handler(std::move(request.payload))});
+          ++served;
+        }
+        catch(...) {
+          if(!failure) {
+            failure = std::current_exception();
+          }
+        }
+      }
+    });
+
+    if(failure) {
+      std::rethrow_exception(failure);
+    }
+    return served;
+  }
+
+  /**
+   * Wait up to `timeout` for requests to arrive, then serve them
+   */
+  template<typename Handler_t>
+  requires std::convertible_to<std::invoke_result_t<Handler_t &, Req &&>, Resp>
+  std::size_t wait_and_serve(const Duration_t timeout, Handler_t &&handler) {
+    if(!requests_.wait_for_any(timeout)) {
+      return 0;
+    }
+    return serve(std::forward<Handler_t>(handler));
+  }
+
+  /**
+   * Reply channels the server currently holds a writer for
+   */
+  std::size_t reply_writers() const { return replies_.size(); }
+
+private:
+  struct ReplyWriter_ {
+    EventWriter<RpcResponse<Resp>> writer;
+    U64                            lastUsed = 0;
+  };
+
+  EventWriter<RpcResponse<Resp>> &reply_writer_(const U64 replyTo) {
+    auto it = replies_.find(replyTo);
+    if(it == replies_.end()) {
+      if(replies_.size() == maxReplyWriters_) {
+        replies_.erase(std::ranges::min_element(
+          replies_, {}, [](const auto &entry) { return entry.second.lastUsed; }));
+      }
+      ReplyWriter_ entry{.writer = hive_.get_writer<RpcResponse<Resp>>(replyTo)};
+      it = replies_.emplace(replyTo, std::move(entry)).first;
+    }
+
+    it->second.lastUsed = ++uses_;
+    return it->second.writer;
+  }
+
+  MQHive                               &hive_;
+  EventReader<RpcRequest<Req>>          requests_;
+  const std::size_t                     maxReplyWriters_;
+  std::unordered_map<U64, ReplyWriter_> replies_;
+  U64                                   uses_ = 0;
+};
+
+}  // namespace mgfw
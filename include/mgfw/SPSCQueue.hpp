@@ -0,0 +1,223 @@
+#pragma once
+
+#include "mgfw/types.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace mgfw {
+
+/**
+ * Unbounded single-producer/single-consumer queue.
+ *
+ * Messages are stored in a chain of power-of-two ring buffers. The producer and consumer each own
+ * one end of the current ring and only touch the other end's (cache-line padded) index when their
+ * cached copy says the ring looks full/empty. When the producer fills a ring it links in a new one
+ * of twice the size and continues there; the consumer frees a ring once it has drained it and
+ * sees that the producer has moved on, so in steady state no allocations take place.
+ *
+ * The API mirrors the subset of moodycamel::ConcurrentQueue used by MessageQueue, plus two-phase
+ * reserve/commit and peek/pop operations that work directly on ring slots. Exactly one thread may
+ * enqueue and exactly one thread may dequeue at any given time.
+ */
+template<typename T>
+class SPSCQueue {
+public:
+  static constexpr std::size_t DEFAULT_INITIAL_CAPACITY = 1024;
+
+  explicit SPSCQueue(const std::size_t initialCapacity = DEFAULT_INITIAL_CAPACITY)
+    : head_(new Block_(std::bit_ceil(std::max<std::size_t>(initialCapacity, 2)))), tail_(head_) { }
+
+  ~SPSCQueue() {
+    Block_ *block = head_;
+    while(block != nullptr) {
+      Block_ *next = block->next.load(std::memory_order::relaxed);
+      delete block;
+      block = next;
+    }
+  }
+
+  SPSCQueue(const SPSCQueue &)            = delete;
+  SPSCQueue &operator=(const SPSCQueue &) = delete;
+  SPSCQueue(SPSCQueue &&)                 = delete;
+  SPSCQueue &operator=(SPSCQueue &&)      = delete;
+
+  bool enqueue(const T &message) { return push_(message); }
+
+  bool enqueue(T &&message) { return push_(std::move(message)); }
+
+  template<typename It_t>
+  bool enqueue_bulk(It_t first, const std::size_t count) {
+    for(std::size_t i = 0; i < count; ++i, ++first) {
+      push_(*first);
+    }
+    return true;
+  }
+
+  /**
+   * Two-phase enqueue: reserve() returns the next free slot, which the caller fills in place before
+   * calling commit() to publish it. The slot holds an unspecified (e.g. moved-from) value until it
+   * is filled in. Reserving again without committing returns the same slot.
+   */
+  T &reserve() {
+    Block_ *block = writable_block_();
+    return block->slots[block->tail.load(std::memory_order::relaxed) & block->mask];
+  }
+
+  void commit() {
+    Block_           *block = tail_;
+    const std::size_t tail  = block->tail.load(std::memory_order::relaxed);
+    block->tail.store(tail + 1, std::memory_order::release);
+    enqueued_.store(enqueued_.load(std::memory_order::relaxed) + 1, std::memory_order::relaxed);
+  }
+
+  template<typename U>
+  bool try_dequeue(U &out) {
+    return try_dequeue_bulk(&out, 1) == 1;
+  }
+
+  template<typename It_t>
+  std::size_t try_dequeue_bulk(It_t out, const std::size_t max) {
+    std::size_t count = 0;
+
+    while(count < max) {
+      Block_ *block = readable_block_();
+      if(block == nullptr) {
+        break;
+      }
+
+      const std::size_t front = block->front.load(std::memory_order::relaxed);
+      const std::size_t n     = std::min(block->cachedTail - front, max - count);
+      for(std::size_t i = 0; i < n; ++i, ++out) {
+        *out = std::move(block->slots[(front + i) & block->mask]);
+      }
+      block->front.store(front + n, std::memory_order::release);
+      count += n;
+    }
+
+    if(count > 0) {
+      dequeued_.store(dequeued_.load(std::memory_order::relaxed) + count,
+                      std::memory_order::relaxed);
+    }
+
+    return count;
+  }
+
+  /**
+   * Two-phase dequeue: peek() returns the message at the front of the queue (or nullptr if it is
+   * empty) without removing it, so it can be processed in place. pop() then removes it; it may only
+   * be called after a successful peek().
+   */
+  T *peek() {
+    Block_ *block = readable_block_();
+    return block == nullptr
+           ? nullptr
+           : &block->slots[block->front.load(std::memory_order::relaxed) & block->mask];
+  }
+
+  void pop() {
+    Block_           *block = head_;
+    const std::size_t front = block->front.load(std::memory_order::relaxed);
+    block->front.store(front + 1, std::memory_order::release);
+    dequeued_.store(dequeued_.load(std::memory_order::relaxed) + 1, std::memory_order::relaxed);
+  }
+
+  std::size_t size_approx() const {
+    const std::size_t dequeued = dequeued_.load(std::memory_order::relaxed);
+    const std::size_t enqueued = enqueued_.load(std::memory_order::relaxed);
+    return enqueued > dequeued ? enqueued - dequeued : 0;
+  }
+
+private:
+  struct Block_ {
+    explicit Block_(const std::size_t capacity)
+      : mask(capacity - 1), slots(std::make_unique<T[]>(capacity)) { }
+
+    // Consumer end
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> front{0};
+    std::size_t cachedTail = 0;
+
+    // Producer end
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail{0};
+    std::size_t cachedFront = 0;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<Block_ *> next{nullptr};
+    const std::size_t    mask;
+    std::unique_ptr<T[]> slots;
+  };
+
+  template<typename U>
+  bool push_(U &&message) {
+    reserve() = std::forward<U>(message);
+    commit();
+    return true;
+  }
+
+  /**
+   * Producer side: the ring to write the next message into, linking in a bigger one if the current
+   * ring is full.
+   */
+  Block_ *writable_block_() {
+    Block_           *block = tail_;
+    const std::size_t tail  = block->tail.load(std::memory_order::relaxed);
+
+    if(tail - block->cachedFront > block->mask) {
+      block->cachedFront = block->front.load(std::memory_order::acquire);
+    }
+
+    if(tail - block->cachedFront > block->mask) {
+      auto *next = new Block_((block->mask + 1) * 2);
+      block->next.store(next, std::memory_order::release);
+      tail_ = next;
+      return next;
+    }
+
+    return block;
+  }
+
+  /**
+   * Consumer side: the ring holding the next message (with its cachedTail up to date), or nullptr
+   * if the queue is empty. Frees rings that the producer has moved on from.
+   */
+  Block_ *readable_block_() {
+    while(true) {
+      Block_           *block = head_;
+      const std::size_t front = block->front.load(std::memory_order::relaxed);
+
+      if(front == block->cachedTail) {
+        block->cachedTail = block->tail.load(std::memory_order::acquire);
+      }
+
+      if(front != block->cachedTail) {
+        return block;
+      }
+
+      Block_ *next = block->next.load(std::memory_order::acquire);
+      if(next == nullptr) {
+        return nullptr;
+      }
+
+      // The producer only moves on once this ring is full, and publishes `next` after its final
+      // write here, so this reload of the tail is authoritative.
+      block->cachedTail = block->tail.load(std::memory_order::acquire);
+      if(front == block->cachedTail) {
+        head_ = next;
+        delete block;
+      }
+    }
+  }
+
+  // Consumer-owned
+  alignas(CACHE_LINE_SIZE) Block_ *head_;
+  std::atomic<std::size_t> dequeued_{0};
+
+  // Producer-owned
+  alignas(CACHE_LINE_SIZE) Block_ *tail_;
+  std::atomic<std::size_t> enqueued_{0};
+};
+
+}  // namespace mgfw
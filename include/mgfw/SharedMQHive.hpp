@@ -0,0 +1,365 @@
+#pragma once
+
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/SharedMemory.hpp"
+#include "mgfw/TypeHash.hpp"
+#include "mgfw/TypeString.hpp"
+#include "mgfw/defer.hpp"
+#include "mgfw/types.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace mgfw {
+
+/**
+ * Messages that can cross process boundaries as a plain copy of their bytes
+ */
+template<typename T>
+concept SharedMessage =
+  MessageType<T> && std::is_trivially_copyable_v<T> && alignof(T) <= CACHE_LINE_SIZE;
+
+/**
+ * Creation-time options for a SharedMQHive; ignored when attaching to an existing one
+ */
+struct SharedHiveConfig {
+  // Entries in the channel table
+  U32 maxChannels = 64;
+
+  // Bytes available for the channels' ring buffers
+  std::size_t heapSize = std::size_t{16} * 1024 * 1024;
+};
+
+namespace detail_ {
+  /**
+   * The structs below are laid out in the shared memory segment and may be accessed by several
+   * processes at once. Fields that are written after initialization are only accessed through
+   * std::atomic_ref.
+   */
+  struct SharedHiveHeader {
+    static constexpr U64 MAGIC   = 0x4556'4948'4d48'534d;  // "MSHMHIVE"
+    static constexpr U32 VERSION = 1;
+
+    // Written last by the creating process, so attaching processes can wait for initialization
+    U64 magic;
+    U32 version;
+    U32 maxChannels;
+    U64 size;
+
+    // Guards channelCount, heapTop and the channel table
+    U32 lock;
+    U32 channelCount;
+    U64 heapTop;
+  };
+
+  struct SharedChannelEntry {
+    static constexpr std::size_t TYPE_STRING_SIZE = 120;
+
+    U64    id;
+    Hash_t typeHash;
+    U32    recordSize;
+    U64    ringOffset;
+
+    // Truncated copy of the message's TypeString, for error messages
+    std::array<char, TYPE_STRING_SIZE> typeString;
+  };
+
+  /**
+   * Header of a bounded MPMC ring buffer (Dmitry Vyukov's design), followed by its cells. Each
+   * cell is a sequence number followed by the message bytes.
+   */
+  struct SharedRingHeader {
+    U64 capacity;
+    U64 cellStride;
+    U64 payloadOffset;
+
+    alignas(CACHE_LINE_SIZE) U64 enqueuePos;
+    alignas(CACHE_LINE_SIZE) U64 dequeuePos;
+  };
+
+  /**
+   * How a message type is laid out in ring cells
+   */
+  struct SharedRingLayout {
+    std::size_t      recordSize;
+    std::size_t      payloadOffset;
+    std::size_t      cellStride;
+    Hash_t           typeHash;
+    std::string_view typeString;
+  };
+
+  template<SharedMessage T>
+  constexpr SharedRingLayout shared_ring_layout() {
+    const std::size_t align         = std::max(alignof(U64), alignof(T));
+    const std::size_t payloadOffset = std::max(sizeof(U64), alignof(T));
+    return {
+      .recordSize    = sizeof(T),
+      .payloadOffset = payloadOffset,
+      .cellStride    = (payloadOffset + sizeof(T) + align - 1) / align * align,
+      .typeHash      = TypeHash<T>,
+      .typeString    = TypeString<T>,
+    };
+  }
+
+  /**
+   * Typed view of a ring buffer living in shared memory
+   */
+  template<SharedMessage T>
+  class SharedRing {
+  public:
+    explicit SharedRing(SharedRingHeader &header)
+      : header_(&header), cells_(reinterpret_cast<std::byte *>(&header) + sizeof(header)) { }
+
+    std::size_t capacity() const { return header_->capacity; }
+
+    std::size_t size_approx() const {
+      const U64 dequeued =
+        std::atomic_ref<U64>(header_->dequeuePos).load(std::memory_order::relaxed);
+      const U64 enqueued =
+        std::atomic_ref<U64>(header_->enqueuePos).load(std::memory_order::relaxed);
+      return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    /**
+     * Claim the next cell for writing, unless the ring is full. Readers stop at a claimed cell
+     * until it is published.
+     */
+    std::optional<U64> try_claim() {
+      std::atomic_ref<U64> enqueuePos(header_->enqueuePos);
+
+      U64 pos = enqueuePos.load(std::memory_order::relaxed);
+      while(true) {
+        const U64 seq = sequence_(pos).load(std::memory_order::acquire);
+        if(seq == pos) {
+          if(enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order::relaxed)) {
+            return pos;
+          }
+        }
+        else if(seq < pos) {
+          return std::nullopt;  // Full
+        }
+        else {
+          pos = enqueuePos.load(std::memory_order::relaxed);
+        }
+      }
+    }
+
+    T &message(const U64 pos) const { return *std::launder(reinterpret_cast<T *>(payload_(pos))); }
+
+    void publish(const U64 pos) { sequence_(pos).store(pos + 1, std::memory_order::release); }
+
+    bool try_push(const T &message) {
+      const std::optional<U64> pos = try_claim();
+      if(!pos) {
+        return false;
+      }
+
+      std::memcpy(payload_(*pos), &message, sizeof(T));
+      publish(*pos);
+      return true;
+    }
+
+    /**
+     * Hand the oldest message to a callback, straight from its cell, unless the ring is empty. The
+     * cell is only released once the callback returns.
+     */
+    template<typename Callback>
+    bool try_consume(Callback &callback) {
+      std::atomic_ref<U64> dequeuePos(header_->dequeuePos);
+
+      U64 pos = dequeuePos.load(std::memory_order::relaxed);
+      while(true) {
+        const U64 seq = sequence_(pos).load(std::memory_order::acquire);
+        if(seq == pos + 1) {
+          if(dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order::relaxed)) {
+            break;
+          }
+        }
+        else if(seq < pos + 1) {
+          return false;  // Empty
+        }
+        else {
+          pos = dequeuePos.load(std::memory_order::relaxed);
+        }
+      }
+
+      const defer release([&] {
+        sequence_(pos).store(pos + header_->capacity, std::memory_order::release);
+      });
+      callback(std::as_const(message(pos)));
+      return true;
+    }
+
+  private:
+    std::byte *cell_(const U64 pos) const {
+      return cells_ + (pos & (header_->capacity - 1)) * header_->cellStride;
+    }
+
+    std::atomic_ref<U64> sequence_(const U64 pos) const {
+      return std::atomic_ref<U64>(*reinterpret_cast<U64 *>(cell_(pos)));
+    }
+
+    std::byte *payload_(const U64 pos) const { return cell_(pos) + header_->payloadOffset; }
+
+    SharedRingHeader *header_;
+    std::byte        *cells_;
+  };
+}  // namespace detail_
+
+/**
+ * Write-only sender end of a channel in a SharedMQHive
+ */
+template<SharedMessage T>
+class SharedWriter {
+public:
+  explicit SharedWriter(detail_::SharedRing<T> ring) : ring_(ring) { }
+
+  SharedWriter(const SharedWriter &)            = delete;
+  SharedWriter &operator=(const SharedWriter &) = delete;
+  SharedWriter(SharedWriter &&)                 = default;
+  SharedWriter &operator=(SharedWriter &&)      = default;
+  ~SharedWriter()                               = default;
+
+  /**
+   * Write a message, waiting for readers to make room if the channel is full
+   */
+  void write(const T &message) {
+    while(!ring_.try_push(message)) {
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * Write a message unless the channel is full
+   */
+  bool try_write(const T &message) { return ring_.try_push(message); }
+
+  /**
+   * Two-phase write for building a message directly in the channel: reserve() claims the next
+   * cell, waiting for readers to make room like write(), and commit() hands it to the readers.
+   * Calling reserve() again before commit() returns the same cell, and its contents are
+   * unspecified until filled in. Readers can't get past an uncommitted cell, so commit promptly.
+   */
+  T &reserve() {
+    while(!reserved_) {
+      reserved_ = ring_.try_claim();
+      if(!reserved_) {
+        std::this_thread::yield();
+      }
+    }
+    return ring_.message(*reserved_);
+  }
+
+  void commit() {
+    assert(reserved_);
+    ring_.publish(*reserved_);
+    reserved_.reset();
+  }
+
+private:
+  detail_::SharedRing<T> ring_;
+  std::optional<U64>     reserved_;
+};
+
+/**
+ * Read-only receiver end of a channel in a SharedMQHive. Each message goes to one reader.
+ */
+template<SharedMessage T>
+class SharedReader {
+public:
+  explicit SharedReader(detail_::SharedRing<T> ring) : ring_(ring) { }
+
+  /**
+   * Invoke a callback on each waiting message, which it reads in place in the channel. Stops after
+   * one capacity's worth of messages, so busy writers can't keep a drain going indefinitely.
+   */
+  template<MessageDrainCallback<T> Callback>
+  void drain(Callback &&callback) {
+    std::size_t drained = 0;
+    while(drained < ring_.capacity() && ring_.try_consume(callback)) {
+      ++drained;
+    }
+  }
+
+  std::size_t size_approx() const { return ring_.size_approx(); }
+
+private:
+  detail_::SharedRing<T> ring_;
+};
+
+/**
+ * Counterpart to MQHive whose channels live in a named POSIX shared memory segment, for exchanging
+ * trivially copyable messages between processes on one host. Processes constructing a
+ * SharedMQHive with the same name see the same channels, and messages move through bounded
+ * lock-free ring buffers in the segment, without syscalls on the data path. Writers can build
+ * messages in place with reserve()/commit() and readers are handed them in place, so nothing needs
+ * to be copied either.
+ *
+ * As with MQHive, channels are created on first request, and requesting a channel with a different
+ * message type than the one it was created with throws, also across processes. Channel creation
+ * briefly takes a spinlock in the segment; a process dying while holding it leaves the hive
+ * unusable for further channel creation.
+ *
+ * The segment is created by the first process to construct the hive and persists until someone
+ * calls remove().
+ */
+class SharedMQHive {
+public:
+  static constexpr std::size_t DEFAULT_CAPACITY = 1024;
+
+  explicit SharedMQHive(std::string name, const SharedHiveConfig &config = {});
+
+  /**
+   * Delete the named segment; returns false if there was none. Attached processes keep working,
+   * but are no longer reachable by new ones.
+   */
+  static bool remove(const std::string &name) { return SharedMemory::remove(name); }
+
+  const std::string &name() const { return memory_.name(); }
+
+  /**
+   * Endpoints for the channel with the given ID. The capacity is rounded up to a power of two, and
+   * only takes effect when the call creates the channel.
+   */
+  template<SharedMessage Raw_t, typename T = std::decay_t<Raw_t>>
+  SharedWriter<T> get_writer(U64 id, const std::size_t capacity = DEFAULT_CAPACITY) {
+    return SharedWriter<T>(get_ring_<T>(id, capacity));
+  }
+
+  template<SharedMessage Raw_t, typename T = std::decay_t<Raw_t>>
+  SharedReader<T> get_reader(U64 id, const std::size_t capacity = DEFAULT_CAPACITY) {
+    return SharedReader<T>(get_ring_<T>(id, capacity));
+  }
+
+private:
+  template<SharedMessage T>
+  detail_::SharedRing<T> get_ring_(U64 id, const std::size_t capacity) {
+    static constexpr detail_::SharedRingLayout LAYOUT = detail_::shared_ring_layout<T>();
+    return detail_::SharedRing<T>(get_or_create_ring_(id, capacity, LAYOUT));
+  }
+
+  static SharedMemory create_or_attach_(const std::string &name, const SharedHiveConfig &config);
+
+  detail_::SharedHiveHeader &header_() const;
+
+  detail_::SharedChannelEntry *channels_() const;
+
+  detail_::SharedRingHeader &get_or_create_ring_(U64                               id,
+                                                  std::size_t                       capacity,
+                                                  const detail_::SharedRingLayout &layout);
+
+  SharedMemory memory_;
+};
+
+}  // namespace mgfw
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "mgfw/Mapping.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace mgfw {
+
+/**
+ * Read-write mapping of a named POSIX shared memory object (see shm_open), which other processes
+ * can map by the same name. Names look like "/my_app".
+ *
+ * The object outlives the mappings, and is only deleted by remove(). Failures throw
+ * std::system_error.
+ */
+class SharedMemory {
+public:
+  /**
+   * Create an object of `size` zeroed bytes and map it, unless one by that name already exists
+   */
+  static std::optional<SharedMemory> create(const std::string &name, std::size_t size);
+
+  /**
+   * Map an existing object in its entirety. An object that its creator hasn't sized yet maps as
+   * empty.
+   */
+  static SharedMemory open(const std::string &name);
+
+  /**
+   * Delete the named object; returns false if there was none. Existing mappings remain valid.
+   */
+  static bool remove(const std::string &name);
+
+  SharedMemory(const SharedMemory &)            = delete;
+  SharedMemory &operator=(const SharedMemory &) = delete;
+  SharedMemory(SharedMemory &&)                 = default;
+  SharedMemory &operator=(SharedMemory &&)      = default;
+  ~SharedMemory()                               = default;
+
+  const std::string &name() const { return mapping_.name(); }
+
+  std::span<std::byte> bytes() const { return mapping_.bytes(); }
+
+private:
+  SharedMemory(const std::string &name, int fd, std::size_t size);
+
+  Mapping mapping_;
+};
+
+}  // namespace mgfw
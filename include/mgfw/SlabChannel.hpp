@@ -0,0 +1,214 @@
+#pragma once
+
+#include "mgfw/EventReader.hpp"
+#include "mgfw/EventWriter.hpp"
+#include "mgfw/ILogger.hpp"
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/SlabPool.hpp"
+#include "mgfw/defer.hpp"
+#include "mgfw/types.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <format>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace mgfw {
+
+/**
+ * Creation-time options for a SlabChannel
+ */
+struct SlabConfig {
+  // Applied to the queue of handles. OverwriteOldest isn't supported, since the overwritten handles
+  // would never make it back to the pool.
+  QueueConfig queue;
+
+  // Slots allocated up front; the pool grows on demand past this
+  std::size_t initialSlots = 64;
+
+  // Handles each endpoint keeps to itself, and moves to and from the shared pool in one go
+  std::size_t cacheSize = 32;
+};
+
+/**
+ * Channel for large messages (several KB or more). The messages live in a SlabPool and are
+ * written and read in place; the MessageQueue in between only carries their 4-byte handles. This
+ * keeps the queue's blocks small, and saves copying each message into and out of the queue.
+ *
+ * Each SlabWriter and SlabReader keeps a small cache of free handles, so that most messages go
+ * through without touching the pool's shared state.
+ */
+template<MessageType T>
+class SlabChannel {
+public:
+  using Handle_t = typename SlabPool<T>::Handle_t;
+
+  SlabChannel(ILogger &logger, const U64 id, const SlabConfig &config = {})
+    : config_(config), pool_(config.initialSlots), queue_(logger, id, config.queue) {
+    if(config.queue.overflow == OverflowPolicy::OverwriteOldest) {
+      throw std::invalid_argument(
+        std::format("SlabChannel {} can't use the OverwriteOldest overflow policy", id));
+    }
+    if(config.cacheSize == 0) {
+      throw std::invalid_argument(std::format("SlabChannel {} needs a positive cache size", id));
+    }
+  }
+
+  SlabChannel(const SlabChannel &)            = delete;
+  SlabChannel &operator=(const SlabChannel &) = delete;
+  SlabChannel(SlabChannel &&)                 = delete;
+  SlabChannel &operator=(SlabChannel &&)      = delete;
+  ~SlabChannel()                              = default;
+
+  const SlabConfig &config() const { return config_; }
+
+  SlabPool<T> &pool() { return pool_; }
+
+  MessageQueue<Handle_t> &queue() { return queue_; }
+
+private:
+  const SlabConfig       config_;
+  SlabPool<T>            pool_;
+  MessageQueue<Handle_t> queue_;
+};
+
+/**
+ * Write-only sender end of a SlabChannel. Like an EventWriter, a writer must only be used by one
+ * thread at a time.
+ */
+template<MessageType T>
+class SlabWriter {
+  using Handle_t = typename SlabChannel<T>::Handle_t;
+
+public:
+  explicit SlabWriter(SlabChannel<T> &channel)
+    : channel_(channel), writer_(channel.queue()), cache_(channel.config().cacheSize) { }
+
+  SlabWriter(const SlabWriter &)            = delete;
+  SlabWriter &operator=(const SlabWriter &) = delete;
+  SlabWriter &operator=(SlabWriter &&)      = delete;
+
+  SlabWriter(SlabWriter &&other) noexcept
+    : channel_(other.channel_),
+      writer_(std::move(other.writer_)),
+      cache_(std::move(other.cache_)),
+      cached_(std::exchange(other.cached_, 0)) { }
+
+  ~SlabWriter() {
+    if(cached_ > 0) {
+      channel_.pool().release(std::span<const Handle_t>(cache_.data(), cached_));
+    }
+  }
+
+  /**
+   * Fill a pooled message in place and send it. The slot holds whatever message it carried last, so
+   * `fill` should set every field it relies on. Returns false if the queue refused the message (see
+   * OverflowPolicy), in which case the slot goes back to the cache, as it does if `fill` throws.
+   */
+  template<std::invocable<T &> Fill_t>
+  bool write_with(Fill_t &&fill, const Priority priority = Priority::Normal) {
+    if(cached_ == 0) {
+      cached_ = channel_.pool().acquire(std::span<Handle_t>(cache_));
+    }
+
+    const Handle_t handle = cache_[--cached_];
+    bool           sent   = false;
+
+    // Hand the slot back unless it was sent, even if `fill` throws
+    defer giveBack([&] {
+      if(!sent) {
+        cache_[cached_++] = handle;
+      }
+    });
+
+    std::invoke(std::forward<Fill_t>(fill), channel_.pool()[handle]);
+    sent = writer_.write(handle, priority);
+    return sent;
+  }
+
+  bool write(const T &message, const Priority priority = Priority::Normal) {
+    return write_with([&](T &slot) { slot = message; }, priority);
+  }
+
+  bool write(T &&message, const Priority priority = Priority::Normal) {
+    return write_with([&](T &slot) { slot = std::move(message); }, priority);
+  }
+
+private:
+  SlabChannel<T>       &channel_;
+  EventWriter<Handle_t> writer_;
+  std::vector<Handle_t> cache_;
+  std::size_t           cached_ = 0;
+};
+
+/**
+ * Read-only receiver end of a SlabChannel. Messages are lent to the drain callback in place, and go
+ * back to the pool once it returns, in batches of up to SlabConfig::cacheSize. Like an EventReader,
+ * a reader must only be drained from one thread at a time.
+ */
+template<MessageType T>
+class SlabReader {
+  using Handle_t = typename SlabChannel<T>::Handle_t;
+
+public:
+  explicit SlabReader(SlabChannel<T> &channel) : channel_(channel), reader_(channel.queue()) {
+    freed_.reserve(channel.config().cacheSize);
+  }
+
+  SlabReader(const SlabReader &)            = delete;
+  SlabReader &operator=(const SlabReader &) = delete;
+  SlabReader(SlabReader &&)                 = default;
+  SlabReader &operator=(SlabReader &&)      = delete;
+
+  ~SlabReader() { flush_(); }
+
+  template<MessageDrainCallback<T> Callback>
+  void drain(Callback &&callback) {
+    reader_.drain([&](const Handle_t handle) {
+      // Hand the slot back even if the callback throws
+      defer release([&] {
+        freed_.push_back(handle);
+        if(freed_.size() == channel_.config().cacheSize) {
+          flush_();
+        }
+      });
+
+      callback(std::as_const(channel_.pool()[handle]));
+    });
+    flush_();
+  }
+
+  /**
+   * Wait up to `timeout` for messages to arrive, then drain the queue. Returns whether there were
+   * messages available.
+   */
+  template<MessageDrainCallback<T> Callback>
+  bool wait_and_drain(const Duration_t timeout, Callback &&callback) {
+    if(!reader_.wait_for_any(timeout)) {
+      return false;
+    }
+
+    drain(std::forward<Callback>(callback));
+    return true;
+  }
+
+  std::size_t size_approx() const { return reader_.size_approx(); }
+
+private:
+  void flush_() {
+    if(!freed_.empty()) {
+      channel_.pool().release(freed_);
+      freed_.clear();
+    }
+  }
+
+  SlabChannel<T>       &channel_;
+  EventReader<Handle_t> reader_;
+  std::vector<Handle_t> freed_;
+};
+
+}  // namespace mgfw
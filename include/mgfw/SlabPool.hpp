@@ -0,0 +1,206 @@
+#pragma once
+
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/types.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <format>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace mgfw {
+
+/**
+ * Pool of preconstructed T objects, addressed by U32 handles, for passing large messages around by
+ * handle instead of by value.
+ *
+ * Slots live in slabs that double in size as the pool grows (64, 128, 256, ... slots), and are
+ * never freed or moved until the pool is destroyed, so a handle can be turned into a reference
+ * without locking. Free slots are kept on a lock-free stack; the head is tagged with a counter so
+ * that a slot being popped and pushed back concurrently can't corrupt it. Only growing the pool
+ * takes a lock.
+ *
+ * Slots are default-constructed along with their slab and keep whatever value they last held when
+ * released, so callers are expected to overwrite them in place. The batch functions are meant for
+ * per-thread caches of handles (see SlabWriter and SlabReader), which keep most acquires and
+ * releases off the shared stack.
+ */
+template<MessageType T>
+class SlabPool {
+public:
+  using Handle_t = U32;
+
+  static constexpr std::size_t FIRST_SLAB_SLOTS = 64;
+  static constexpr std::size_t MAX_SLABS        = 25;
+
+  explicit SlabPool(const std::size_t initialSlots = FIRST_SLAB_SLOTS) {
+    while(capacity() < initialSlots) {
+      const std::scoped_lock growLock(growMutex_);
+      grow_();
+    }
+  }
+
+  SlabPool(const SlabPool &)            = delete;
+  SlabPool &operator=(const SlabPool &) = delete;
+  SlabPool(SlabPool &&)                 = delete;
+  SlabPool &operator=(SlabPool &&)      = delete;
+  ~SlabPool()                           = default;
+
+  T &operator[](const Handle_t handle) noexcept {
+    return slab_of_(handle).values[offset_of_(handle)];
+  }
+
+  /**
+   * Pop up to `out.size()` free handles into `out`, growing the pool if there are none. Returns how
+   * many were popped, which is at least 1. Throws once the pool can't grow any further.
+   */
+  std::size_t acquire(const std::span<Handle_t> out) {
+    std::size_t count = 0;
+    while(count == 0) {
+      for(; count < out.size(); ++count) {
+        const Handle_t handle = pop_();
+        if(handle == NIL) {
+          break;
+        }
+        out[count] = handle;
+      }
+
+      if(count == 0) {
+        const std::scoped_lock growLock(growMutex_);
+        // Another thread may have grown the pool in the meantime
+        if(peek_() == NIL) {
+          grow_();
+        }
+      }
+    }
+    return count;
+  }
+
+  Handle_t acquire() {
+    Handle_t handle = NIL;
+    acquire(std::span<Handle_t>(&handle, 1));
+    return handle;
+  }
+
+  /**
+   * Push handles back onto the free stack, in a single atomic operation
+   */
+  void release(const std::span<const Handle_t> handles) {
+    if(handles.empty()) {
+      return;
+    }
+
+    for(std::size_t i = 0; i + 1 < handles.size(); ++i) {
+      next_of_(handles[i]).store(handles[i + 1], std::memory_order::relaxed);
+    }
+
+    U64 head = head_.load(std::memory_order::relaxed);
+    do {
+      next_of_(handles.back()).store(index_of_(head), std::memory_order::relaxed);
+    } while(!head_.compare_exchange_weak(head,
+                                         pack_(handles.front(), tag_of_(head) + 1),
+                                         std::memory_order::release,
+                                         std::memory_order::relaxed));
+  }
+
+  void release(const Handle_t handle) { release(std::span<const Handle_t>(&handle, 1)); }
+
+  /**
+   * Slots allocated so far, free or not
+   */
+  std::size_t capacity() const {
+    return FIRST_SLAB_SLOTS * ((std::size_t{1} << slabCount_.load(std::memory_order::acquire)) - 1);
+  }
+
+private:
+  static constexpr Handle_t NIL = std::numeric_limits<Handle_t>::max();
+
+  struct Slab_ {
+    explicit Slab_(const std::size_t slots)
+      : values(std::make_unique<T[]>(slots)),
+        next(std::make_unique<std::atomic<Handle_t>[]>(slots)) { }
+
+    std::unique_ptr<T[]>                     values;
+    std::unique_ptr<std::atomic<Handle_t>[]> next;
+  };
+
+  // Slab k holds FIRST_SLAB_SLOTS << k slots, starting at handle FIRST_SLAB_SLOTS * (2^k - 1)
+  static std::size_t slab_index_of_(const Handle_t handle) noexcept {
+    return static_cast<std::size_t>(std::bit_width((handle / FIRST_SLAB_SLOTS) + 1)) - 1;
+  }
+
+  static std::size_t offset_of_(const Handle_t handle) noexcept {
+    return handle - (FIRST_SLAB_SLOTS * ((std::size_t{1} << slab_index_of_(handle)) - 1));
+  }
+
+  static constexpr U64 pack_(const Handle_t index, const U32 tag) noexcept {
+    return (static_cast<U64>(tag) << 32U) | index;
+  }
+
+  static Handle_t index_of_(const U64 head) noexcept { return static_cast<Handle_t>(head); }
+
+  static U32 tag_of_(const U64 head) noexcept { return static_cast<U32>(head >> 32U); }
+
+  Slab_ &slab_of_(const Handle_t handle) const noexcept {
+    return *slabs_[slab_index_of_(handle)].load(std::memory_order::acquire);
+  }
+
+  std::atomic<Handle_t> &next_of_(const Handle_t handle) const noexcept {
+    return slab_of_(handle).next[offset_of_(handle)];
+  }
+
+  Handle_t peek_() const { return index_of_(head_.load(std::memory_order::acquire)); }
+
+  Handle_t pop_() {
+    U64 head = head_.load(std::memory_order::acquire);
+    while(index_of_(head) != NIL) {
+      // If the slot was popped and reused meanwhile, this reads a stale link, but the tag will have
+      // changed and the exchange fails
+      const Handle_t next = next_of_(index_of_(head)).load(std::memory_order::relaxed);
+      if(head_.compare_exchange_weak(head,
+                                     pack_(next, tag_of_(head) + 1),
+                                     std::memory_order::acquire,
+                                     std::memory_order::acquire)) {
+        return index_of_(head);
+      }
+    }
+    return NIL;
+  }
+
+  // Must hold growMutex_
+  void grow_() {
+    const std::size_t k = slabCount_.load(std::memory_order::relaxed);
+    if(k == MAX_SLABS) {
+      throw std::runtime_error(std::format("SlabPool is full at {} slots", capacity()));
+    }
+
+    const std::size_t slots = FIRST_SLAB_SLOTS << k;
+    const auto        first = static_cast<Handle_t>(capacity());
+
+    owned_.push_back(std::make_unique<Slab_>(slots));
+    slabs_[k].store(owned_.back().get(), std::memory_order::release);
+    slabCount_.store(k + 1, std::memory_order::release);
+
+    std::vector<Handle_t> fresh(slots);
+    for(std::size_t i = 0; i < slots; ++i) {
+      fresh[i] = static_cast<Handle_t>(first + i);
+    }
+    release(fresh);
+  }
+
+  std::atomic<U64>                            head_{pack_(NIL, 0)};
+  std::array<std::atomic<Slab_ *>, MAX_SLABS> slabs_{};
+  std::atomic<std::size_t>                    slabCount_{0};
+
+  std::mutex                          growMutex_;
+  std::vector<std::unique_ptr<Slab_>> owned_;
+};
+
+}  // namespace mgfw
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "mgfw/EventReader.hpp"
+#include "mgfw/EventWriter.hpp"
+#include "mgfw/ILogger.hpp"
+#include "mgfw/MQHive.hpp"
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/fnv1a.hpp"
+#include "mgfw/types.hpp"
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+namespace mgfw {
+
+/**
+ * Compile-time declaration of a MessageQueue for a StaticMQHive: its key (usually a string_key),
+ * message type, and config.
+ */
+template<Hash_t channelKey, MessageType Raw_t, QueueConfig channelConfig = QueueConfig{}>
+struct StaticChannel {
+  static constexpr Hash_t      KEY    = channelKey;
+  static constexpr QueueConfig CONFIG = channelConfig;
+  using Message_t                     = std::decay_t<Raw_t>;
+};
+
+namespace detail_ {
+  template<typename T>
+  inline constexpr bool is_static_channel_ = false;
+
+  template<Hash_t channelKey, MessageType Raw_t, QueueConfig channelConfig>
+  inline constexpr bool is_static_channel_<StaticChannel<channelKey, Raw_t, channelConfig>> = true;
+}  // namespace detail_
+
+template<typename T>
+concept StaticChannelDecl = detail_::is_static_channel_<T>;
+
+/**
+ * MQHive whose channels are declared up front as StaticChannels, e.g.
+ *
+ *   using Hive_t = StaticMQHive<StaticChannel<string_key("ticks"), Tick>,
+ *                               StaticChannel<string_key("fills"), Fill, QueueConfig{...}>>;
+ *   EventWriter<Tick> writer = hive.get_writer<string_key("ticks")>();
+ *
+ * Declared channels are built along with the hive and resolved at compile time, so getting their
+ * endpoints involves no hashing, locking, or runtime type check. Asking for a key that wasn't
+ * declared, or for the wrong message type, doesn't compile.
+ *
+ * Channels that are only known at runtime can still be reached by ID through dynamic(). Its IDs are
+ * separate from the declared keys, even if they happen to have the same value.
+ */
+template<StaticChannelDecl... Channels>
+class StaticMQHive {
+  static constexpr std::array<Hash_t, sizeof...(Channels)> KEYS{Channels::KEY...};
+
+  static consteval bool keys_unique_() {
+    for(std::size_t i = 0; i < KEYS.size(); ++i) {
+      for(std::size_t j = i + 1; j < KEYS.size(); ++j) {
+        if(KEYS[i] == KEYS[j]) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  static_assert(keys_unique_(), "StaticMQHive: each channel needs its own key");
+
+  template<Hash_t key>
+  static constexpr bool declared_ = ((Channels::KEY == key) || ...);
+
+  template<Hash_t key>
+  static consteval std::size_t index_of_() {
+    std::size_t i = 0;
+    while(KEYS[i] != key) {
+      ++i;
+    }
+    return i;
+  }
+
+  template<Hash_t key>
+  using Channel_t_ = std::tuple_element_t<index_of_<key>(), std::tuple<Channels...>>;
+
+public:
+  /**
+   * Message type of the channel declared with `key`
+   */
+  template<Hash_t key>
+  requires declared_<key>
+  using Message_t = typename Channel_t_<key>::Message_t;
+
+  explicit StaticMQHive(ILogger &logger) : dynamic_(logger), slots_(logger) { }
+
+  template<Hash_t key>
+  requires declared_<key>
+  EventWriter<Message_t<key>> get_writer() {
+    return EventWriter<Message_t<key>>(queue<key>());
+  }
+
+  template<Hash_t key>
+  requires declared_<key>
+  EventReader<Message_t<key>> get_reader() {
+    return EventReader<Message_t<key>>(queue<key>());
+  }
+
+  /**
+   * Same as above, but spelling out the expected message type, which has to match the declaration
+   */
+  template<MessageType T, Hash_t key>
+  requires declared_<key> && std::same_as<std::decay_t<T>, Message_t<key>>
+  EventWriter<Message_t<key>> get_writer() {
+    return get_writer<key>();
+  }
+
+  template<MessageType T, Hash_t key>
+  requires declared_<key> && std::same_as<std::decay_t<T>, Message_t<key>>
+  EventReader<Message_t<key>> get_reader() {
+    return get_reader<key>();
+  }
+
+  template<Hash_t key>
+  requires declared_<key>
+  MessageQueue<Message_t<key>> &queue() {
+    return static_cast<Slot_<Channel_t_<key>> &>(slots_).queue;
+  }
+
+  /**
+   * Hive for channels that weren't declared
+   */
+  MQHive &dynamic() { return dynamic_; }
+
+private:
+  template<StaticChannelDecl Channel_t>
+  struct Slot_ {
+    explicit Slot_(ILogger &logger) : queue(logger, Channel_t::KEY, Channel_t::CONFIG) { }
+
+    MessageQueue<typename Channel_t::Message_t> queue;
+  };
+
+  // One base per declared channel, so each queue sits at a fixed offset
+  struct Slots_ : Slot_<Channels>... {
+    explicit Slots_(ILogger &logger) : Slot_<Channels>(logger)... { }
+  };
+
+  MQHive dynamic_;
+  Slots_ slots_;
+};
+
+}  // namespace mgfw
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "mgfw/ILogger.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mgfw {
+
+/**
+ * Fixed set of threads running jobs in FIFO order.
+ *
+ * Satisfies Executor, so awaitables and pipelines can resume work on it. Jobs that throw are
+ * logged and otherwise ignored, as with Scheduler.
+ */
+class WorkerPool {
+public:
+  using JobFunc_t = std::function<void()>;
+
+  WorkerPool(ILogger &logger, std::size_t threads);
+
+  WorkerPool(const WorkerPool &)            = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+  WorkerPool(WorkerPool &&)                 = delete;
+  WorkerPool &operator=(WorkerPool &&)      = delete;
+
+  ~WorkerPool();
+
+  /**
+   * Queue a job to run on one of the workers. Ignored once the pool is stopping.
+   */
+  void do_now(JobFunc_t func);
+
+  /**
+   * Let running jobs finish, discard queued ones, and join the workers. Must not be called from a
+   * job.
+   */
+  void stop();
+
+  std::size_t size() const { return workers_.size(); }
+
+private:
+  void work_();
+
+  ILogger &logger_;
+
+  std::mutex              mutex_;
+  std::condition_variable cv_;
+  std::deque<JobFunc_t>   jobs_;
+  bool                    stopping_ = false;
+
+  std::vector<std::jthread> workers_;
+};
+
+}  // namespace mgfw
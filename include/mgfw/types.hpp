@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 
 namespace mgfw {
@@ -17,4 +18,8 @@ using U64 = std::uint64_t;
 
 using TimePoint_t = decltype(std::chrono::steady_clock::now());
 using Duration_t  = std::chrono::nanoseconds;
+
+// Used to keep independently-written atomics on separate cache lines. We don't use
+// std::hardware_destructive_interference_size since its value isn't ABI-stable across compilers.
+constexpr std::size_t CACHE_LINE_SIZE = 64;
 }  // namespace mgfw
@@ -0,0 +1,349 @@
+#include "mgfw/Capture.hpp"
+
+#include "mgfw/IClock.hpp"
+#include "mgfw/MQHive.hpp"
+#include "mgfw/Scheduler.hpp"
+#include "mgfw/types.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <ios>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mgfw {
+
+namespace {
+
+template<typename T>
+void write_field(std::ostream &out, const T &value) {
+  out.write(reinterpret_cast<const char *>(&value), static_cast<std::streamsize>(sizeof(T)));
+}
+
+template<typename T>
+bool read_field(std::istream &in, T &value) {
+  return static_cast<bool>(
+    in.read(reinterpret_cast<char *>(&value), static_cast<std::streamsize>(sizeof(T))));
+}
+
+std::atomic<U64> nextRecorderId{1};
+
+constexpr std::size_t RING_MASK = Recorder::PRODUCER_BUFFER_BYTES - 1;
+
+static_assert(std::has_single_bit(Recorder::PRODUCER_BUFFER_BYTES),
+              "Recorder::PRODUCER_BUFFER_BYTES must be a power of two");
+
+// The rings are indexed by ever-growing positions, wrapped with RING_MASK
+
+void ring_write(std::byte *ring, const U64 pos, const void *src, const std::size_t size) {
+  const std::size_t at    = pos & RING_MASK;
+  const std::size_t first = std::min(size, Recorder::PRODUCER_BUFFER_BYTES - at);
+  std::memcpy(ring + at, src, first);
+  std::memcpy(ring, static_cast<const std::byte *>(src) + first, size - first);
+}
+
+void ring_read(const std::byte *ring, const U64 pos, void *dst, const std::size_t size) {
+  const std::size_t at    = pos & RING_MASK;
+  const std::size_t first = std::min(size, Recorder::PRODUCER_BUFFER_BYTES - at);
+  std::memcpy(dst, ring + at, first);
+  std::memcpy(static_cast<std::byte *>(dst) + first, ring, size - first);
+}
+
+template<typename T>
+U64 ring_put(std::byte *ring, const U64 pos, const T &value) {
+  ring_write(ring, pos, &value, sizeof(T));
+  return pos + sizeof(T);
+}
+
+template<typename T>
+U64 ring_get(const std::byte *ring, const U64 pos, T &value) {
+  ring_read(ring, pos, &value, sizeof(T));
+  return pos + sizeof(T);
+}
+
+void write_ring(std::ostream &out, const std::byte *ring, const U64 pos, const std::size_t size) {
+  const std::size_t at    = pos & RING_MASK;
+  const std::size_t first = std::min(size, Recorder::PRODUCER_BUFFER_BYTES - at);
+  out.write(reinterpret_cast<const char *>(ring + at), static_cast<std::streamsize>(first));
+  out.write(reinterpret_cast<const char *>(ring), static_cast<std::streamsize>(size - first));
+}
+
+}  // namespace
+
+/**
+ * Single-producer, single-consumer ring of records, laid out as in the file. The producer thread
+ * only moves head and the writer only moves tail.
+ */
+struct Recorder::ProducerBuffer_ {
+  alignas(CACHE_LINE_SIZE) std::atomic<U64> head{0};
+  alignas(CACHE_LINE_SIZE) std::atomic<U64> tail{0};
+
+  const std::unique_ptr<std::byte[]> ring = std::make_unique<std::byte[]>(PRODUCER_BUFFER_BYTES);
+};
+
+Recorder::Recorder(MQHive &hive, IClock &clock, const std::filesystem::path &path)
+  : hive_(hive),
+    clock_(clock),
+    start_(clock.now()),
+    id_(nextRecorderId.fetch_add(1, std::memory_order::relaxed)),
+    file_(path, std::ios::binary | std::ios::trunc) {
+  if(!file_) {
+    throw std::runtime_error(std::format("Recorder: failed to open {}", path.string()));
+  }
+  file_.write(detail_::CAPTURE_MAGIC.data(),
+              static_cast<std::streamsize>(detail_::CAPTURE_MAGIC.size()));
+
+  writerThread_ = std::jthread([this](const std::stop_token stop) { run_writer_(stop); });
+}
+
+Recorder::~Recorder() {
+  for(const auto &untap : untaps_) {
+    untap();
+  }
+
+  writerThread_.request_stop();
+  writerThread_.join();
+  flush();
+}
+
+U64 Recorder::recorded() {
+  const std::scoped_lock fileLock(fileMutex_);
+  write_pending_();
+  return recorded_;
+}
+
+void Recorder::flush() {
+  const std::scoped_lock fileLock(fileMutex_);
+  write_pending_();
+  file_.flush();
+}
+
+Recorder::ProducerBuffer_ &Recorder::buffer_() {
+  // Saves taking buffersMutex_ for every message; a thread that records for two recorders in turn
+  // just goes back to the map more often
+  struct Cached {
+    U64              recorder = 0;
+    ProducerBuffer_ *buffer   = nullptr;
+  };
+  thread_local Cached cached;
+
+  if(cached.recorder != id_) {
+    const std::scoped_lock buffersLock(buffersMutex_);
+    auto &buffer = buffers_[std::this_thread::get_id()];
+    if(!buffer) {
+      buffer = std::make_unique<ProducerBuffer_>();
+    }
+    cached = {.recorder = id_, .buffer = buffer.get()};
+  }
+  return *cached.buffer;
+}
+
+void Recorder::append_(const U64                        channel,
+                       const Hash_t                     typeHash,
+                       const Priority                   priority,
+                       const std::span<const std::byte> payload) {
+  ProducerBuffer_  &buffer = buffer_();
+  const std::size_t size   = detail_::CAPTURE_HEADER_BYTES + payload.size();
+  const U64         head   = buffer.head.load(std::memory_order::relaxed);
+
+  while(head + size - buffer.tail.load(std::memory_order::acquire) > PRODUCER_BUFFER_BYTES) {
+    backlogged_.store(true, std::memory_order::relaxed);
+    wake_.notify_one();
+    std::this_thread::yield();
+  }
+
+  const S64 offset = std::chrono::duration_cast<Duration_t>(clock_.now() - start_).count();
+
+  std::byte *ring = buffer.ring.get();
+  U64        pos  = head;
+  pos             = ring_put(ring, pos, offset);
+  pos             = ring_put(ring, pos, channel);
+  pos             = ring_put(ring, pos, typeHash);
+  pos             = ring_put(ring, pos, static_cast<U32>(payload.size()));
+  pos             = ring_put(ring, pos, std::to_underlying(priority));
+  ring_write(ring, pos, payload.data(), payload.size());
+
+  buffer.head.store(head + size, std::memory_order::release);
+}
+
+void Recorder::run_writer_(const std::stop_token stop) {
+  std::unique_lock wakeLock(wakeMutex_);
+  while(!stop.stop_requested()) {
+    // Woken early by the stop request, or by a producer whose buffer is full
+    wake_.wait_for(wakeLock, stop, WRITE_INTERVAL, [this] {
+      return backlogged_.load(std::memory_order::relaxed);
+    });
+    backlogged_.store(false, std::memory_order::relaxed);
+
+    const std::scoped_lock fileLock(fileMutex_);
+    write_pending_();
+  }
+}
+
+void Recorder::write_pending_() {
+  cursors_.clear();
+  {
+    const std::scoped_lock buffersLock(buffersMutex_);
+    for(const auto &[thread, buffer] : buffers_) {
+      // Only moved here, under fileMutex_
+      const U64 tail = buffer->tail.load(std::memory_order::relaxed);
+      const U64 head = buffer->head.load(std::memory_order::acquire);
+      if(tail != head) {
+        cursors_.push_back({.buffer = buffer.get(), .tail = tail, .head = head});
+      }
+    }
+  }
+
+  // Each buffer is in stamping order, so merge them by always taking the earliest front record
+  while(!cursors_.empty()) {
+    auto earliest       = cursors_.begin();
+    S64  earliestOffset = 0;
+    ring_get(earliest->buffer->ring.get(), earliest->tail, earliestOffset);
+    for(auto it = std::next(cursors_.begin()); it != cursors_.end(); ++it) {
+      S64 offset = 0;
+      ring_get(it->buffer->ring.get(), it->tail, offset);
+      if(offset < earliestOffset) {
+        earliest       = it;
+        earliestOffset = offset;
+      }
+    }
+
+    const std::byte *ring     = earliest->buffer->ring.get();
+    U64              pos      = earliest->tail + sizeof(S64);
+    U64              channel  = 0;
+    Hash_t           typeHash = 0;
+    U32              size     = 0;
+    U8               priority = 0;
+    pos                       = ring_get(ring, pos, channel);
+    pos                       = ring_get(ring, pos, typeHash);
+    pos                       = ring_get(ring, pos, size);
+    pos                       = ring_get(ring, pos, priority);
+
+    lastOffset_ = std::max(lastOffset_, earliestOffset);
+
+    write_field(file_, lastOffset_);
+    write_field(file_, channel);
+    write_field(file_, typeHash);
+    write_field(file_, size);
+    write_field(file_, priority);
+    write_ring(file_, ring, pos, size);
+    ++recorded_;
+
+    earliest->tail = pos + size;
+    earliest->buffer->tail.store(earliest->tail, std::memory_order::release);
+    if(earliest->tail == earliest->head) {
+      *earliest = cursors_.back();
+      cursors_.pop_back();
+    }
+  }
+}
+
+Replayer::Replayer(MQHive &hive, const std::filesystem::path &path)
+  : hive_(hive), file_(path, std::ios::binary) {
+  std::array<char, detail_::CAPTURE_MAGIC.size()> magic{};
+  if(!read_field(file_, magic) || magic != detail_::CAPTURE_MAGIC) {
+    throw std::runtime_error(std::format("Replayer: {} is not a capture file", path.string()));
+  }
+}
+
+void Replayer::start(Scheduler &scheduler, IClock &clock, ReplayConfig config) {
+  if(config.timing == ReplayTiming::Scaled && !(config.speed > 0.0)) {
+    throw std::invalid_argument(
+      std::format("Replayer: replay speed must be positive (got {})", config.speed));
+  }
+
+  scheduler_   = &scheduler;
+  clock_       = &clock;
+  config_      = std::move(config);
+  replayStart_ = clock.now();
+  hasNext_     = read_next_();
+  firstOffset_ = hasNext_ ? next_.offset : Duration_t{0};
+
+  scheduler.do_now([this] { step_(); }, "replay");
+}
+
+bool Replayer::read_next_() {
+  S64 offset   = 0;
+  U32 size     = 0;
+  U8  priority = 0;
+
+  // A capture cut short (e.g. by a crash) simply ends at its last complete record
+  if(!read_field(file_, offset) || !read_field(file_, next_.channel)
+     || !read_field(file_, next_.typeHash) || !read_field(file_, size)
+     || !read_field(file_, priority))
+  {
+    return false;
+  }
+
+  next_.offset   = Duration_t(offset);
+  next_.priority = static_cast<Priority>(priority);
+  next_.payload.resize(size);
+  return static_cast<bool>(
+    file_.read(reinterpret_cast<char *>(next_.payload.data()), static_cast<std::streamsize>(size)));
+}
+
+TimePoint_t Replayer::due_(const detail_::CaptureRecord &record) const {
+  const Duration_t elapsed = record.offset - firstOffset_;
+
+  switch(config_.timing) {
+    case ReplayTiming::AsFastAsPossible:
+      return replayStart_;
+    case ReplayTiming::Scaled:
+      return replayStart_
+           + std::chrono::duration_cast<Duration_t>(
+               std::chrono::duration<double, Duration_t::period>(elapsed) / config_.speed);
+    case ReplayTiming::Original:
+      break;
+  }
+  return replayStart_ + elapsed;
+}
+
+void Replayer::step_() {
+  const TimePoint_t now = clock_->now();
+
+  for(std::size_t i = 0; i < MAX_BATCH; ++i) {
+    if(!hasNext_) {
+      finished_.store(true, std::memory_order::release);
+      if(config_.onFinished) {
+        config_.onFinished();
+      }
+      return;
+    }
+
+    if(const TimePoint_t due = due_(next_); due > now) {
+      scheduler_->set_timeout(due - now, [this] { step_(); }, "replay");
+      return;
+    }
+
+    const auto it = routes_.find(next_.channel);
+    if(it != routes_.end() && it->second->inject(next_)) {
+      replayed_.fetch_add(1, std::memory_order::relaxed);
+    }
+    else {
+      skipped_.fetch_add(1, std::memory_order::relaxed);
+    }
+
+    hasNext_ = read_next_();
+  }
+
+  // Let other jobs in before carrying on
+  scheduler_->do_now([this] { step_(); }, "replay");
+}
+
+}  // namespace mgfw
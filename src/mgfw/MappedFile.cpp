@@ -0,0 +1,47 @@
+#include "mgfw/MappedFile.hpp"
+
+#include "mgfw/Mapping.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mgfw {
+
+MappedFile MappedFile::open(const std::filesystem::path &path) {
+  const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+  if(fd < 0) {
+    Mapping::throw_errno("MappedFile", "failed to open", path.string());
+  }
+
+  struct stat st { };
+  if(::fstat(fd, &st) != 0) {
+    ::close(fd);
+    Mapping::throw_errno("MappedFile", "failed to stat", path.string());
+  }
+
+  return {path, fd, static_cast<std::size_t>(st.st_size)};
+}
+
+MappedFile MappedFile::create(const std::filesystem::path &path, const std::size_t size) {
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if(fd < 0) {
+    Mapping::throw_errno("MappedFile", "failed to create", path.string());
+  }
+
+  if(::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    ::close(fd);
+    Mapping::throw_errno("MappedFile", "failed to resize", path.string());
+  }
+
+  return {path, fd, size};
+}
+
+MappedFile::MappedFile(std::filesystem::path path, const int fd, const std::size_t size)
+  : path_(std::move(path)), mapping_("MappedFile", path_.string(), fd, size) { }
+
+}  // namespace mgfw
@@ -0,0 +1,87 @@
+#include "mgfw/Mapping.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <format>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mgfw {
+
+Mapping::Mapping(const std::string_view owner,
+                 std::string            name,
+                 const int              fd,
+                 const std::size_t      size)
+  : owner_(owner), name_(std::move(name)), fd_(fd), size_(size) {
+  if(size_ == 0) {
+    return;
+  }
+
+  void *data = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if(data == MAP_FAILED) {
+    const int error = errno;
+    ::close(fd_);
+    errno = error;
+    throw_errno(owner_, "failed to map", name_);
+  }
+  data_ = static_cast<std::byte *>(data);
+}
+
+Mapping::~Mapping() { close_(); }
+
+Mapping::Mapping(Mapping &&other) noexcept
+  : owner_(other.owner_),
+    name_(std::move(other.name_)),
+    fd_(std::exchange(other.fd_, -1)),
+    data_(std::exchange(other.data_, nullptr)),
+    size_(std::exchange(other.size_, 0)) { }
+
+Mapping &Mapping::operator=(Mapping &&other) noexcept {
+  if(this != &other) {
+    close_();
+    owner_ = other.owner_;
+    name_  = std::move(other.name_);
+    fd_    = std::exchange(other.fd_, -1);
+    data_  = std::exchange(other.data_, nullptr);
+    size_  = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+void Mapping::sync(const std::size_t offset, const std::size_t length) const {
+  if(data_ == nullptr || length == 0) {
+    return;
+  }
+
+  // msync wants a page-aligned start address
+  const auto pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  const auto start    = offset / pageSize * pageSize;
+  if(::msync(data_ + start, offset + length - start, MS_SYNC) != 0) {
+    throw_errno(owner_, "failed to sync", name_);
+  }
+}
+
+void Mapping::throw_errno(const std::string_view owner,
+                          const std::string_view what,
+                          const std::string_view name) {
+  throw std::system_error(
+    errno, std::generic_category(), std::format("{}: {} {}", owner, what, name));
+}
+
+void Mapping::close_() noexcept {
+  if(data_ != nullptr) {
+    ::munmap(data_, size_);
+    data_ = nullptr;
+  }
+  if(fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+}  // namespace mgfw
@@ -0,0 +1,174 @@
+#include "mgfw/SharedMQHive.hpp"
+
+#include "mgfw/defer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace mgfw {
+
+namespace {
+
+using detail_::SharedChannelEntry;
+using detail_::SharedHiveHeader;
+using detail_::SharedRingHeader;
+
+// How long to wait for another process to finish initializing a segment it just created
+constexpr auto ATTACH_TIMEOUT = std::chrono::seconds(1);
+
+constexpr std::size_t align_up(const std::size_t n) {
+  return (n + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+}
+
+constexpr std::size_t channels_offset() { return align_up(sizeof(SharedHiveHeader)); }
+
+void lock(SharedHiveHeader &header) {
+  std::atomic_ref<U32> lockRef(header.lock);
+  while(lockRef.exchange(1, std::memory_order::acquire) != 0) {
+    std::this_thread::yield();
+  }
+}
+
+void unlock(SharedHiveHeader &header) {
+  std::atomic_ref<U32>(header.lock).store(0, std::memory_order::release);
+}
+
+std::string_view stored_type_string(const SharedChannelEntry &entry) {
+  return {entry.typeString.data(),
+          std::find(entry.typeString.begin(), entry.typeString.end(), '\0')};
+}
+
+}  // namespace
+
+SharedMQHive::SharedMQHive(std::string name, const SharedHiveConfig &config)
+  : memory_(create_or_attach_(name, config)) { }
+
+SharedMemory SharedMQHive::create_or_attach_(const std::string      &name,
+                                             const SharedHiveConfig &config) {
+  const std::size_t heapOffset = align_up(channels_offset()
+                                          + config.maxChannels * sizeof(SharedChannelEntry));
+
+  if(std::optional<SharedMemory> created = SharedMemory::create(name, heapOffset + config.heapSize))
+  {
+    auto &header       = *reinterpret_cast<SharedHiveHeader *>(created->bytes().data());
+    header.version     = SharedHiveHeader::VERSION;
+    header.maxChannels = config.maxChannels;
+    header.size        = created->bytes().size();
+    header.heapTop     = heapOffset;
+    std::atomic_ref<U64>(header.magic).store(SharedHiveHeader::MAGIC, std::memory_order::release);
+    return std::move(*created);
+  }
+
+  // Someone else created the segment; wait for them to size and initialize it
+  const auto deadline = std::chrono::steady_clock::now() + ATTACH_TIMEOUT;
+  while(true) {
+    SharedMemory memory = SharedMemory::open(name);
+    if(memory.bytes().size() >= sizeof(SharedHiveHeader)) {
+      auto &header = *reinterpret_cast<SharedHiveHeader *>(memory.bytes().data());
+      if(std::atomic_ref<U64>(header.magic).load(std::memory_order::acquire)
+         == SharedHiveHeader::MAGIC)
+      {
+        if(header.version != SharedHiveHeader::VERSION || header.size != memory.bytes().size()) {
+          throw std::runtime_error(
+            std::format("SharedMQHive {}: incompatible shared memory segment", name));
+        }
+        return memory;
+      }
+    }
+
+    if(std::chrono::steady_clock::now() > deadline) {
+      throw std::runtime_error(
+        std::format("SharedMQHive {}: timed out waiting for the segment to be initialized", name));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+SharedHiveHeader &SharedMQHive::header_() const {
+  return *reinterpret_cast<SharedHiveHeader *>(memory_.bytes().data());
+}
+
+SharedChannelEntry *SharedMQHive::channels_() const {
+  return reinterpret_cast<SharedChannelEntry *>(memory_.bytes().data() + channels_offset());
+}
+
+SharedRingHeader &SharedMQHive::get_or_create_ring_(const U64                        id,
+                                                     const std::size_t                capacity,
+                                                     const detail_::SharedRingLayout &layout) {
+  SharedHiveHeader &header = header_();
+  lock(header);
+  const defer unlockHeader([&header] { unlock(header); });
+
+  SharedChannelEntry *const channels = channels_();
+  SharedChannelEntry *const end      = channels + header.channelCount;
+
+  if(const auto *const it =
+       std::find_if(channels, end, [id](const SharedChannelEntry &e) { return e.id == id; });
+     it != end)
+  {
+    if(it->typeHash != layout.typeHash || it->recordSize != layout.recordSize) {
+      throw std::runtime_error(
+        std::format("Type mismatch on SharedMQHive {} (id = {}, storedType = {}, currentType = {})",
+                    name(),
+                    id,
+                    stored_type_string(*it),
+                    layout.typeString));
+    }
+    return *reinterpret_cast<SharedRingHeader *>(memory_.bytes().data() + it->ringOffset);
+  }
+
+  if(header.channelCount == header.maxChannels) {
+    throw std::runtime_error(
+      std::format("SharedMQHive {}: no room for channel {} (maxChannels = {})",
+                  name(),
+                  id,
+                  header.maxChannels));
+  }
+
+  // The ring's full/empty checks need at least two cells
+  const std::size_t ringCapacity = std::bit_ceil(std::max(capacity, std::size_t{2}));
+  const std::size_t ringSize =
+    align_up(sizeof(SharedRingHeader) + ringCapacity * layout.cellStride);
+  if(ringSize > header.size - header.heapTop) {
+    throw std::runtime_error(
+      std::format("SharedMQHive {}: no room for channel {} ({} bytes needed, {} available)",
+                  name(),
+                  id,
+                  ringSize,
+                  header.size - header.heapTop));
+  }
+
+  std::byte *const ringBytes = memory_.bytes().data() + header.heapTop;
+  auto            &ring      = *reinterpret_cast<SharedRingHeader *>(ringBytes);
+  ring.capacity              = ringCapacity;
+  ring.cellStride            = layout.cellStride;
+  ring.payloadOffset         = layout.payloadOffset;
+  for(std::size_t i = 0; i < ringCapacity; ++i) {
+    *reinterpret_cast<U64 *>(ringBytes + sizeof(SharedRingHeader) + i * layout.cellStride) = i;
+  }
+
+  SharedChannelEntry &entry = channels[header.channelCount];
+  entry.id                  = id;
+  entry.typeHash            = layout.typeHash;
+  entry.recordSize          = static_cast<U32>(layout.recordSize);
+  entry.ringOffset          = header.heapTop;
+  const std::size_t typeStringSize =
+    std::min(layout.typeString.size(), SharedChannelEntry::TYPE_STRING_SIZE - 1);
+  std::copy_n(layout.typeString.begin(), typeStringSize, entry.typeString.begin());
+
+  header.heapTop += ringSize;
+  ++header.channelCount;
+  return ring;
+}
+
+}  // namespace mgfw
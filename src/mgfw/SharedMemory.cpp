@@ -0,0 +1,63 @@
+#include "mgfw/SharedMemory.hpp"
+
+#include "mgfw/Mapping.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mgfw {
+
+std::optional<SharedMemory> SharedMemory::create(const std::string &name, const std::size_t size) {
+  const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+  if(fd < 0) {
+    if(errno == EEXIST) {
+      return std::nullopt;
+    }
+    Mapping::throw_errno("SharedMemory", "failed to create", name);
+  }
+
+  if(::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    ::close(fd);
+    ::shm_unlink(name.c_str());
+    Mapping::throw_errno("SharedMemory", "failed to resize", name);
+  }
+
+  return SharedMemory(name, fd, size);
+}
+
+SharedMemory SharedMemory::open(const std::string &name) {
+  const int fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+  if(fd < 0) {
+    Mapping::throw_errno("SharedMemory", "failed to open", name);
+  }
+
+  struct stat st { };
+  if(::fstat(fd, &st) != 0) {
+    ::close(fd);
+    Mapping::throw_errno("SharedMemory", "failed to stat", name);
+  }
+
+  return {name, fd, static_cast<std::size_t>(st.st_size)};
+}
+
+bool SharedMemory::remove(const std::string &name) {
+  if(::shm_unlink(name.c_str()) != 0) {
+    if(errno == ENOENT) {
+      return false;
+    }
+    Mapping::throw_errno("SharedMemory", "failed to remove", name);
+  }
+  return true;
+}
+
+SharedMemory::SharedMemory(const std::string &name, const int fd, const std::size_t size)
+  : mapping_("SharedMemory", name, fd, size) { }
+
+}  // namespace mgfw
@@ -0,0 +1,79 @@
+#include "mgfw/WorkerPool.hpp"
+
+#include "mgfw/ILogger.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <format>
+#include <mutex>
+#include <utility>
+
+namespace mgfw {
+
+WorkerPool::WorkerPool(ILogger &logger, const std::size_t threads) : logger_(logger) {
+  workers_.reserve(threads);
+  for(std::size_t i = 0; i < threads; ++i) {
+    workers_.emplace_back([this] { work_(); });
+  }
+}
+
+WorkerPool::~WorkerPool() { stop(); }
+
+void WorkerPool::do_now(JobFunc_t func) {
+  {
+    const std::scoped_lock lock(mutex_);
+    if(stopping_) {
+      return;
+    }
+    jobs_.push_back(std::move(func));
+  }
+  cv_.notify_one();
+}
+
+void WorkerPool::stop() {
+  std::deque<JobFunc_t> discarded;
+  {
+    const std::scoped_lock lock(mutex_);
+    stopping_ = true;
+    discarded.swap(jobs_);
+  }
+  cv_.notify_all();
+
+  for(auto &worker : workers_) {
+    if(worker.joinable()) {
+      worker.join();
+    }
+  }
+
+  // Destroyed outside the lock, since jobs may own things that call back into the pool
+  discarded.clear();
+}
+
+void WorkerPool::work_() {
+  while(true) {
+    JobFunc_t job;
+    {
+      std::unique_lock lock(mutex_);
+      cv_.wait(lock, [&] { return stopping_ || !jobs_.empty(); });
+      if(stopping_) {
+        return;
+      }
+
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+
+    try {
+      job();
+    }
+    catch(const std::exception &e) {
+      logger_.error(std::format("Worker job threw an exception: {}", e.what()));
+    }
+    catch(...) {
+      logger_.error("Worker job threw an exception!");
+    }
+  }
+}
+
+}  // namespace mgfw
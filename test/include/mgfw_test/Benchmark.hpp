@@ -0,0 +1,34 @@
+#pragma once
+
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <utility>
+
+namespace mgfw_test {
+
+/**
+ * Run `fn` once and return its wall time divided by `operations`, in nanoseconds
+ */
+template<std::invocable Fn_t>
+double ns_per_op(const std::size_t operations, Fn_t &&fn) {
+  const auto start = std::chrono::steady_clock::now();
+  std::invoke(std::forward<Fn_t>(fn));
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())
+       / static_cast<double>(operations);
+}
+
+/**
+ * Print one line of benchmark results to stdout
+ */
+template<typename... Args>
+void report(std::format_string<Args...> fmt, Args &&...args) {
+  std::cout << std::format(fmt, std::forward<Args>(args)...) << '\n';
+}
+
+}  // namespace mgfw_test
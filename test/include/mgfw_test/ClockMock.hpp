@@ -3,10 +3,13 @@
 #include "mgfw/IClock.hpp"
 #include "mgfw/types.hpp"
 
+#include <atomic>
+
 namespace mgfw_test {
 
 /**
- * Alternate clock source that allows for deterministic testing of real-time code
+ * Alternate clock source that allows for deterministic testing of real-time code. The time may be
+ * set from another thread than the one reading it.
  */
 class ClockMock : public mgfw::IClock {
 public:
@@ -18,14 +21,16 @@ public:
   ClockMock &operator=(const ClockMock &) = delete;
   ClockMock &operator=(ClockMock &&)      = delete;
 
-  mgfw::TimePoint_t now() const noexcept override { return now_; }
+  mgfw::TimePoint_t now() const noexcept override { return now_.load(std::memory_order::acquire); }
 
-  void set_now(const mgfw::TimePoint_t now) noexcept { now_ = now; }
+  void set_now(const mgfw::TimePoint_t now) noexcept {
+    now_.store(now, std::memory_order::release);
+  }
 
   void sleep_until([[maybe_unused]] const mgfw::TimePoint_t then) override { /* noop */ }
 
 private:
-  mgfw::TimePoint_t now_;
+  std::atomic<mgfw::TimePoint_t> now_;
 };
 
 }  // namespace mgfw_test
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace mgfw_test {
+
+/**
+ * Executor whose jobs only run when the test says so
+ */
+struct ManualExecutor {
+  void do_now(std::function<void()> job) { jobs.push_back(std::move(job)); }
+
+  void run_all() {
+    while(!jobs.empty()) {
+      auto job = std::move(jobs.front());
+      jobs.erase(jobs.begin());
+      job();
+    }
+  }
+
+  std::vector<std::function<void()>> jobs;
+};
+
+}  // namespace mgfw_test
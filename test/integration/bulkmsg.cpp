@@ -8,6 +8,7 @@
 
 #include <gtest/gtest.h>
 
+#include <array>
 #include <string>
 #include <vector>
 
@@ -39,7 +40,11 @@ class Sender {
 public:
   explicit Sender(EventWriter<Msg> writer) : writer_(std::move(writer)) { }
 
-  void send_it() { writer_.write_bulk({{"foo"}, {"bar"}, {"baz"}}); }
+  void send_it() {
+    // Handing over the batch as an rvalue moves the messages into the queue
+    std::array<Msg, 3> batch{{{"foo"}, {"bar"}, {"baz"}}};
+    writer_.write_bulk(std::move(batch));
+  }
 
 private:
   EventWriter<Msg> writer_;
@@ -0,0 +1,112 @@
+#include "mgfw/MQHive.hpp"
+#include "mgfw/ReadMostlyIndex.hpp"
+#include "mgfw/SyncCell.hpp"
+#include "mgfw/types.hpp"
+#include "mgfw_test/Benchmark.hpp"
+#include "mgfw_test/LoggerMock.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <latch>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using mgfw::MQHive;
+using mgfw::ReadMostlyIndex;
+using mgfw::SyncCell;
+using mgfw::U64;
+
+namespace {
+
+constexpr int         THREADS            = 32;
+constexpr U64         CHANNELS           = 64;
+constexpr std::size_t LOOKUPS_PER_THREAD = 200'000;
+
+struct Channel {
+  U64 id;
+};
+
+/**
+ * Run `lookup` from THREADS threads at once, timed from the moment they are all released to the
+ * moment the last one is done, and return the average wall time per lookup
+ */
+template<typename Fn_t>
+double ns_per_lookup(const Fn_t &lookup) {
+  std::latch                ready(THREADS + 1);
+  std::atomic<U64>          checksum{0};
+  std::vector<std::jthread> threads;
+
+  for(int t = 0; t < THREADS; ++t) {
+    threads.emplace_back([&, t] {
+      U64 sum = 0;
+      ready.arrive_and_wait();
+      for(std::size_t i = 0; i < LOOKUPS_PER_THREAD; ++i) {
+        sum += lookup((static_cast<U64>(t) + i) % CHANNELS)->id;
+      }
+      checksum.fetch_add(sum, std::memory_order::relaxed);
+    });
+  }
+
+  ready.arrive_and_wait();
+  const double ns = mgfw_test::ns_per_op(LOOKUPS_PER_THREAD * THREADS, [&] { threads.clear(); });
+
+  EXPECT_GT(checksum.load(), 0);
+  return ns;
+}
+
+}  // namespace
+
+/**
+ * Has THREADS threads look channels up at once, first in a mutex-guarded unordered_map (what MQHive
+ * used to do) and then in a ReadMostlyIndex (what it does now), and prints the cost per lookup of
+ * each; how far apart they are mostly comes down to the number of cores. Then hammers get_writer on
+ * a real hive from the same number of threads, and checks that they all share one queue per
+ * channel.
+ */
+TEST(Integration, hiveLookupUnderContention) {
+  std::vector<std::unique_ptr<Channel>> channels;
+  for(U64 id = 0; id < CHANNELS; ++id) {
+    channels.push_back(std::make_unique<Channel>(id));
+  }
+
+  SyncCell<std::unordered_map<U64, Channel *>> lockedMap;
+  ReadMostlyIndex<Channel>                     index;
+  for(const auto &channel : channels) {
+    lockedMap.get_locked()->emplace(channel->id, channel.get());
+    index.insert(channel->id, channel.get());
+  }
+
+  const double locked =
+    ns_per_lookup([&](const U64 id) { return lockedMap.get_locked()->find(id)->second; });
+  const double lockFree = ns_per_lookup([&](const U64 id) { return index.find(id); });
+
+  mgfw_test::report("{} threads, {} channels: mutex + unordered_map {:.1f} ns/lookup, "
+                    "ReadMostlyIndex {:.1f} ns/lookup",
+                    THREADS,
+                    CHANNELS,
+                    locked,
+                    lockFree);
+
+  // The real thing, end to end; endpoint construction dominates here
+  mgfw_test::LoggerMock logger;
+  MQHive                hive(logger);
+  for(U64 id = 0; id < CHANNELS; ++id) {
+    hive.get_writer<int>(id);
+  }
+
+  std::vector<std::jthread> workers;
+  for(int t = 0; t < THREADS; ++t) {
+    workers.emplace_back([&, t] {
+      for(U64 i = 0; i < 1000; ++i) {
+        hive.get_writer<int>((static_cast<U64>(t) + i) % CHANNELS).write(1);
+      }
+    });
+  }
+  workers.clear();
+
+  EXPECT_EQ(CHANNELS, hive.snapshot().size());
+}
@@ -0,0 +1,153 @@
+#include "mgfw/Dispatch.hpp"
+#include "mgfw/EventReader.hpp"
+#include "mgfw/EventWriter.hpp"
+#include "mgfw/MQHive.hpp"
+#include "mgfw/types.hpp"
+#include "mgfw_test/Benchmark.hpp"
+#include "mgfw_test/LoggerMock.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <variant>
+
+using mgfw::EventReader;
+using mgfw::EventWriter;
+using mgfw::MQHive;
+using mgfw::U64;
+
+namespace {
+
+constexpr std::size_t TICKS             = 2'000;
+constexpr std::size_t MESSAGES_PER_TICK = 64;
+
+struct Quote {
+  U64 price;
+};
+
+struct Trade {
+  U64 quantity;
+};
+
+struct Status {
+  U64 code;
+};
+
+struct Heartbeat {
+  U64 seq;
+};
+
+using Market_t = std::variant<Quote, Trade, Status, Heartbeat>;
+
+/**
+ * Checksum that depends on the order messages are handled in, not just on which ones are
+ */
+struct Digest {
+  void add(const U64 kind, const U64 value) { hash = (hash * 31) + (kind << 32U) + value; }
+
+  U64 hash = 0;
+};
+
+/**
+ * Run TICKS rounds of writing MESSAGES_PER_TICK messages, cycling through the four kinds, then
+ * draining them. Returns the average wall time per message.
+ */
+template<typename Write_t, typename Drain_t>
+double ns_per_message(const Write_t &write, const Drain_t &drain) {
+  return mgfw_test::ns_per_op(TICKS * MESSAGES_PER_TICK, [&] {
+    for(std::size_t tick = 0; tick < TICKS; ++tick) {
+      for(U64 i = 0; i < MESSAGES_PER_TICK; ++i) {
+        write(i);
+      }
+      drain();
+    }
+  });
+}
+
+}  // namespace
+
+/**
+ * Sends the same interleaved stream of four message kinds through one queue per kind (drained kind
+ * by kind) and through a single queue of variants (drained with EventReader::dispatch), printing
+ * the cost per message of both. The digests check what the variant queue buys: it hands messages
+ * back in the order they were written, which the per-kind queues can't.
+ */
+TEST(Integration, variantDispatchVersusQueuePerType) {
+  mgfw_test::LoggerMock logger;
+  MQHive                hive(logger);
+
+  EventWriter<Quote>     quoteWriter     = hive.get_writer<Quote>(1);
+  EventWriter<Trade>     tradeWriter     = hive.get_writer<Trade>(2);
+  EventWriter<Status>    statusWriter    = hive.get_writer<Status>(3);
+  EventWriter<Heartbeat> heartbeatWriter = hive.get_writer<Heartbeat>(4);
+  EventReader<Quote>     quoteReader     = hive.get_reader<Quote>(1);
+  EventReader<Trade>     tradeReader     = hive.get_reader<Trade>(2);
+  EventReader<Status>    statusReader    = hive.get_reader<Status>(3);
+  EventReader<Heartbeat> heartbeatReader = hive.get_reader<Heartbeat>(4);
+
+  Digest perType;
+  Digest expected;
+
+  const double perTypeNs = ns_per_message(
+    [&](const U64 i) {
+      expected.add(i % 4, i);
+      switch(i % 4) {
+        case 0:
+          quoteWriter.write({i});
+          break;
+        case 1:
+          tradeWriter.write({i});
+          break;
+        case 2:
+          statusWriter.write({i});
+          break;
+        default:
+          heartbeatWriter.write({i});
+          break;
+      }
+    },
+    [&] {
+      quoteReader.drain([&](const Quote &msg) { perType.add(0, msg.price); });
+      tradeReader.drain([&](const Trade &msg) { perType.add(1, msg.quantity); });
+      statusReader.drain([&](const Status &msg) { perType.add(2, msg.code); });
+      heartbeatReader.drain([&](const Heartbeat &msg) { perType.add(3, msg.seq); });
+    });
+
+  EventWriter<Market_t> marketWriter = hive.get_writer<Market_t>(5);
+  EventReader<Market_t> marketReader = hive.get_reader<Market_t>(5);
+
+  Digest variant;
+
+  const double variantNs = ns_per_message(
+    [&](const U64 i) {
+      switch(i % 4) {
+        case 0:
+          marketWriter.write(Quote{i});
+          break;
+        case 1:
+          marketWriter.write(Trade{i});
+          break;
+        case 2:
+          marketWriter.write(Status{i});
+          break;
+        default:
+          marketWriter.write(Heartbeat{i});
+          break;
+      }
+    },
+    [&] {
+      marketReader.dispatch([&](const Quote &msg) { variant.add(0, msg.price); },
+                            [&](const Trade &msg) { variant.add(1, msg.quantity); },
+                            [&](const Status &msg) { variant.add(2, msg.code); },
+                            [&](const Heartbeat &msg) { variant.add(3, msg.seq); });
+    });
+
+  mgfw_test::report("{} messages per tick over 4 kinds: queue per type {:.1f} ns/message, "
+                    "variant queue + dispatch {:.1f} ns/message",
+                    MESSAGES_PER_TICK,
+                    perTypeNs,
+                    variantNs);
+
+  EXPECT_EQ(expected.hash, variant.hash);
+  EXPECT_NE(expected.hash, perType.hash);
+}
@@ -0,0 +1,112 @@
+#include "mgfw/ArenaChannel.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using mgfw::ArenaChannel;
+using mgfw::ArenaReader;
+using mgfw::ArenaRecord;
+using mgfw::ArenaWriter;
+
+struct Position {
+  int   entity;
+  float x;
+  float y;
+};
+
+TEST(ArenaChannelTest, ReaderDispatchesOnRecordType) {
+  ArenaChannel channel(1);
+  ArenaWriter  writer(channel);
+  ArenaReader  reader(channel);
+
+  writer.write(Position{.entity = 7, .x = 1.5F, .y = -2.0F});
+  writer.write(std::string("spawned"));
+  writer.write(std::vector<int>{1, 2, 3});
+  writer.write("literal");
+  writer.write(std::string_view());
+  EXPECT_EQ(5, channel.size_approx());
+
+  std::vector<std::string> log;
+  reader.drain([&](const ArenaRecord &record) {
+    if(record.is<Position>()) {
+      const auto pos = record.as<Position>();
+      log.push_back(std::to_string(pos.entity) + "@" + std::to_string(pos.x));
+    }
+    else if(record.is<std::string_view>()) {
+      log.emplace_back(record.as<std::string_view>());
+    }
+    else if(record.is<std::span<const int>>()) {
+      const auto values = record.as<std::span<const int>>();
+      log.push_back(std::to_string(values.size()) + " ints ending in "
+                    + std::to_string(values.back()));
+    }
+  });
+
+  EXPECT_EQ(log,
+            (std::vector<std::string>{
+              "7@1.500000", "spawned", "3 ints ending in 3", "literal", ""}));
+  EXPECT_EQ(0, channel.size_approx());
+}
+
+TEST(ArenaChannelTest, RecordsSpanChunksAndChunksAreReused) {
+  // Tiny chunks, so that records spill over into new ones (and some get a dedicated chunk)
+  ArenaChannel channel(1, 32);
+  ArenaWriter  writer(channel);
+  ArenaReader  reader(channel);
+
+  for(int round = 0; round < 3; ++round) {
+    std::vector<std::string> written;
+    for(std::size_t len = 0; len < 64; len += 5) {
+      written.emplace_back(len, static_cast<char>('a' + round));
+      writer.write(written.back());
+    }
+
+    std::vector<std::string> drained;
+    reader.drain(
+      [&](const ArenaRecord &record) { drained.emplace_back(record.as<std::string_view>()); });
+    EXPECT_EQ(written, drained);
+  }
+}
+
+TEST(ArenaChannelTest, ConcurrentWritersAndReader) {
+  constexpr int NUM_THREADS     = 4;
+  constexpr int MSGS_PER_THREAD = 10'000;
+
+  ArenaChannel channel(1, 1024);
+  ArenaReader  reader(channel);
+
+  std::vector<std::thread> writers;
+  for(int t = 0; t < NUM_THREADS; ++t) {
+    writers.emplace_back([&channel, t] {
+      ArenaWriter writer(channel);
+      for(int i = 0; i < MSGS_PER_THREAD; ++i) {
+        if(i % 2 == 0) {
+          writer.write(Position{.entity = t, .x = 0, .y = 0});
+        }
+        else {
+          writer.write(std::string(static_cast<std::size_t>(i % 50), 'x'));
+        }
+      }
+    });
+  }
+
+  int  count   = 0;
+  auto drainFn = [&](const ArenaRecord &record) {
+    EXPECT_TRUE(record.is<Position>() || record.is<std::string_view>());
+    ++count;
+  };
+  while(count < NUM_THREADS * MSGS_PER_THREAD) {
+    reader.drain(drainFn);
+  }
+
+  for(auto &writer : writers) {
+    writer.join();
+  }
+  EXPECT_EQ(NUM_THREADS * MSGS_PER_THREAD, count);
+}
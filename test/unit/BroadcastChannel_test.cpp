@@ -0,0 +1,152 @@
+#include "mgfw/BroadcastChannel.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using mgfw::BroadcastChannel;
+using mgfw::BroadcastReader;
+using mgfw::BroadcastWriter;
+
+TEST(BroadcastChannelTest, EveryReaderSeesEveryMessage) {
+  BroadcastChannel<std::string> channel(1);
+  BroadcastWriter<std::string>  writer(channel);
+  BroadcastReader<std::string>  reader1(channel);
+  BroadcastReader<std::string>  reader2(channel);
+
+  writer.write("One");
+  writer.emplace("Two");
+
+  std::vector<std::string> drained1;
+  std::vector<std::string> drained2;
+  reader1.drain([&](const std::string &msg) { drained1.emplace_back(msg); });
+  reader2.drain([&](const std::string &msg) { drained2.emplace_back(msg); });
+
+  EXPECT_EQ(drained1, (std::vector<std::string>{"One", "Two"}));
+  EXPECT_EQ(drained2, drained1);
+
+  // Already consumed by both readers
+  reader1.drain([]([[maybe_unused]] const std::string &msg) { FAIL(); });
+}
+
+TEST(BroadcastChannelTest, LateSubscriberOnlySeesNewMessages) {
+  BroadcastChannel<int> channel(1);
+  BroadcastWriter<int>  writer(channel);
+
+  writer.write(1);
+
+  BroadcastReader<int> reader(channel);
+  writer.write(2);
+
+  std::vector<int> drained;
+  reader.drain([&](const int &msg) { drained.push_back(msg); });
+  EXPECT_EQ(drained, (std::vector<int>{2}));
+}
+
+TEST(BroadcastChannelTest, WriterWithoutSubscribersOverwritesRing) {
+  BroadcastChannel<int> channel(1, 4);
+  BroadcastWriter<int>  writer(channel);
+
+  // Would block forever if the ring were gated
+  for(int i = 0; i < 100; ++i) {
+    writer.write(i);
+  }
+}
+
+TEST(BroadcastChannelTest, ConcurrentWritersWithoutSubscribers) {
+  // Tiny ring and non-trivial messages, so that writers a lap apart keep landing on the same slot
+  BroadcastChannel<std::string> channel(1, 2);
+
+  const std::size_t NUM_WRITERS     = 4;
+  const std::size_t MSGS_PER_WRITER = 20'000;
+
+  {
+    std::vector<std::jthread> threads;
+    for(std::size_t w = 0; w < NUM_WRITERS; ++w) {
+      threads.emplace_back([&, w] {
+        BroadcastWriter<std::string> writer(channel);
+        for(std::size_t i = 0; i < MSGS_PER_WRITER; ++i) {
+          writer.write(std::string(64, static_cast<char>('a' + w)));
+        }
+      });
+    }
+  }
+
+  // The ring is still usable afterwards
+  BroadcastReader<std::string> reader(channel);
+  BroadcastWriter<std::string> writer(channel);
+  writer.write("last");
+
+  std::vector<std::string> drained;
+  reader.drain([&](const std::string &msg) { drained.push_back(msg); });
+  EXPECT_EQ(drained, (std::vector<std::string>{"last"}));
+}
+
+TEST(BroadcastChannelTest, RejectsTooManySubscribers) {
+  BroadcastChannel<int> channel(1);
+
+  std::vector<BroadcastReader<int>> readers;
+  for(std::size_t i = 0; i < BroadcastChannel<int>::MAX_SUBSCRIBERS; ++i) {
+    readers.emplace_back(channel);
+  }
+  EXPECT_THROW({ BroadcastReader<int> reader(channel); }, std::runtime_error);
+
+  // Unsubscribing frees up a spot
+  readers.pop_back();
+  EXPECT_NO_THROW({ BroadcastReader<int> reader(channel); });
+}
+
+TEST(BroadcastChannelTest, SlowReadersGateWriters) {
+  // Much smaller than the message count, so the writers will have to wait on the readers
+  BroadcastChannel<std::size_t> channel(1, 8);
+
+  const std::size_t NUM_READERS     = 3;
+  const std::size_t NUM_WRITERS     = 2;
+  const std::size_t MSGS_PER_WRITER = 5000;
+  const std::size_t TOTAL_MSGS      = NUM_WRITERS * MSGS_PER_WRITER;
+
+  std::vector<BroadcastReader<std::size_t>> readers;
+  for(std::size_t r = 0; r < NUM_READERS; ++r) {
+    readers.emplace_back(channel);
+  }
+
+  std::vector<std::vector<std::size_t>> received(NUM_READERS);
+  {
+    std::vector<std::jthread> threads;
+    for(std::size_t r = 0; r < NUM_READERS; ++r) {
+      threads.emplace_back([&, r] {
+        while(received[r].size() < TOTAL_MSGS) {
+          readers[r].drain([&](const std::size_t &msg) { received[r].push_back(msg); });
+        }
+      });
+    }
+    for(std::size_t w = 0; w < NUM_WRITERS; ++w) {
+      threads.emplace_back([&, w] {
+        BroadcastWriter<std::size_t> writer(channel);
+        for(std::size_t i = 0; i < MSGS_PER_WRITER; ++i) {
+          writer.write((w * MSGS_PER_WRITER) + i);
+        }
+      });
+    }
+  }
+
+  for(const auto &msgs : received) {
+    ASSERT_EQ(TOTAL_MSGS, msgs.size());
+    // All readers see the same interleaving, and each writer's messages in order
+    EXPECT_EQ(received[0], msgs);
+
+    std::vector<std::size_t> nextExpected(NUM_WRITERS);
+    for(std::size_t w = 0; w < NUM_WRITERS; ++w) {
+      nextExpected[w] = w * MSGS_PER_WRITER;
+    }
+    for(const auto msg : msgs) {
+      auto &expected = nextExpected[msg / MSGS_PER_WRITER];
+      ASSERT_EQ(expected, msg);
+      ++expected;
+    }
+  }
+}
@@ -0,0 +1,385 @@
+#include "mgfw/Capture.hpp"
+
+#include "mgfw/Clock.hpp"
+#include "mgfw/EventReader.hpp"
+#include "mgfw/EventWriter.hpp"
+#include "mgfw/MQHive.hpp"
+#include "mgfw/Scheduler.hpp"
+#include "mgfw/types.hpp"
+#include "mgfw_test/ClockMock.hpp"
+#include "mgfw_test/LoggerMock.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+using mgfw::Clock;
+using mgfw::Duration_t;
+using mgfw::EventReader;
+using mgfw::EventWriter;
+using mgfw::MQHive;
+using mgfw::OverflowPolicy;
+using mgfw::Priority;
+using mgfw::Recorder;
+using mgfw::Replayer;
+using mgfw::ReplayTiming;
+using mgfw::Scheduler;
+using mgfw::TimePoint_t;
+using mgfw_test::ClockMock;
+using mgfw_test::LoggerMock;
+
+struct Tick {
+  int    seq;
+  double price;
+};
+
+struct Heartbeat {
+  int beat;
+};
+
+namespace {
+
+constexpr mgfw::U64 TICKS      = 1;
+constexpr mgfw::U64 HEARTBEATS = 2;
+
+/**
+ * Capture file path for a test, removed afterwards
+ */
+class TempFile {
+public:
+  TempFile()
+    : path_(std::filesystem::temp_directory_path()
+            / ("mgfw_capture_"
+               + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()))) {
+    std::filesystem::remove(path_);
+  }
+
+  TempFile(const TempFile &)            = delete;
+  TempFile &operator=(const TempFile &) = delete;
+  TempFile(TempFile &&)                 = delete;
+  TempFile &operator=(TempFile &&)      = delete;
+
+  ~TempFile() { std::filesystem::remove(path_); }
+
+  const std::filesystem::path &path() const { return path_; }
+
+private:
+  std::filesystem::path path_;
+};
+
+/**
+ * Records ticks 0 (high priority), 1 and 2 at 0ms, 20ms and 40ms, plus a heartbeat at 30ms
+ */
+void record_ticks(const std::filesystem::path &path) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+  ClockMock  clk(TimePoint_t(1s));
+
+  EventWriter<Tick>      ticks      = hive.get_writer<Tick>(TICKS, {.lanes = 3});
+  EventWriter<Heartbeat> heartbeats = hive.get_writer<Heartbeat>(HEARTBEATS);
+
+  Recorder recorder(hive, clk, path);
+  recorder.record<Tick>(TICKS);
+  recorder.record<Heartbeat>(HEARTBEATS);
+
+  ticks.write({0, 1.5}, Priority::High);
+  clk.set_now(TimePoint_t(1s + 20ms));
+  ticks.write({1, 2.5});
+  clk.set_now(TimePoint_t(1s + 30ms));
+  heartbeats.write({7});
+  clk.set_now(TimePoint_t(1s + 40ms));
+  ticks.write({2, 3.5});
+
+  EXPECT_EQ(4, recorder.recorded());
+
+  // Nothing else reads them
+  hive.get_reader<Tick>(TICKS).drain([](const Tick &) { });
+  hive.get_reader<Heartbeat>(HEARTBEATS).drain([](const Heartbeat &) { });
+}
+
+/**
+ * Replays TICKS from `path` into a fresh hive on a real clock, returning how long after the replay
+ * started each tick arrived
+ */
+std::vector<Duration_t> replay_ticks(const std::filesystem::path &path,
+                                     const ReplayTiming           timing,
+                                     const double                 speed = 1.0) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+  Clock      clk;
+  Scheduler  sched(clk, logger);
+
+  std::vector<Tick>       ticks;
+  std::vector<Duration_t> arrivals;
+  const TimePoint_t       start = clk.now();
+  hive.set_tap<Tick>(TICKS, [&](const Tick &tick, Priority) {
+    ticks.push_back(tick);
+    arrivals.push_back(clk.now() - start);
+  });
+
+  Replayer replayer(hive, path);
+  replayer.route<Tick>(TICKS);
+  replayer.start(
+    sched, clk, {.timing = timing, .speed = speed, .onFinished = [&] { sched.request_stop(); }});
+  sched.run();
+
+  EXPECT_TRUE(replayer.finished());
+  EXPECT_EQ(3, replayer.stats().replayed);
+  EXPECT_EQ(1, replayer.stats().skipped);
+
+  EXPECT_EQ(3, ticks.size());
+  for(std::size_t i = 0; i < ticks.size(); ++i) {
+    EXPECT_EQ(static_cast<int>(i), ticks[i].seq);
+    EXPECT_DOUBLE_EQ(1.5 + static_cast<double>(i), ticks[i].price);
+  }
+  hive.get_reader<Tick>(TICKS).drain([](const Tick &) { });
+
+  return arrivals;
+}
+
+}  // namespace
+
+TEST(CaptureTest, ReplayReinjectsRecordedMessages) {
+  const TempFile file;
+  record_ticks(file.path());
+
+  LoggerMock logger;
+  MQHive     hive(logger);
+  ClockMock  clk(TimePoint_t(0ms));
+  Scheduler  sched(clk, logger);
+
+  EventReader<Tick>      tickReader      = hive.get_reader<Tick>(TICKS, {.lanes = 3});
+  EventReader<Heartbeat> heartbeatReader = hive.get_reader<Heartbeat>(HEARTBEATS);
+
+  std::vector<Priority> priorities;
+  hive.set_tap<Tick>(
+    TICKS, [&](const Tick &, const Priority priority) { priorities.push_back(priority); });
+
+  Replayer replayer(hive, file.path());
+  replayer.route<Tick>(TICKS);
+  replayer.route<Heartbeat>(HEARTBEATS);
+  replayer.start(sched,
+                 clk,
+                 {.timing = ReplayTiming::AsFastAsPossible, .onFinished = [&] {
+                    sched.request_stop();
+                  }});
+  sched.run();
+
+  std::vector<int> seqs;
+  tickReader.drain([&](const Tick &tick) { seqs.push_back(tick.seq); });
+  EXPECT_EQ((std::vector<int>{0, 1, 2}), seqs);
+  EXPECT_EQ((std::vector<Priority>{Priority::High, Priority::Normal, Priority::Normal}),
+            priorities);
+
+  std::vector<int> beats;
+  heartbeatReader.drain([&](const Heartbeat &hb) { beats.push_back(hb.beat); });
+  EXPECT_EQ((std::vector<int>{7}), beats);
+
+  EXPECT_EQ(4, replayer.stats().replayed);
+  EXPECT_EQ(0, replayer.stats().skipped);
+}
+
+TEST(CaptureTest, RecordsWritePrioritiesOnSingleLaneChannels) {
+  const TempFile file;
+  {
+    LoggerMock        logger;
+    MQHive            hive(logger);
+    ClockMock         clk(TimePoint_t(0ms));
+    EventWriter<Tick> ticks   = hive.get_writer<Tick>(TICKS);
+    EventReader<Tick> drainer = hive.get_reader<Tick>(TICKS);
+
+    // All three go to the only lane, but the recording keeps what each was written with
+    Recorder recorder(hive, clk, file.path());
+    recorder.record<Tick>(TICKS);
+    ticks.write({0, 1.0}, Priority::Low);
+    ticks.write({1, 2.0}, Priority::High);
+    ticks.write({2, 3.0});
+    drainer.drain([](const Tick &) { });
+  }
+
+  LoggerMock logger;
+  MQHive     hive(logger);
+  ClockMock  clk(TimePoint_t(0ms));
+  Scheduler  sched(clk, logger);
+
+  EventReader<Tick>     tickReader = hive.get_reader<Tick>(TICKS, {.lanes = 3});
+  std::vector<Priority> priorities;
+  hive.set_tap<Tick>(
+    TICKS, [&](const Tick &, const Priority priority) { priorities.push_back(priority); });
+
+  Replayer replayer(hive, file.path());
+  replayer.route<Tick>(TICKS);
+  replayer.start(sched,
+                 clk,
+                 {.timing = ReplayTiming::AsFastAsPossible, .onFinished = [&] {
+                    sched.request_stop();
+                  }});
+  sched.run();
+
+  EXPECT_EQ((std::vector<Priority>{Priority::Low, Priority::High, Priority::Normal}), priorities);
+
+  // ...so replaying into a queue with more lanes sorts them out again
+  std::vector<int> seqs;
+  tickReader.drain([&](const Tick &tick) { seqs.push_back(tick.seq); });
+  EXPECT_EQ((std::vector<int>{1, 2, 0}), seqs);
+}
+
+TEST(CaptureTest, ReplayKeepsOriginalTiming) {
+  const TempFile file;
+  record_ticks(file.path());
+
+  const auto arrivals = replay_ticks(file.path(), ReplayTiming::Original);
+  ASSERT_EQ(3, arrivals.size());
+  EXPECT_GE(arrivals[1], 20ms);
+  EXPECT_GE(arrivals[2], 40ms);
+}
+
+TEST(CaptureTest, ReplayCanBeScaled) {
+  const TempFile file;
+  record_ticks(file.path());
+
+  const auto arrivals = replay_ticks(file.path(), ReplayTiming::Scaled, 2.0);
+  ASSERT_EQ(3, arrivals.size());
+  EXPECT_GE(arrivals[1], 10ms);
+  EXPECT_GE(arrivals[2], 20ms);
+}
+
+TEST(CaptureTest, ReplaySkipsMismatchedTypes) {
+  const TempFile file;
+  record_ticks(file.path());
+
+  LoggerMock logger;
+  MQHive     hive(logger);
+  ClockMock  clk(TimePoint_t(0ms));
+  Scheduler  sched(clk, logger);
+
+  Replayer replayer(hive, file.path());
+  replayer.route<Heartbeat>(TICKS);
+  replayer.start(sched,
+                 clk,
+                 {.timing = ReplayTiming::AsFastAsPossible, .onFinished = [&] {
+                    sched.request_stop();
+                  }});
+  sched.run();
+
+  EXPECT_EQ(0, replayer.stats().replayed);
+  EXPECT_EQ(4, replayer.stats().skipped);
+}
+
+TEST(CaptureTest, ReplayCountsRefusedMessagesAsSkipped) {
+  const TempFile file;
+  record_ticks(file.path());
+
+  LoggerMock logger;
+  MQHive     hive(logger);
+  ClockMock  clk(TimePoint_t(0ms));
+  Scheduler  sched(clk, logger);
+
+  // Nothing drains the queue, so only the first tick fits
+  EventReader<Tick> tickReader =
+    hive.get_reader<Tick>(TICKS, {.capacity = 1, .overflow = OverflowPolicy::Fail});
+
+  Replayer replayer(hive, file.path());
+  replayer.route<Tick>(TICKS);
+  replayer.start(sched,
+                 clk,
+                 {.timing = ReplayTiming::AsFastAsPossible, .onFinished = [&] {
+                    sched.request_stop();
+                  }});
+  sched.run();
+
+  EXPECT_EQ(1, replayer.stats().replayed);
+  EXPECT_EQ(3, replayer.stats().skipped);
+  tickReader.drain([](const Tick &) { });
+}
+
+TEST(CaptureTest, RecordsConcurrentProducers) {
+  const TempFile file;
+  const int      NUM_THREADS = 4;
+  const int      NUM_TICKS   = 2000;
+
+  {
+    LoggerMock logger;
+    MQHive     hive(logger);
+    Clock      clk;
+
+    EventReader<Tick> tickReader = hive.get_reader<Tick>(TICKS);
+    Recorder          recorder(hive, clk, file.path());
+    recorder.record<Tick>(TICKS);
+
+    {
+      std::vector<std::jthread> producers;
+      for(int t = 0; t < NUM_THREADS; ++t) {
+        producers.emplace_back([&, t] {
+          EventWriter<Tick> writer = hive.get_writer<Tick>(TICKS);
+          for(int i = 0; i < NUM_TICKS; ++i) {
+            writer.write({i, static_cast<double>(t)});
+          }
+        });
+      }
+    }
+
+    EXPECT_EQ(NUM_THREADS * NUM_TICKS, recorder.recorded());
+    tickReader.drain([](const Tick &) { });
+  }
+
+  LoggerMock logger;
+  MQHive     hive(logger);
+  ClockMock  clk(TimePoint_t(0ms));
+  Scheduler  sched(clk, logger);
+
+  // Each producer's ticks come back in the order it wrote them
+  std::vector<int> nextSeq(NUM_THREADS, 0);
+  hive.set_tap<Tick>(TICKS, [&](const Tick &tick, Priority) {
+    auto &expected = nextSeq[static_cast<std::size_t>(tick.price)];
+    EXPECT_EQ(expected, tick.seq);
+    expected = tick.seq + 1;
+  });
+  EventReader<Tick> tickReader = hive.get_reader<Tick>(TICKS);
+
+  Replayer replayer(hive, file.path());
+  replayer.route<Tick>(TICKS);
+  replayer.start(sched,
+                 clk,
+                 {.timing = ReplayTiming::AsFastAsPossible, .onFinished = [&] {
+                    sched.request_stop();
+                  }});
+  sched.run();
+
+  EXPECT_EQ(NUM_THREADS * NUM_TICKS, replayer.stats().replayed);
+  EXPECT_EQ((std::vector<int>(NUM_THREADS, NUM_TICKS)), nextSeq);
+  tickReader.drain([](const Tick &) { });
+}
+
+TEST(CaptureTest, ReplayerRejectsOtherFiles) {
+  const TempFile file;
+  std::ofstream(file.path()) << "definitely not a capture";
+
+  LoggerMock logger;
+  MQHive     hive(logger);
+  EXPECT_THROW(Replayer(hive, file.path()), std::runtime_error);
+}
+
+TEST(CaptureTest, ReplayerRejectsNonPositiveSpeed) {
+  const TempFile file;
+  record_ticks(file.path());
+
+  LoggerMock logger;
+  MQHive     hive(logger);
+  ClockMock  clk(TimePoint_t(0ms));
+  Scheduler  sched(clk, logger);
+
+  Replayer replayer(hive, file.path());
+  EXPECT_THROW(
+    replayer.start(sched, clk, {.timing = ReplayTiming::Scaled, .speed = 0.0, .onFinished = {}}),
+    std::invalid_argument);
+}
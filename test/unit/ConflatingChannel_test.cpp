@@ -0,0 +1,134 @@
+#include "mgfw/ConflatingChannel.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using mgfw::ConflatingChannel;
+using mgfw::ConflatingReader;
+using mgfw::ConflatingWriter;
+
+struct Quote {
+  std::string symbol;
+  int         price = 0;
+};
+
+struct QuoteSymbol {
+  const std::string &operator()(const Quote &quote) const { return quote.symbol; }
+};
+
+using QuoteChannel_t = ConflatingChannel<Quote, QuoteSymbol>;
+
+TEST(ConflatingChannelTest, DrainYieldsLatestValuePerKeyInFirstUpdateOrder) {
+  QuoteChannel_t                       channel;
+  ConflatingWriter<Quote, QuoteSymbol> writer(channel);
+  ConflatingReader<Quote, QuoteSymbol> reader(channel);
+
+  writer.write({"B", 1});
+  writer.write({"A", 1});
+  writer.emplace("B", 2);
+  writer.write({"C", 1});
+  writer.write({"A", 3});
+  EXPECT_EQ(3, channel.pending_keys());
+
+  std::vector<std::pair<std::string, int>> drained;
+  reader.drain([&](const Quote &quote) { drained.emplace_back(quote.symbol, quote.price); });
+
+  EXPECT_EQ(drained, (std::vector<std::pair<std::string, int>>{{"B", 2}, {"A", 3}, {"C", 1}}));
+  EXPECT_EQ(0, channel.pending_keys());
+
+  // Each key is only yielded again once it is updated again
+  writer.write({"C", 2});
+  drained.clear();
+  reader.drain([&](const Quote &quote) { drained.emplace_back(quote.symbol, quote.price); });
+  EXPECT_EQ(drained, (std::vector<std::pair<std::string, int>>{{"C", 2}}));
+}
+
+TEST(ConflatingChannelTest, KeysKeepTheirSlotsAcrossDrains) {
+  QuoteChannel_t                       channel;
+  ConflatingWriter<Quote, QuoteSymbol> writer(channel);
+  ConflatingReader<Quote, QuoteSymbol> reader(channel);
+
+  std::vector<std::pair<std::string, int>> drained;
+  const auto drain = [&] {
+    drained.clear();
+    reader.drain([&](const Quote &quote) { drained.emplace_back(quote.symbol, quote.price); });
+  };
+
+  // Drains alternate between two sets of buffers, and keys seen by one have to show up in the other
+  writer.write({"A", 1});
+  drain();
+  writer.write({"B", 1});
+  writer.write({"C", 1});
+  drain();
+  EXPECT_EQ(drained, (std::vector<std::pair<std::string, int>>{{"B", 1}, {"C", 1}}));
+
+  // The order is that of the first update since the last drain, not of the key's first appearance
+  writer.write({"C", 2});
+  writer.write({"A", 2});
+  writer.write({"B", 2});
+  writer.write({"C", 3});
+  drain();
+  EXPECT_EQ(drained, (std::vector<std::pair<std::string, int>>{{"C", 3}, {"A", 2}, {"B", 2}}));
+
+  drain();
+  EXPECT_TRUE(drained.empty());
+  EXPECT_EQ(0, channel.pending_keys());
+}
+
+TEST(ConflatingChannelTest, CallbackMayWriteToTheChannel) {
+  QuoteChannel_t                       channel;
+  ConflatingWriter<Quote, QuoteSymbol> writer(channel);
+  ConflatingReader<Quote, QuoteSymbol> reader(channel);
+
+  writer.write({"A", 1});
+
+  // Writes made during a drain are held over for the next one
+  int invocations = 0;
+  reader.drain([&](const Quote &quote) {
+    ++invocations;
+    writer.write({quote.symbol, quote.price + 1});
+  });
+  EXPECT_EQ(1, invocations);
+
+  int price = 0;
+  reader.drain([&](const Quote &quote) { price = quote.price; });
+  EXPECT_EQ(2, price);
+}
+
+TEST(ConflatingChannelTest, ReaderAlwaysEndsUpWithTheLatestValues) {
+  constexpr int NUM_UPDATES = 100'000;
+
+  QuoteChannel_t                       channel;
+  ConflatingReader<Quote, QuoteSymbol> reader(channel);
+
+  std::thread producer([&] {
+    ConflatingWriter<Quote, QuoteSymbol> writer(channel);
+    for(int i = 1; i <= NUM_UPDATES; ++i) {
+      writer.write({i % 2 == 0 ? "even" : "odd", i});
+    }
+  });
+
+  int  lastEven    = 0;
+  int  lastOdd     = 0;
+  auto drainPrices = [&] {
+    reader.drain([&](const Quote &quote) {
+      int &last = quote.symbol == "even" ? lastEven : lastOdd;
+      // Conflation may skip updates, but never reorders them
+      EXPECT_GT(quote.price, last);
+      last = quote.price;
+    });
+  };
+
+  while(lastEven < NUM_UPDATES) {
+    drainPrices();
+  }
+  producer.join();
+  drainPrices();
+
+  EXPECT_EQ(NUM_UPDATES, lastEven);
+  EXPECT_EQ(NUM_UPDATES - 1, lastOdd);
+}
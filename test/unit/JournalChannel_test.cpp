@@ -0,0 +1,180 @@
+#include "mgfw/JournalChannel.hpp"
+
+#include "mgfw_test/LoggerMock.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using mgfw::JournalChannel;
+using mgfw::JournalConfig;
+using mgfw::JournalReader;
+using mgfw::JournalWriter;
+using mgfw_test::LoggerMock;
+using ::testing::_;
+
+struct Fill {
+  int    orderId;
+  double price;
+};
+
+namespace {
+
+/**
+ * Fresh directory for a test's segment files, removed afterwards
+ */
+class TempDir {
+public:
+  TempDir()
+    : path_(std::filesystem::temp_directory_path()
+            / ("mgfw_journal_"
+               + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()))) {
+    std::filesystem::remove_all(path_);
+  }
+
+  TempDir(const TempDir &)            = delete;
+  TempDir &operator=(const TempDir &) = delete;
+  TempDir(TempDir &&)                 = delete;
+  TempDir &operator=(TempDir &&)      = delete;
+
+  ~TempDir() { std::filesystem::remove_all(path_); }
+
+  const std::filesystem::path &path() const { return path_; }
+
+  std::size_t file_count() const {
+    std::size_t count = 0;
+    for([[maybe_unused]] const auto &entry : std::filesystem::directory_iterator(path_)) {
+      ++count;
+    }
+    return count;
+  }
+
+private:
+  std::filesystem::path path_;
+};
+
+}  // namespace
+
+TEST(JournalChannelTest, MessagesRollOverSegmentsAndConsumedSegmentsAreDeleted) {
+  LoggerMock logger;
+  TempDir    dir;
+
+  JournalChannel<Fill> channel(logger, 1, {.directory = dir.path(), .segmentCapacity = 4});
+  JournalWriter<Fill>  writer(channel);
+  JournalReader<Fill>  reader(channel);
+
+  for(int i = 0; i < 10; ++i) {
+    writer.write({.orderId = i, .price = i * 0.5});
+  }
+  EXPECT_EQ(3, dir.file_count());
+
+  std::vector<int> ids;
+  reader.drain([&](const Fill &fill) {
+    ids.push_back(fill.orderId);
+    EXPECT_DOUBLE_EQ(fill.orderId * 0.5, fill.price);
+  });
+  EXPECT_EQ(ids, (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+  // Only the segment still being written to is left
+  EXPECT_EQ(1, dir.file_count());
+
+  ids.clear();
+  reader.drain([&](const Fill &fill) { ids.push_back(fill.orderId); });
+  EXPECT_TRUE(ids.empty());
+}
+
+TEST(JournalChannelTest, UnpublishedSegmentsAreRemovedOnStartup) {
+  LoggerMock logger;
+  TempDir    dir;
+  std::filesystem::create_directories(dir.path());
+
+  // As if a crash interrupted rolling over to segment 1, next to another channel's leftover
+  std::ofstream(dir.path() / "1.0000000001.journal.tmp") << "half set up";
+  std::ofstream(dir.path() / "2.0000000001.journal.tmp") << "not ours";
+
+  EXPECT_CALL(logger, info(::testing::HasSubstr("removing unpublished segment")));
+  {
+    JournalChannel<Fill> channel(logger, 1, {.directory = dir.path(), .segmentCapacity = 4});
+  }
+
+  EXPECT_FALSE(std::filesystem::exists(dir.path() / "1.0000000001.journal.tmp"));
+  EXPECT_TRUE(std::filesystem::exists(dir.path() / "2.0000000001.journal.tmp"));
+  EXPECT_TRUE(std::filesystem::exists(dir.path() / "1.0000000000.journal"));
+}
+
+TEST(JournalChannelTest, ReopenedChannelResumesFromLastCommittedMessage) {
+  LoggerMock logger;
+  TempDir    dir;
+
+  const JournalConfig config{.directory = dir.path(), .segmentCapacity = 4, .syncEvery = 3};
+
+  {
+    JournalChannel<Fill> channel(logger, 1, config);
+    for(int i = 0; i < 6; ++i) {
+      channel.publish({.orderId = i, .price = 0.0});
+    }
+
+    // The callback dies on message 3, so it was never committed
+    EXPECT_THROW(channel.drain([](const Fill &fill) {
+      if(fill.orderId == 3) {
+        throw std::runtime_error("crash");
+      }
+    }),
+                 std::runtime_error);
+  }
+
+  EXPECT_CALL(logger, info(_));
+  JournalChannel<Fill> channel(logger, 1, config);
+  channel.publish({.orderId = 6, .price = 0.0});
+
+  std::vector<int> ids;
+  channel.drain([&](const Fill &fill) { ids.push_back(fill.orderId); });
+  EXPECT_EQ(ids, (std::vector<int>{3, 4, 5, 6}));
+}
+
+TEST(JournalChannelTest, ReopeningWithDifferentTypeThrows) {
+  LoggerMock logger;
+  TempDir    dir;
+
+  JournalChannel<Fill>(logger, 1, {.directory = dir.path()});
+
+  EXPECT_THROW(JournalChannel<int>(logger, 1, {.directory = dir.path()}), std::runtime_error);
+
+  // Channels with other IDs have their own segments
+  EXPECT_NO_THROW(JournalChannel<int>(logger, 2, {.directory = dir.path()}));
+}
+
+TEST(JournalChannelTest, ConcurrentWriterAndReader) {
+  constexpr int NUM_MSGS = 20'000;
+
+  LoggerMock logger;
+  TempDir    dir;
+
+  JournalChannel<Fill> channel(logger, 1, {.directory = dir.path(), .segmentCapacity = 256});
+
+  std::thread producer([&] {
+    JournalWriter<Fill> writer(channel);
+    for(int i = 0; i < NUM_MSGS; ++i) {
+      writer.write({.orderId = i, .price = 0.0});
+    }
+  });
+
+  JournalReader<Fill> reader(channel);
+  int                 expected = 0;
+  while(expected < NUM_MSGS) {
+    reader.drain([&](const Fill &fill) {
+      EXPECT_EQ(expected, fill.orderId);
+      ++expected;
+    });
+  }
+
+  producer.join();
+  EXPECT_EQ(1, dir.file_count());
+}
@@ -0,0 +1,150 @@
+#include "mgfw/MPSCQueue.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using mgfw::MPSCQueue;
+
+TEST(MPSCQueueTest, PreservesOrder) {
+  MPSCQueue<int> queue;
+
+  const int NUM_MSGS = 10;
+  for(int i = 0; i < NUM_MSGS; ++i) {
+    queue.enqueue(i);
+  }
+  EXPECT_EQ(NUM_MSGS, queue.size_approx());
+
+  int msg = -1;
+  for(int i = 0; i < NUM_MSGS; ++i) {
+    ASSERT_TRUE(queue.try_dequeue(msg));
+    EXPECT_EQ(i, msg);
+  }
+  EXPECT_FALSE(queue.try_dequeue(msg));
+  EXPECT_EQ(0, queue.size_approx());
+}
+
+TEST(MPSCQueueTest, BulkEnqueueAndDequeue) {
+  MPSCQueue<std::string> queue;
+
+  const std::vector<std::string> msgs{"a", "b", "c"};
+  queue.enqueue_bulk(msgs.begin(), msgs.size());
+  queue.enqueue("d");
+
+  std::array<std::string, 3> out;
+  EXPECT_EQ(3, queue.try_dequeue_bulk(out.begin(), out.size()));
+  EXPECT_EQ("a", out[0]);
+  EXPECT_EQ("c", out[2]);
+
+  EXPECT_EQ(1, queue.try_dequeue_bulk(out.begin(), out.size()));
+  EXPECT_EQ("d", out[0]);
+}
+
+TEST(MPSCQueueTest, ReserveAndPeekWorkInPlace) {
+  MPSCQueue<std::string> queue;
+
+  auto reservation    = queue.reserve();
+  reservation.value() = "built in place";
+  auto abandoned      = queue.reserve();
+  abandoned.value()   = "never committed";
+  queue.commit(reservation);
+  EXPECT_EQ(1, queue.size_approx());
+
+  std::string *msg = queue.peek();
+  ASSERT_NE(nullptr, msg);
+  EXPECT_EQ("built in place", *msg);
+  queue.pop();
+  EXPECT_EQ(nullptr, queue.peek());
+}
+
+TEST(MPSCQueueTest, ReleasesUnconsumedMessagesOnDestruction) {
+  // Relies on the sanitizers to flag leaks
+  MPSCQueue<std::string> queue;
+  for(int i = 0; i < 10; ++i) {
+    queue.enqueue(std::string(64, 'x'));
+  }
+
+  std::string msg;
+  queue.try_dequeue(msg);
+}
+
+TEST(MPSCQueueTest, ManyProducersOneConsumer) {
+  MPSCQueue<std::size_t> queue;
+
+  const std::size_t NUM_THREADS     = 4;
+  const std::size_t MSGS_PER_THREAD = 10'000;
+
+  std::vector<std::jthread> producers;
+  for(std::size_t t = 0; t < NUM_THREADS; ++t) {
+    producers.emplace_back([&queue, t] {
+      for(std::size_t i = 0; i < MSGS_PER_THREAD; ++i) {
+        queue.enqueue((t * MSGS_PER_THREAD) + i);
+      }
+    });
+  }
+
+  // Each producer's messages should arrive in the order they were enqueued
+  std::vector<std::size_t> nextExpected(NUM_THREADS);
+  for(std::size_t t = 0; t < NUM_THREADS; ++t) {
+    nextExpected[t] = t * MSGS_PER_THREAD;
+  }
+
+  std::size_t received = 0;
+  std::size_t msg      = 0;
+  while(received < NUM_THREADS * MSGS_PER_THREAD) {
+    if(queue.try_dequeue(msg)) {
+      auto &expected = nextExpected[msg / MSGS_PER_THREAD];
+      ASSERT_EQ(expected, msg);
+      ++expected;
+      ++received;
+    }
+  }
+}
+
+namespace {
+
+struct ThrowsOnCopy {
+  ThrowsOnCopy() = default;
+
+  ThrowsOnCopy(const ThrowsOnCopy &other) : value(other.value) {
+    if(value < 0) {
+      throw std::runtime_error("copy");
+    }
+  }
+
+  ThrowsOnCopy(ThrowsOnCopy &&) noexcept            = default;
+  ThrowsOnCopy &operator=(const ThrowsOnCopy &)     = default;
+  ThrowsOnCopy &operator=(ThrowsOnCopy &&) noexcept = default;
+  ~ThrowsOnCopy()                                   = default;
+
+  int value = 0;
+};
+
+}  // namespace
+
+TEST(MPSCQueueTest, FailedBulkEnqueuePublishesNothing) {
+  MPSCQueue<ThrowsOnCopy> queue;
+
+  std::vector<ThrowsOnCopy> msgs(3);
+  msgs[0].value = 1;
+  msgs[1].value = 2;
+  msgs[2].value = -1;
+  EXPECT_THROW(queue.enqueue_bulk(msgs.begin(), msgs.size()), std::runtime_error);
+  EXPECT_EQ(0, queue.size_approx());
+
+  // The nodes went back to the pool, and the queue carries on as normal
+  for(int round = 0; round < 1000; ++round) {
+    queue.enqueue_bulk(msgs.begin(), 2);
+    ThrowsOnCopy msg;
+    ASSERT_TRUE(queue.try_dequeue(msg));
+    EXPECT_EQ(1, msg.value);
+    ASSERT_TRUE(queue.try_dequeue(msg));
+    EXPECT_EQ(2, msg.value);
+  }
+  EXPECT_EQ(nullptr, queue.peek());
+}
@@ -2,16 +2,31 @@
 
 #include "mgfw/EventReader.hpp"
 #include "mgfw/EventWriter.hpp"
+#include "mgfw/JournalChannel.hpp"
 #include "mgfw_test/LoggerMock.hpp"
 
 #include <gtest/gtest.h>
 
+#include <cstddef>
+#include <filesystem>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
+using mgfw::ArenaReader;
+using mgfw::ArenaRecord;
+using mgfw::ArenaWriter;
+using mgfw::BroadcastReader;
+using mgfw::BroadcastWriter;
+using mgfw::ConflatingReader;
+using mgfw::ConflatingWriter;
 using mgfw::EventReader;
 using mgfw::EventWriter;
+using mgfw::JournalReader;
+using mgfw::JournalWriter;
 using mgfw::MQHive;
+using mgfw::PartitionedWriter;
 using mgfw_test::LoggerMock;
 
 struct MyEvent {
@@ -22,6 +37,14 @@ struct AnotherEvent {
   std::string msg;
 };
 
+struct EventValue {
+  int operator()(const MyEvent &ev) const { return ev.value; }
+};
+
+struct EventParity {
+  int operator()(const MyEvent &ev) const { return ev.value % 2; }
+};
+
 TEST(MQHiveTest, GetWriterCreatesQueueAndReturnsWriter) {
   LoggerMock logger;
   MQHive     hive(logger);
@@ -49,3 +72,194 @@ TEST(MQHiveTest, ThrowsOnTypeMismatch) {
 
   EXPECT_THROW({ hive.get_writer<AnotherEvent>(MAGICNUM); }, std::runtime_error);
 }
+
+TEST(MQHiveTest, BackendIsChosenWhenChannelIsCreated) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+
+  const auto EVENT_ID = 789;
+  const auto MAGICNUM = 42;
+
+  EventWriter<MyEvent> writer =
+    hive.get_writer<MyEvent>(EVENT_ID, {.backend = mgfw::QueueBackend::SPSC});
+  writer.write({MAGICNUM});
+
+  // The queue already exists, so the config here is ignored
+  EventReader<MyEvent> reader = hive.get_reader<MyEvent>(EVENT_ID);
+
+  int i = 0;
+  reader.drain([&](const MyEvent &ev) { i = ev.value; });
+  EXPECT_EQ(MAGICNUM, i);
+
+  // SPSC channels only allow one endpoint on each end
+  EXPECT_THROW({ hive.get_writer<MyEvent>(EVENT_ID); }, std::runtime_error);
+  EXPECT_THROW({ hive.get_reader<MyEvent>(EVENT_ID); }, std::runtime_error);
+}
+
+TEST(MQHiveTest, BroadcastChannelReachesEveryReader) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+
+  const auto EVENT_ID = 1000;
+  const auto MAGICNUM = 42;
+
+  BroadcastReader<MyEvent> reader1 = hive.get_broadcast_reader<MyEvent>(EVENT_ID);
+  BroadcastReader<MyEvent> reader2 = hive.get_broadcast_reader<MyEvent>(EVENT_ID);
+  BroadcastWriter<MyEvent> writer  = hive.get_broadcast_writer<MyEvent>(EVENT_ID);
+
+  writer.write({MAGICNUM});
+
+  int sum = 0;
+  reader1.drain([&](const MyEvent &ev) { sum += ev.value; });
+  reader2.drain([&](const MyEvent &ev) { sum += ev.value; });
+  EXPECT_EQ(2 * MAGICNUM, sum);
+}
+
+TEST(MQHiveTest, ThrowsOnChannelKindMismatch) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+
+  const auto EVENT_ID = 1001;
+  hive.get_writer<MyEvent>(EVENT_ID);
+
+  EXPECT_THROW({ hive.get_broadcast_writer<MyEvent>(EVENT_ID); }, std::runtime_error);
+}
+
+TEST(MQHiveTest, ConflatingChannelKeepsLatestValuePerKey) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+
+  const auto EVENT_ID = 1002;
+
+  ConflatingWriter<MyEvent, EventParity> writer =
+    hive.get_conflating_writer<MyEvent, EventParity>(EVENT_ID);
+  ConflatingReader<MyEvent, EventParity> reader =
+    hive.get_conflating_reader<MyEvent, EventParity>(EVENT_ID);
+
+  for(int i = 0; i < 10; ++i) {
+    writer.write({i});
+  }
+
+  std::vector<int> drained;
+  reader.drain([&](const MyEvent &ev) { drained.push_back(ev.value); });
+  EXPECT_EQ(drained, (std::vector<int>{8, 9}));
+
+  // The key extractor is part of the channel type
+  EXPECT_THROW({ (hive.get_conflating_writer<MyEvent, EventValue>(EVENT_ID)); },
+               std::runtime_error);
+}
+
+TEST(MQHiveTest, PartitionedChannelRoutesByKey) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+
+  const auto EVENT_ID = 1003;
+
+  PartitionedWriter<MyEvent, EventParity> writer =
+    hive.get_partitioned_writer<MyEvent, EventParity>(EVENT_ID, {.partitions = 2});
+  for(int i = 0; i < 10; ++i) {
+    writer.write({i});
+  }
+
+  // Each parity lands in a single partition, in write order
+  for(std::size_t partition = 0; partition < 2; ++partition) {
+    EventReader<MyEvent> reader =
+      hive.get_partitioned_reader<MyEvent, EventParity>(EVENT_ID, partition);
+    std::vector<int> drained;
+    reader.drain([&](const MyEvent &ev) { drained.push_back(ev.value); });
+    ASSERT_EQ(5, drained.size());
+    for(std::size_t i = 1; i < drained.size(); ++i) {
+      EXPECT_EQ(drained[i - 1] % 2, drained[i] % 2);
+      EXPECT_LT(drained[i - 1], drained[i]);
+    }
+  }
+
+  EXPECT_THROW({ (hive.get_writer<MyEvent>(EVENT_ID)); }, std::runtime_error);
+}
+
+TEST(MQHiveTest, SnapshotListsEveryChannel) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+
+  EventWriter<MyEvent> writer = hive.get_writer<MyEvent>(2);
+  EventReader<MyEvent> reader = hive.get_reader<MyEvent>(2);
+  hive.get_broadcast_writer<AnotherEvent>(1);
+
+  writer.write({1});
+  writer.write({2});
+  reader.drain([]([[maybe_unused]] const MyEvent &ev) { });
+  writer.write({3});
+
+  const auto snapshot = hive.snapshot();
+  ASSERT_EQ(2, snapshot.size());
+
+  EXPECT_EQ(1, snapshot[0].id);
+  EXPECT_FALSE(snapshot[0].stats.has_value());
+
+  EXPECT_EQ(2, snapshot[1].id);
+  EXPECT_NE(std::string_view::npos, snapshot[1].typeString.find("MyEvent"));
+  ASSERT_TRUE(snapshot[1].stats.has_value());
+  EXPECT_EQ(3, snapshot[1].stats->enqueued);
+  EXPECT_EQ(2, snapshot[1].stats->dequeued);
+  EXPECT_EQ(1, snapshot[1].stats->depth);
+  EXPECT_EQ(2, snapshot[1].stats->highWaterMark);
+
+  reader.drain([]([[maybe_unused]] const MyEvent &ev) { });
+}
+
+TEST(MQHiveTest, ArenaChannelCarriesMixedMessages) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+
+  const auto EVENT_ID = 1003;
+  const auto MAGICNUM = 42;
+
+  ArenaWriter writer = hive.get_arena_writer(EVENT_ID);
+  ArenaReader reader = hive.get_arena_reader(EVENT_ID);
+
+  writer.write(MyEvent{MAGICNUM});
+  writer.write(std::string("hello"));
+
+  int         value = 0;
+  std::string str;
+  reader.drain([&](const ArenaRecord &record) {
+    if(record.is<MyEvent>()) {
+      value = record.as<MyEvent>().value;
+    }
+    else if(record.is<std::string_view>()) {
+      str = record.as<std::string_view>();
+    }
+  });
+  EXPECT_EQ(MAGICNUM, value);
+  EXPECT_EQ("hello", str);
+
+  EXPECT_THROW({ hive.get_writer<MyEvent>(EVENT_ID); }, std::runtime_error);
+}
+
+TEST(MQHiveTest, JournalChannelPersistsMessages) {
+  const auto EVENT_ID = 1004;
+  const auto MAGICNUM = 42;
+
+  const auto directory = std::filesystem::temp_directory_path() / "mgfw_mqhive_journal";
+  std::filesystem::remove_all(directory);
+
+  {
+    LoggerMock logger;
+    MQHive     hive(logger);
+
+    JournalWriter<MyEvent> writer =
+      hive.get_journal_writer<MyEvent>(EVENT_ID, {.directory = directory});
+    JournalReader<MyEvent> reader =
+      hive.get_journal_reader<MyEvent>(EVENT_ID, {.directory = directory});
+
+    writer.write({MAGICNUM});
+
+    int value = 0;
+    reader.drain([&](const MyEvent &ev) { value = ev.value; });
+    EXPECT_EQ(MAGICNUM, value);
+
+    EXPECT_THROW({ hive.get_writer<MyEvent>(EVENT_ID); }, std::runtime_error);
+  }
+
+  std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,120 @@
+#include "mgfw/PartitionedChannel.hpp"
+
+#include "mgfw/EventReader.hpp"
+#include "mgfw_test/LoggerMock.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using mgfw::EventReader;
+using mgfw::PartitionConfig;
+using mgfw::PartitionedChannel;
+using mgfw::PartitionedWriter;
+using mgfw_test::LoggerMock;
+
+struct Order {
+  int account = 0;
+  int seq     = 0;
+};
+
+struct OrderAccount {
+  int operator()(const Order &order) const { return order.account; }
+};
+
+using OrderChannel_t = PartitionedChannel<Order, OrderAccount>;
+
+TEST(PartitionedChannelTest, MessagesForAKeyAlwaysGoToTheSamePartition) {
+  LoggerMock     logger;
+  OrderChannel_t channel(logger, 1, {.partitions = 4});
+  ASSERT_EQ(4, channel.partitions());
+
+  PartitionedWriter<Order, OrderAccount> writer(channel);
+  for(int seq = 0; seq < 10; ++seq) {
+    for(int account = 0; account < 16; ++account) {
+      writer.write({account, seq});
+    }
+  }
+
+  for(std::size_t i = 0; i < channel.partitions(); ++i) {
+    EventReader<Order> reader(channel.partition(i));
+    std::map<int, int> nextSeq;
+    reader.drain([&](const Order &order) {
+      EXPECT_EQ(i, channel.partition_of(order));
+      EXPECT_EQ(nextSeq[order.account]++, order.seq);
+    });
+  }
+
+  const auto stats = channel.stats();
+  EXPECT_EQ(160, stats.enqueued);
+  EXPECT_EQ(160, stats.dequeued);
+  EXPECT_EQ(0, stats.depth);
+}
+
+TEST(PartitionedChannelTest, OneConsumerPerPartitionKeepsPerKeyOrder) {
+  constexpr int         NUM_ACCOUNTS = 32;
+  constexpr int         NUM_ORDERS   = 1'000;
+  constexpr std::size_t PARTITIONS   = 4;
+
+  LoggerMock     logger;
+  OrderChannel_t channel(logger, 1, {.partitions = PARTITIONS});
+
+  std::vector<int> expected(PARTITIONS, 0);
+  for(int account = 0; account < NUM_ACCOUNTS; ++account) {
+    expected[channel.partition_of({account, 0})] += NUM_ORDERS;
+  }
+
+  {
+    std::vector<std::jthread> consumers;
+    for(std::size_t i = 0; i < PARTITIONS; ++i) {
+      consumers.emplace_back([&, i] {
+        EventReader<Order> reader(channel.partition(i));
+        std::map<int, int> nextSeq;
+        int                received = 0;
+        while(received < expected[i]) {
+          reader.wait_and_drain(std::chrono::milliseconds(10), [&](const Order &order) {
+            // Orders for an account arrive in the order they were written
+            EXPECT_EQ(nextSeq[order.account]++, order.seq);
+            ++received;
+          });
+        }
+      });
+    }
+
+    PartitionedWriter<Order, OrderAccount> writer(channel);
+    for(int seq = 0; seq < NUM_ORDERS; ++seq) {
+      for(int account = 0; account < NUM_ACCOUNTS; ++account) {
+        writer.write({account, seq});
+      }
+    }
+  }
+
+  EXPECT_EQ(NUM_ACCOUNTS * NUM_ORDERS, channel.stats().dequeued);
+}
+
+TEST(PartitionedChannelTest, RejectsBadPartitionCounts) {
+  LoggerMock logger;
+  EXPECT_THROW({ OrderChannel_t channel(logger, 1, {.partitions = 0}); }, std::invalid_argument);
+
+  OrderChannel_t channel(logger, 1, {.partitions = 2});
+  EXPECT_THROW({ (channel.partition(2)); }, std::out_of_range);
+}
+
+TEST(PartitionedChannelTest, DiagnosticsNameThePartition) {
+  LoggerMock logger;
+  EXPECT_CALL(logger, warn(::testing::HasSubstr("MessageQueue 7 partition 1 destroyed")));
+  {
+    OrderChannel_t channel(logger, 7, {.partitions = 2});
+
+    PartitionedWriter<Order, OrderAccount> writer(channel);
+    writer.write({.account = 0, .seq = 0});
+    writer.write({.account = 1, .seq = 0});
+    EventReader<Order>(channel.partition(0)).drain([](const Order &) { });
+  }
+}
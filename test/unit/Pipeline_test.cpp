@@ -0,0 +1,163 @@
+#include "mgfw/Pipeline.hpp"
+
+#include "mgfw/EventReader.hpp"
+#include "mgfw/EventWriter.hpp"
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw_test/LoggerMock.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <latch>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using mgfw::EventReader;
+using mgfw::EventWriter;
+using mgfw::MessageQueue;
+using mgfw::Pipeline;
+using mgfw::QueueBackend;
+using mgfw_test::LoggerMock;
+using ::testing::HasSubstr;
+
+namespace {
+
+constexpr int MESSAGES = 1000;
+
+std::vector<int> iota_vector(const int count) {
+  std::vector<int> values(static_cast<std::size_t>(count));
+  std::iota(values.begin(), values.end(), 0);
+  return values;
+}
+
+}  // namespace
+
+TEST(PipelineTest, OrderedStagesKeepInputOrder) {
+  LoggerMock                logger;
+  MessageQueue<int>         raw(logger, 1);
+  MessageQueue<std::string> formatted(logger, 2, {.backend = QueueBackend::SPSC});
+
+  std::vector<std::string> received;
+  std::latch               done(MESSAGES);
+
+  Pipeline pipeline(logger, 4);
+  pipeline
+    .add_stage(
+      EventReader<int>(raw),
+      [](const int value) { return std::to_string(value * 2); },
+      EventWriter<std::string>(formatted),
+      {.name = "format", .parallelism = 4, .batchSize = 7})
+    .add_sink(
+      EventReader<std::string>(formatted),
+      [&](std::string &&value) {
+        received.push_back(std::move(value));
+        done.count_down();
+      },
+      {.name = "collect"});
+  pipeline.start();
+
+  EventWriter<int>(raw).write_bulk(iota_vector(MESSAGES));
+  done.wait();
+
+  ASSERT_EQ(MESSAGES, received.size());
+  for(int i = 0; i < MESSAGES; ++i) {
+    EXPECT_EQ(std::to_string(i * 2), received[static_cast<std::size_t>(i)]);
+  }
+
+  pipeline.stop();
+  const auto stats = pipeline.stats();
+  ASSERT_EQ(2, stats.size());
+  EXPECT_EQ("format", stats[0].name);
+  EXPECT_EQ(MESSAGES, stats[0].processed);
+  EXPECT_EQ(MESSAGES, stats[0].emitted);
+  EXPECT_EQ(0, stats[0].backlog);
+  EXPECT_EQ(MESSAGES, stats[1].processed);
+  EXPECT_EQ(0, stats[1].emitted);
+}
+
+TEST(PipelineTest, UnorderedStagesDeliverEverything) {
+  LoggerMock        logger;
+  MessageQueue<int> input(logger, 1);
+  MessageQueue<int> output(logger, 2, {.backend = QueueBackend::MPSC});
+
+  std::vector<int> received;
+  std::latch       done(MESSAGES);
+
+  Pipeline pipeline(logger, 4);
+  pipeline
+    .add_stage(
+      EventReader<int>(input),
+      [](const int value) { return value + 1; },
+      EventWriter<int>(output),
+      {.parallelism = 4, .batchSize = 5, .ordered = false})
+    .add_sink(EventReader<int>(output), [&](const int value) {
+      received.push_back(value);
+      done.count_down();
+    });
+
+  // Messages already queued before the start get picked up too
+  EventWriter<int> writer(input);
+  writer.write_bulk(iota_vector(MESSAGES / 2));
+  EXPECT_EQ(MESSAGES / 2, pipeline.stats()[0].backlog);
+
+  pipeline.start();
+  for(int i = MESSAGES / 2; i < MESSAGES; ++i) {
+    writer.write(i);
+  }
+  done.wait();
+
+  std::ranges::sort(received);
+  std::vector<int> expected = iota_vector(MESSAGES);
+  std::ranges::for_each(expected, [](int &value) { ++value; });
+  EXPECT_EQ(expected, received);
+}
+
+TEST(PipelineTest, ThrowingStageDropsTheRestOfItsBatch) {
+  LoggerMock        logger;
+  MessageQueue<int> input(logger, 1);
+  MessageQueue<int> output(logger, 2);
+
+  EXPECT_CALL(logger, error(HasSubstr("dropped 2 message(s): four")));
+
+  std::vector<int> received;
+  std::latch       done(5);
+
+  Pipeline pipeline(logger, 2);
+  pipeline
+    .add_stage(
+      EventReader<int>(input),
+      [](const int value) {
+        if(value == 4) {
+          throw std::runtime_error("four");
+        }
+        return value;
+      },
+      EventWriter<int>(output),
+      {.batchSize = 3})
+    .add_sink(EventReader<int>(output), [&](const int value) {
+      received.push_back(value);
+      done.count_down();
+    });
+
+  // Batches are {0, 1, 2}, {3, 4, 5} and {6}
+  EventWriter<int>(input).write_bulk(iota_vector(7));
+  pipeline.start();
+  done.wait();
+  pipeline.stop();
+
+  EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 6}), received);
+  EXPECT_EQ(2, pipeline.stats()[0].failed);
+}
+
+TEST(PipelineTest, RejectsEmptyStages) {
+  LoggerMock        logger;
+  MessageQueue<int> input(logger, 1);
+
+  Pipeline pipeline(logger, 1);
+  EXPECT_THROW(pipeline.add_sink(EventReader<int>(input), [](int) { }, {.parallelism = 0}),
+               std::invalid_argument);
+}
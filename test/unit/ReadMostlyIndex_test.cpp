@@ -0,0 +1,74 @@
+#include "mgfw/ReadMostlyIndex.hpp"
+
+#include "mgfw/types.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+using mgfw::ReadMostlyIndex;
+using mgfw::U64;
+
+TEST(ReadMostlyIndexTest, FindsInsertedKeys) {
+  ReadMostlyIndex<int> index;
+  int                  a = 1;
+  int                  b = 2;
+
+  EXPECT_EQ(nullptr, index.find(7));
+
+  index.insert(7, &a);
+  index.insert(0, &b);
+
+  EXPECT_EQ(&a, index.find(7));
+  EXPECT_EQ(&b, index.find(0));
+  EXPECT_EQ(nullptr, index.find(8));
+  EXPECT_EQ(2, index.size());
+}
+
+TEST(ReadMostlyIndexTest, KeepsEntriesWhenGrowing) {
+  ReadMostlyIndex<std::size_t> index;
+
+  constexpr std::size_t    COUNT = ReadMostlyIndex<std::size_t>::INITIAL_CAPACITY * 8;
+  std::vector<std::size_t> values(COUNT);
+  for(std::size_t i = 0; i < COUNT; ++i) {
+    values[i] = i;
+    index.insert(i * 1000, &values[i]);
+  }
+
+  for(std::size_t i = 0; i < COUNT; ++i) {
+    ASSERT_EQ(&values[i], index.find(i * 1000));
+  }
+  EXPECT_EQ(nullptr, index.find(1));
+}
+
+TEST(ReadMostlyIndexTest, LookupsRunConcurrentlyWithInserts) {
+  ReadMostlyIndex<U64> index;
+
+  constexpr U64    COUNT = 4096;
+  std::vector<U64> values(COUNT);
+  std::atomic<U64> inserted{0};
+
+  std::vector<std::jthread> readers;
+  for(int t = 0; t < 4; ++t) {
+    readers.emplace_back([&] {
+      while(inserted.load(std::memory_order::acquire) < COUNT) {
+        // Everything inserted so far must be visible, with the value that went with it
+        const U64 known = inserted.load(std::memory_order::acquire);
+        for(U64 key = 0; key < known; key += 17) {
+          const U64 *value = index.find(key);
+          ASSERT_NE(nullptr, value);
+          ASSERT_EQ(key, *value);
+        }
+      }
+    });
+  }
+
+  for(U64 key = 0; key < COUNT; ++key) {
+    values[key] = key;
+    index.insert(key, &values[key]);
+    inserted.store(key + 1, std::memory_order::release);
+  }
+}
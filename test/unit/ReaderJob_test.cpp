@@ -0,0 +1,209 @@
+#include "mgfw/ReaderJob.hpp"
+
+#include "mgfw/Clock.hpp"
+#include "mgfw/EventReader.hpp"
+#include "mgfw/EventWriter.hpp"
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/Scheduler.hpp"
+#include "mgfw_test/LoggerMock.hpp"
+#include "mgfw_test/ManualExecutor.hpp"
+
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+using mgfw::Clock;
+using mgfw::EventReader;
+using mgfw::EventWriter;
+using mgfw::MessageQueue;
+using mgfw::ReaderJob;
+using mgfw::Scheduler;
+using mgfw_test::LoggerMock;
+using mgfw_test::ManualExecutor;
+
+TEST(ReaderJobTest, WritesPostOneDrainUntilItRuns) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventWriter<int>  writer(queue);
+  ManualExecutor    executor;
+
+  std::vector<int> received;
+  ReaderJob<int>   job(
+    executor, EventReader<int>(queue), [&](const int msg) { received.push_back(msg); });
+
+  // Nothing is posted while the queue is empty
+  EXPECT_TRUE(executor.jobs.empty());
+
+  writer.write(1);
+  writer.write(2);
+  writer.write(3);
+  ASSERT_EQ(1, executor.jobs.size());
+
+  executor.run_all();
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), received);
+  EXPECT_EQ(1, job.drains());
+  EXPECT_TRUE(executor.jobs.empty());
+
+  writer.write(4);
+  ASSERT_EQ(1, executor.jobs.size());
+  executor.run_all();
+  EXPECT_EQ((std::vector<int>{1, 2, 3, 4}), received);
+  EXPECT_EQ(2, job.drains());
+}
+
+TEST(ReaderJobTest, KeepsGoingAfterACallbackThrows) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventWriter<int>  writer(queue);
+  ManualExecutor    executor;
+
+  std::vector<int> received;
+  ReaderJob<int>   job(executor, EventReader<int>(queue), [&](const int msg) {
+    if(msg == 1) {
+      throw std::runtime_error("bad message");
+    }
+    received.push_back(msg);
+  });
+
+  writer.write(1);
+  EXPECT_THROW(executor.run_all(), std::runtime_error);
+
+  writer.write(2);
+  executor.run_all();
+  EXPECT_EQ((std::vector<int>{2}), received);
+}
+
+TEST(ReaderJobTest, StoppedJobsDoNothing) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventWriter<int>  writer(queue);
+  ManualExecutor    executor;
+
+  int received = 0;
+  {
+    ReaderJob<int> job(executor, EventReader<int>(queue), [&](const int) { ++received; });
+    writer.write(1);
+  }
+
+  // The drain posted before the job went away is a no-op, and nothing else gets posted
+  executor.run_all();
+  writer.write(2);
+  EXPECT_TRUE(executor.jobs.empty());
+  EXPECT_EQ(0, received);
+  EventReader<int>(queue).drain([](const int) { });
+}
+
+TEST(ReaderJobTest, StopWaitsForARunningDrain) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventWriter<int>  writer(queue);
+  ManualExecutor    executor;
+
+  std::promise<void> entered;
+  std::atomic<bool>  finished{false};
+  ReaderJob<int>     job(executor, EventReader<int>(queue), [&](const int) {
+    entered.set_value();
+    std::this_thread::sleep_for(20ms);
+    finished.store(true);
+  });
+
+  writer.write(1);
+  std::jthread runner([&] { executor.run_all(); });
+  entered.get_future().wait();
+
+  job.stop();
+  EXPECT_TRUE(finished.load());
+}
+
+TEST(ReaderJobTest, StopFromTheCallbackDoesNotWait) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventWriter<int>  writer(queue);
+  ManualExecutor    executor;
+
+  std::optional<ReaderJob<int>> job;
+  int                           received = 0;
+  job.emplace(executor, EventReader<int>(queue), [&](const int) {
+    ++received;
+    job->stop();
+  });
+
+  writer.write_bulk({1, 2});
+  executor.run_all();
+  writer.write(3);
+  executor.run_all();
+
+  // The drain that stopped the job still finished its batch
+  EXPECT_EQ(2, received);
+  EventReader<int>(queue).drain([](const int) { });
+}
+
+TEST(ReaderJobTest, MovedJobKeepsDraining) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventWriter<int>  writer(queue);
+  ManualExecutor    executor;
+
+  std::vector<int> received;
+  ReaderJob<int>   original(
+    executor, EventReader<int>(queue), [&](const int msg) { received.push_back(msg); });
+  ReaderJob<int> moved(std::move(original));
+
+  writer.write(1);
+  executor.run_all();
+  EXPECT_EQ((std::vector<int>{1}), received);
+  EXPECT_EQ(1, moved.drains());
+
+  // The moved-from job is inert
+  // NOLINTNEXTLINE(bugprone-use-after-move,hicpp-invalid-access-moved)
+  EXPECT_EQ(0, original.drains());
+  // NOLINTNEXTLINE(bugprone-use-after-move,hicpp-invalid-access-moved)
+  original.stop();
+  writer.write(2);
+  executor.run_all();
+  EXPECT_EQ((std::vector<int>{1, 2}), received);
+}
+
+TEST(ReaderJobTest, DrainsOnTheSchedulerThread) {
+  constexpr int NUM_MESSAGES = 10'000;
+
+  LoggerMock        logger;
+  Clock             clock;
+  Scheduler         sched(clock, logger);
+  MessageQueue<int> queue(logger, 1);
+
+  std::promise<void> allReceived;
+  std::thread::id    drainThread;
+  int                expected = 0;
+  ReaderJob<int>     job(sched, EventReader<int>(queue), [&](const int msg) {
+    EXPECT_EQ(expected, msg);
+    drainThread = std::this_thread::get_id();
+    if(++expected == NUM_MESSAGES) {
+      allReceived.set_value();
+    }
+  });
+
+  std::jthread schedThread([&] { sched.run(); });
+
+  EventWriter<int> writer(queue);
+  for(int i = 0; i < NUM_MESSAGES; ++i) {
+    writer.write(i);
+  }
+
+  allReceived.get_future().wait();
+  sched.request_stop();
+  schedThread.join();
+
+  EXPECT_NE(std::this_thread::get_id(), drainThread);
+  EXPECT_LE(job.drains(), NUM_MESSAGES);
+}
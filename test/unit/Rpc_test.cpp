@@ -0,0 +1,250 @@
+#include "mgfw/Rpc.hpp"
+
+#include "mgfw/Clock.hpp"
+#include "mgfw/Coroutine.hpp"
+#include "mgfw/MQHive.hpp"
+#include "mgfw/types.hpp"
+#include "mgfw_test/ClockMock.hpp"
+#include "mgfw_test/LoggerMock.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+using mgfw::Clock;
+using mgfw::DetachedTask;
+using mgfw::MQHive;
+using mgfw::OverflowPolicy;
+using mgfw::RpcClient;
+using mgfw::RpcError;
+using mgfw::RpcServer;
+using mgfw::TimePoint_t;
+using mgfw_test::ClockMock;
+using mgfw_test::LoggerMock;
+
+namespace {
+
+constexpr mgfw::U64 REQUESTS = 1;
+constexpr mgfw::U64 REPLIES  = 2;
+
+using Client_t = RpcClient<int, std::string>;
+using Server_t = RpcServer<int, std::string>;
+
+std::string describe(const int value) { return std::to_string(value); }
+
+DetachedTask await_call(Client_t &client, const int request, std::optional<std::string> &out) {
+  auto result = co_await client.call(request);
+  if(result) {
+    out = std::move(*result);
+  }
+}
+
+}  // namespace
+
+TEST(RpcTest, ResponsesAreMatchedToTheirCalls) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+  ClockMock  clock(TimePoint_t{});
+  Client_t   client(hive, REQUESTS, REPLIES, clock);
+  Server_t   server(hive, REQUESTS);
+
+  auto first  = client.call(1);
+  auto second = client.call(2);
+  EXPECT_EQ(2, client.in_flight());
+  EXPECT_FALSE(first.ready());
+
+  EXPECT_EQ(2, server.serve(describe));
+  EXPECT_FALSE(first.ready());
+  EXPECT_EQ(2, client.poll());
+  EXPECT_EQ(0, client.in_flight());
+
+  ASSERT_TRUE(second.ready());
+  EXPECT_EQ("2", second.get().value());
+  EXPECT_EQ("1", first.get().value());
+  EXPECT_THROW({ (first.get()); }, std::logic_error);
+}
+
+TEST(RpcTest, ThrowingHandlerOnlyFailsItsOwnRequest) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+  ClockMock  clock(TimePoint_t{});
+  Client_t   client(hive, REQUESTS, REPLIES, clock, {.timeout = 10ms});
+  Server_t   server(hive, REQUESTS);
+
+  auto first  = client.call(1);
+  auto second = client.call(2);
+  auto third  = client.call(3);
+
+  const auto failOnTwo = [](const int value) {
+    if(value == 2) {
+      throw std::runtime_error("bad request");
+    }
+    return describe(value);
+  };
+
+  // The requests after the failing one are still answered
+  EXPECT_THROW(server.serve(failOnTwo), std::runtime_error);
+  EXPECT_EQ(2, client.poll());
+
+  EXPECT_EQ("1", first.get().value());
+  EXPECT_EQ("3", third.get().value());
+
+  clock.set_now(TimePoint_t{} + 10ms);
+  EXPECT_EQ(RpcError::TimedOut, second.get().error());
+}
+
+TEST(RpcTest, CallsTimeOutAndLateResponsesAreDropped) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+  ClockMock  clock(TimePoint_t{});
+  Client_t   client(hive, REQUESTS, REPLIES, clock, {.maxInFlight = 1, .timeout = 10ms});
+  Server_t   server(hive, REQUESTS);
+
+  auto late = client.call(1);
+  clock.set_now(TimePoint_t{} + 10ms);
+  EXPECT_EQ(1, client.poll());
+  EXPECT_EQ(RpcError::TimedOut, late.get().error());
+
+  // The slot is reused, but the response to the timed out call doesn't count for the new one
+  auto next = client.call(2);
+  EXPECT_EQ(2, server.serve(describe));
+  EXPECT_EQ(1, client.poll());
+  EXPECT_EQ("2", next.get().value());
+}
+
+TEST(RpcTest, GetTimesOutOnTheClientsClock) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+  ClockMock  clock(TimePoint_t{});
+  Client_t   client(hive, REQUESTS, REPLIES, clock, {.timeout = 1h});
+
+  // Nothing answers; only the injected clock moving on ends the wait
+  std::jthread ticker([&] {
+    std::this_thread::sleep_for(5ms);
+    clock.set_now(TimePoint_t{} + 1h);
+  });
+  EXPECT_EQ(RpcError::TimedOut, client.call(1).get().error());
+
+  ticker.join();
+  EXPECT_CALL(logger, warn(::testing::HasSubstr("unprocessed message")));
+}
+
+TEST(RpcTest, ServerOnlyKeepsTheMostRecentReplyWriters) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+  ClockMock  clock(TimePoint_t{});
+  Server_t   server(hive, REQUESTS, 2);
+
+  std::vector<std::unique_ptr<Client_t>> clients;
+  for(mgfw::U64 i = 0; i < 3; ++i) {
+    clients.push_back(std::make_unique<Client_t>(hive, REQUESTS, REPLIES + i, clock));
+  }
+
+  // Each round goes through every client, so the writers keep being evicted and recreated
+  for(int round = 0; round < 3; ++round) {
+    std::vector<Client_t::Future> calls;
+    for(auto &client : clients) {
+      calls.push_back(client->call(round));
+    }
+    EXPECT_EQ(3, server.serve(describe));
+    EXPECT_EQ(2, server.reply_writers());
+
+    for(std::size_t i = 0; i < clients.size(); ++i) {
+      EXPECT_EQ(1, clients[i]->poll());
+      EXPECT_EQ(describe(round), calls[i].get().value());
+    }
+  }
+
+  EXPECT_THROW({ Server_t(hive, REQUESTS, 0); }, std::invalid_argument);
+}
+
+TEST(RpcTest, InFlightCallsAreLimitedByThePool) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+  ClockMock  clock(TimePoint_t{});
+  Client_t   client(hive, REQUESTS, REPLIES, clock, {.maxInFlight = 2});
+
+  // No server picks up the requests
+  EXPECT_CALL(logger, warn(::testing::HasSubstr("unprocessed message")));
+
+  auto first = client.call(1);
+  {
+    auto second = client.call(2);
+    EXPECT_THROW({ (client.call(3)); }, std::runtime_error);
+  }
+
+  // Dropping a future gives its slot back
+  EXPECT_EQ(1, client.in_flight());
+  auto third = client.call(3);
+  EXPECT_EQ(2, client.in_flight());
+
+  EXPECT_THROW({ Client_t(hive, 3, 4, clock, {.maxInFlight = 0}); }, std::invalid_argument);
+}
+
+TEST(RpcTest, RejectedRequestsFailRightAway) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+  ClockMock  clock(TimePoint_t{});
+  EXPECT_CALL(logger, warn(::testing::HasSubstr("unprocessed message")));
+
+  hive.get_writer<mgfw::RpcRequest<int>>(
+    REQUESTS, {.capacity = 1, .overflow = OverflowPolicy::Fail});
+  Client_t client(hive, REQUESTS, REPLIES, clock);
+
+  auto accepted = client.call(1);
+  auto rejected = client.call(2);
+  EXPECT_FALSE(accepted.ready());
+  ASSERT_TRUE(rejected.ready());
+  EXPECT_EQ(RpcError::Rejected, rejected.get().error());
+}
+
+TEST(RpcTest, AwaitingCoroutineIsResumedByPoll) {
+  LoggerMock logger;
+  MQHive     hive(logger);
+  ClockMock  clock(TimePoint_t{});
+  Client_t   client(hive, REQUESTS, REPLIES, clock);
+  Server_t   server(hive, REQUESTS);
+
+  std::optional<std::string> received;
+  await_call(client, 42, received);
+  EXPECT_FALSE(received.has_value());
+
+  server.serve(describe);
+  EXPECT_FALSE(received.has_value());
+  client.poll();
+  EXPECT_EQ("42", received);
+  EXPECT_EQ(0, client.in_flight());
+}
+
+TEST(RpcTest, GetBlocksUntilTheServerResponds) {
+  constexpr int NUM_CALLS = 1'000;
+
+  LoggerMock logger;
+  MQHive     hive(logger);
+  Clock      clock;
+  Client_t   client(hive, REQUESTS, REPLIES, clock, {.timeout = 10s});
+
+  std::atomic<bool> done{false};
+  std::jthread      serverThread([&] {
+    Server_t server(hive, REQUESTS);
+    while(!done.load()) {
+      server.wait_and_serve(1ms, [](const int value) { return describe(value * 2); });
+    }
+  });
+
+  for(int i = 0; i < NUM_CALLS; ++i) {
+    EXPECT_EQ(describe(i * 2), client.call(i).get().value());
+  }
+  done.store(true);
+}
@@ -0,0 +1,96 @@
+#include "mgfw/SPSCQueue.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+using mgfw::SPSCQueue;
+
+TEST(SPSCQueueTest, PreservesOrderAcrossRingGrowth) {
+  // Start tiny so that the producer has to link in several new rings
+  SPSCQueue<int> queue(2);
+
+  const int NUM_MSGS = 100;
+  for(int i = 0; i < NUM_MSGS; ++i) {
+    queue.enqueue(i);
+  }
+  EXPECT_EQ(NUM_MSGS, queue.size_approx());
+
+  int msg = -1;
+  for(int i = 0; i < NUM_MSGS; ++i) {
+    ASSERT_TRUE(queue.try_dequeue(msg));
+    EXPECT_EQ(i, msg);
+  }
+  EXPECT_FALSE(queue.try_dequeue(msg));
+  EXPECT_EQ(0, queue.size_approx());
+}
+
+TEST(SPSCQueueTest, BulkDequeueSpansRings) {
+  SPSCQueue<std::string> queue(4);
+
+  const std::vector<std::string> msgs{"a", "b", "c", "d", "e", "f", "g"};
+  queue.enqueue_bulk(msgs.begin(), msgs.size());
+
+  std::array<std::string, 5> out;
+  EXPECT_EQ(5, queue.try_dequeue_bulk(out.begin(), out.size()));
+  EXPECT_EQ("a", out[0]);
+  EXPECT_EQ("e", out[4]);
+
+  EXPECT_EQ(2, queue.try_dequeue_bulk(out.begin(), out.size()));
+  EXPECT_EQ("f", out[0]);
+  EXPECT_EQ("g", out[1]);
+
+  EXPECT_EQ(0, queue.try_dequeue_bulk(out.begin(), out.size()));
+}
+
+TEST(SPSCQueueTest, ReserveAndPeekWorkInPlaceAcrossRings) {
+  SPSCQueue<int> queue(2);
+
+  for(int i = 0; i < 10; ++i) {
+    queue.reserve() = i;
+    queue.commit();
+  }
+  EXPECT_EQ(10, queue.size_approx());
+
+  for(int i = 0; i < 10; ++i) {
+    int *msg = queue.peek();
+    ASSERT_NE(nullptr, msg);
+    EXPECT_EQ(i, *msg);
+    queue.pop();
+  }
+  EXPECT_EQ(nullptr, queue.peek());
+  EXPECT_EQ(0, queue.size_approx());
+}
+
+TEST(SPSCQueueTest, ReleasesUnconsumedMessagesOnDestruction) {
+  // Relies on the sanitizers to flag leaks
+  SPSCQueue<std::string> queue(2);
+  for(int i = 0; i < 10; ++i) {
+    queue.enqueue(std::string(64, 'x'));
+  }
+}
+
+TEST(SPSCQueueTest, ProducerAndConsumerThreads) {
+  SPSCQueue<std::size_t> queue(16);
+
+  const std::size_t NUM_MSGS = 100'000;
+
+  std::jthread producer([&] {
+    for(std::size_t i = 0; i < NUM_MSGS; ++i) {
+      queue.enqueue(i);
+    }
+  });
+
+  std::size_t expected = 0;
+  std::size_t msg      = 0;
+  while(expected < NUM_MSGS) {
+    if(queue.try_dequeue(msg)) {
+      ASSERT_EQ(expected, msg);
+      ++expected;
+    }
+  }
+}
@@ -0,0 +1,213 @@
+#include "mgfw/SharedMQHive.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using mgfw::SharedMQHive;
+using mgfw::SharedReader;
+using mgfw::SharedWriter;
+
+struct Tick {
+  int    seq;
+  double price;
+};
+
+namespace {
+
+/**
+ * Unique segment name for the current test, removed before and after it runs
+ */
+class ScopedSegmentName {
+public:
+  ScopedSegmentName()
+    : name_("/mgfw_test_" + std::to_string(::getpid()) + "_"
+            + ::testing::UnitTest::GetInstance()->current_test_info()->name()) {
+    SharedMQHive::remove(name_);
+  }
+
+  ScopedSegmentName(const ScopedSegmentName &)            = delete;
+  ScopedSegmentName &operator=(const ScopedSegmentName &) = delete;
+  ScopedSegmentName(ScopedSegmentName &&)                 = delete;
+  ScopedSegmentName &operator=(ScopedSegmentName &&)      = delete;
+
+  ~ScopedSegmentName() { SharedMQHive::remove(name_); }
+
+  const std::string &get() const { return name_; }
+
+private:
+  std::string name_;
+};
+
+}  // namespace
+
+TEST(SharedMQHiveTest, HivesWithTheSameNameShareChannels) {
+  const ScopedSegmentName name;
+
+  // Two attachments map the segment at different addresses, as separate processes would
+  SharedMQHive creator(name.get());
+  SharedMQHive attached(name.get());
+
+  SharedWriter<Tick> writer = creator.get_writer<Tick>(1);
+  SharedReader<Tick> reader = attached.get_reader<Tick>(1);
+
+  writer.write({.seq = 1, .price = 99.5});
+  writer.write({.seq = 2, .price = 100.0});
+  EXPECT_EQ(2, reader.size_approx());
+
+  std::vector<int> seqs;
+  reader.drain([&](const Tick &tick) { seqs.push_back(tick.seq); });
+  EXPECT_EQ(seqs, (std::vector<int>{1, 2}));
+  EXPECT_EQ(0, reader.size_approx());
+}
+
+TEST(SharedMQHiveTest, FullChannelRejectsTryWrite) {
+  const ScopedSegmentName name;
+  SharedMQHive            hive(name.get());
+
+  // Rounded up to 4
+  SharedWriter<int> writer = hive.get_writer<int>(1, 3);
+  SharedReader<int> reader = hive.get_reader<int>(1);
+
+  for(int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(writer.try_write(i));
+  }
+  EXPECT_FALSE(writer.try_write(4));
+
+  int total = 0;
+  reader.drain([&](const int value) { total += value; });
+  EXPECT_EQ(6, total);
+  EXPECT_TRUE(writer.try_write(4));
+}
+
+TEST(SharedMQHiveTest, ReservedMessagesAreBuiltInPlace) {
+  const ScopedSegmentName name;
+  SharedMQHive            hive(name.get());
+
+  SharedWriter<Tick> writer = hive.get_writer<Tick>(1);
+  SharedReader<Tick> reader = hive.get_reader<Tick>(1);
+
+  Tick &tick = writer.reserve();
+  tick.seq   = 1;
+  EXPECT_EQ(&tick, &writer.reserve());
+  tick.price = 99.5;
+
+  // Nothing is visible until the commit
+  int received = 0;
+  reader.drain([&](const Tick &) { ++received; });
+  EXPECT_EQ(0, received);
+
+  writer.commit();
+  reader.drain([&](const Tick &message) {
+    ++received;
+    EXPECT_EQ(&tick, &message);
+    EXPECT_EQ(1, message.seq);
+    EXPECT_EQ(99.5, message.price);
+  });
+  EXPECT_EQ(1, received);
+}
+
+TEST(SharedMQHiveTest, TypeMismatchThrows) {
+  const ScopedSegmentName name;
+  SharedMQHive            hive(name.get());
+  SharedMQHive            other(name.get());
+
+  hive.get_writer<Tick>(1);
+  EXPECT_THROW({ other.get_reader<int>(1); }, std::runtime_error);
+  EXPECT_NO_THROW({ other.get_reader<Tick>(1); });
+}
+
+TEST(SharedMQHiveTest, ChannelTableAndHeapLimitsAreEnforced) {
+  const ScopedSegmentName name;
+  SharedMQHive            hive(name.get(), {.maxChannels = 2, .heapSize = 4096});
+
+  hive.get_writer<int>(1, 8);
+  EXPECT_THROW({ hive.get_writer<int>(2, 1024); }, std::runtime_error);
+  hive.get_writer<int>(2, 8);
+  EXPECT_THROW({ hive.get_writer<int>(3, 8); }, std::runtime_error);
+}
+
+TEST(SharedMQHiveTest, MessagesCrossProcesses) {
+  constexpr int NUM_MSGS = 10'000;
+
+  const ScopedSegmentName name;
+  SharedMQHive            hive(name.get());
+  SharedReader<Tick>      reader = hive.get_reader<Tick>(1, 64);
+
+  const pid_t child = ::fork();
+  ASSERT_GE(child, 0);
+  if(child == 0) {
+    SharedMQHive       childHive(name.get());
+    SharedWriter<Tick> writer = childHive.get_writer<Tick>(1);
+    for(int i = 0; i < NUM_MSGS; ++i) {
+      writer.write({.seq = i, .price = i * 0.25});
+    }
+    ::_exit(0);
+  }
+
+  int  expected = 0;
+  bool inOrder  = true;
+  while(expected < NUM_MSGS) {
+    reader.drain([&](const Tick &tick) {
+      inOrder = inOrder && tick.seq == expected && tick.price == expected * 0.25;
+      ++expected;
+    });
+  }
+  EXPECT_TRUE(inOrder);
+
+  int status = 0;
+  ASSERT_EQ(child, ::waitpid(child, &status, 0));
+  EXPECT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+}
+
+TEST(SharedMQHiveTest, ConcurrentWritersAndReaders) {
+  constexpr int NUM_THREADS     = 4;
+  constexpr int MSGS_PER_THREAD = 10'000;
+
+  const ScopedSegmentName name;
+  SharedMQHive            hive(name.get());
+
+  std::vector<std::thread> writers;
+  for(int t = 0; t < NUM_THREADS; ++t) {
+    writers.emplace_back([&] {
+      SharedWriter<int> writer = hive.get_writer<int>(1, 128);
+      for(int i = 1; i <= MSGS_PER_THREAD; ++i) {
+        writer.write(i);
+      }
+    });
+  }
+
+  std::atomic<long> total = 0;
+  std::atomic<int>  count = 0;
+
+  std::vector<std::thread> readers;
+  for(int t = 0; t < 2; ++t) {
+    readers.emplace_back([&] {
+      SharedReader<int> reader = hive.get_reader<int>(1, 128);
+      while(count.load() < NUM_THREADS * MSGS_PER_THREAD) {
+        reader.drain([&](const int value) {
+          total += value;
+          ++count;
+        });
+      }
+    });
+  }
+
+  for(auto &thread : writers) {
+    thread.join();
+  }
+  for(auto &thread : readers) {
+    thread.join();
+  }
+
+  EXPECT_EQ(static_cast<long>(NUM_THREADS) * MSGS_PER_THREAD * (MSGS_PER_THREAD + 1) / 2, total);
+}
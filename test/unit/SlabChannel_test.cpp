@@ -0,0 +1,127 @@
+#include "mgfw/SlabChannel.hpp"
+
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/SlabPool.hpp"
+#include "mgfw_test/LoggerMock.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using mgfw::OverflowPolicy;
+using mgfw::SlabChannel;
+using mgfw::SlabReader;
+using mgfw::SlabWriter;
+using mgfw_test::LoggerMock;
+
+namespace {
+
+struct Frame {
+  int                         seq = 0;
+  std::array<std::byte, 4096> pixels{};
+};
+
+}  // namespace
+
+TEST(SlabChannelTest, MessagesArriveInOrderAndSlotsAreReused) {
+  LoggerMock         logger;
+  SlabChannel<Frame> channel(logger, 1, {.cacheSize = 4});
+  SlabWriter<Frame>  writer(channel);
+  SlabReader<Frame>  reader(channel);
+
+  std::vector<int> seen;
+  for(int round = 0; round < 100; ++round) {
+    for(int i = 0; i < 10; ++i) {
+      writer.write_with([&](Frame &frame) {
+        frame.seq       = (round * 10) + i;
+        frame.pixels[0] = static_cast<std::byte>(i);
+      });
+    }
+    reader.drain([&](const Frame &frame) {
+      EXPECT_EQ(static_cast<std::byte>(frame.seq % 10), frame.pixels[0]);
+      seen.push_back(frame.seq);
+    });
+  }
+
+  ASSERT_EQ(1000, seen.size());
+  for(std::size_t i = 0; i < seen.size(); ++i) {
+    ASSERT_EQ(static_cast<int>(i), seen[i]);
+  }
+
+  // Slots went back to the pool after each drain, so the first slab was plenty
+  EXPECT_EQ(mgfw::SlabPool<Frame>::FIRST_SLAB_SLOTS, channel.pool().capacity());
+}
+
+TEST(SlabChannelTest, RefusedMessagesKeepTheirSlot) {
+  LoggerMock         logger;
+  SlabChannel<Frame> channel(
+    logger, 1, {.queue = {.capacity = 2, .overflow = OverflowPolicy::Fail}, .cacheSize = 4});
+  SlabWriter<Frame> writer(channel);
+  SlabReader<Frame> reader(channel);
+
+  for(int i = 0; i < 1000; ++i) {
+    writer.write(Frame{.seq = i});
+  }
+
+  std::vector<int> seen;
+  reader.drain([&](const Frame &frame) { seen.push_back(frame.seq); });
+  EXPECT_EQ((std::vector<int>{0, 1}), seen);
+  EXPECT_EQ(mgfw::SlabPool<Frame>::FIRST_SLAB_SLOTS, channel.pool().capacity());
+
+  EXPECT_THROW(
+    {
+      SlabChannel<Frame> overwriting(
+        logger, 2, {.queue = {.capacity = 2, .overflow = OverflowPolicy::OverwriteOldest}});
+    },
+    std::invalid_argument);
+}
+
+TEST(SlabChannelTest, ThrowingFillKeepsItsSlot) {
+  LoggerMock         logger;
+  SlabChannel<Frame> channel(logger, 1, {.cacheSize = 4});
+  SlabWriter<Frame>  writer(channel);
+  SlabReader<Frame>  reader(channel);
+
+  for(int i = 0; i < 1000; ++i) {
+    EXPECT_THROW(writer.write_with([](Frame &) { throw std::runtime_error("fill failed"); }),
+                 std::runtime_error);
+  }
+  EXPECT_EQ(mgfw::SlabPool<Frame>::FIRST_SLAB_SLOTS, channel.pool().capacity());
+
+  EXPECT_TRUE(writer.write_with([](Frame &frame) { frame.seq = 7; }));
+  std::vector<int> seen;
+  reader.drain([&](const Frame &frame) { seen.push_back(frame.seq); });
+  EXPECT_EQ((std::vector<int>{7}), seen);
+}
+
+TEST(SlabChannelTest, SlotsCirculateBetweenThreads) {
+  constexpr int NUM_FRAMES = 50'000;
+
+  LoggerMock         logger;
+  SlabChannel<Frame> channel(logger, 1);
+
+  std::jthread producer([&] {
+    SlabWriter<Frame> writer(channel);
+    for(int i = 0; i < NUM_FRAMES; ++i) {
+      writer.write_with([&](Frame &frame) {
+        frame.seq = i;
+        frame.pixels.fill(static_cast<std::byte>(i));
+      });
+    }
+  });
+
+  SlabReader<Frame> reader(channel);
+  int               expected = 0;
+  while(expected < NUM_FRAMES) {
+    reader.wait_and_drain(std::chrono::milliseconds(10), [&](const Frame &frame) {
+      ASSERT_EQ(expected, frame.seq);
+      ASSERT_EQ(static_cast<std::byte>(expected), frame.pixels.back());
+      ++expected;
+    });
+  }
+}
@@ -0,0 +1,88 @@
+#include "mgfw/SlabPool.hpp"
+
+#include "mgfw/types.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <set>
+#include <span>
+#include <thread>
+#include <vector>
+
+using mgfw::SlabPool;
+using mgfw::U32;
+
+TEST(SlabPoolTest, HandlesAreUniqueAndSlotsStayPut) {
+  SlabPool<int> pool;
+  EXPECT_EQ(SlabPool<int>::FIRST_SLAB_SLOTS, pool.capacity());
+
+  // Take exactly what the first two slabs hold, so the pool has to grow once
+  constexpr std::size_t COUNT = SlabPool<int>::FIRST_SLAB_SLOTS * 3;
+  std::vector<U32>      handles;
+  std::vector<int *>    slots;
+  for(std::size_t i = 0; i < COUNT; ++i) {
+    const U32 handle = pool.acquire();
+    pool[handle]     = static_cast<int>(i);
+    handles.push_back(handle);
+    slots.push_back(&pool[handle]);
+  }
+  EXPECT_EQ(SlabPool<int>::FIRST_SLAB_SLOTS * 3, pool.capacity());
+  EXPECT_EQ(COUNT, std::set<U32>(handles.begin(), handles.end()).size());
+
+  for(std::size_t i = 0; i < COUNT; ++i) {
+    ASSERT_EQ(slots[i], &pool[handles[i]]);
+    ASSERT_EQ(static_cast<int>(i), pool[handles[i]]);
+  }
+
+  // Released handles are handed out again before the pool grows any further
+  pool.release(handles);
+  std::vector<U32> again(COUNT);
+  std::size_t      taken = 0;
+  while(taken < COUNT) {
+    taken += pool.acquire(std::span<U32>(again).subspan(taken));
+  }
+  EXPECT_EQ(SlabPool<int>::FIRST_SLAB_SLOTS * 3, pool.capacity());
+}
+
+TEST(SlabPoolTest, ConcurrentAcquireAndRelease) {
+  constexpr int         THREADS = 8;
+  constexpr int         ROUNDS  = 20'000;
+  constexpr std::size_t BATCH   = 16;
+
+  SlabPool<std::size_t> pool;
+
+  std::vector<std::jthread> threads;
+  for(int t = 0; t < THREADS; ++t) {
+    threads.emplace_back([&, t] {
+      std::vector<U32> batch(BATCH);
+      for(int round = 0; round < ROUNDS; ++round) {
+        const std::size_t count = pool.acquire(batch);
+
+        // Nobody else may hold the same slot at the same time
+        const auto stamp = (static_cast<std::size_t>(t) << 32U) | static_cast<std::size_t>(round);
+        for(std::size_t i = 0; i < count; ++i) {
+          pool[batch[i]] = stamp;
+        }
+        for(std::size_t i = 0; i < count; ++i) {
+          ASSERT_EQ(stamp, pool[batch[i]]);
+        }
+
+        pool.release(std::span<const U32>(batch.data(), count));
+      }
+    });
+  }
+  threads.clear();
+
+  // Everything went back, so all of it can be taken in one go
+  const std::size_t capacity = pool.capacity();
+  std::vector<U32>  all(capacity);
+  std::size_t       taken = 0;
+  while(taken < capacity) {
+    taken += pool.acquire(std::span<U32>(all).subspan(taken));
+  }
+  EXPECT_EQ(capacity, pool.capacity());
+  std::ranges::sort(all);
+  EXPECT_EQ(all.end(), std::ranges::adjacent_find(all));
+}
@@ -0,0 +1,97 @@
+#include "mgfw/StaticMQHive.hpp"
+
+#include "mgfw/EventReader.hpp"
+#include "mgfw/EventWriter.hpp"
+#include "mgfw/MessageQueue.hpp"
+#include "mgfw/StringKey.hpp"
+#include "mgfw_test/LoggerMock.hpp"
+
+#include <gtest/gtest.h>
+
+#include <concepts>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using mgfw::EventReader;
+using mgfw::EventWriter;
+using mgfw::QueueBackend;
+using mgfw::QueueConfig;
+using mgfw::StaticChannel;
+using mgfw::StaticMQHive;
+using mgfw::string_key;
+using mgfw_test::LoggerMock;
+
+struct Tick {
+  int price;
+};
+
+namespace {
+
+constexpr auto TICKS = string_key("ticks");
+constexpr auto NAMES = string_key("names");
+
+using Hive_t =
+  StaticMQHive<StaticChannel<TICKS, Tick>,
+               StaticChannel<NAMES, std::string, QueueConfig{.backend = QueueBackend::SPSC}>>;
+
+template<typename H, mgfw::Hash_t key>
+concept HasChannel = requires(H &hive) { hive.template get_writer<key>(); };
+
+template<typename H, typename T, mgfw::Hash_t key>
+concept HasChannelOf = requires(H &hive) { hive.template get_reader<T, key>(); };
+
+}  // namespace
+
+// Mistakes are compile errors rather than exceptions
+static_assert(HasChannel<Hive_t, TICKS>);
+static_assert(!HasChannel<Hive_t, string_key("nope")>);
+static_assert(HasChannelOf<Hive_t, Tick, TICKS>);
+static_assert(!HasChannelOf<Hive_t, std::string, TICKS>);
+static_assert(std::same_as<Hive_t::Message_t<NAMES>, std::string>);
+
+TEST(StaticMQHiveTest, DeclaredChannelsCarryMessages) {
+  LoggerMock logger;
+  Hive_t     hive(logger);
+
+  EventWriter<Tick> writer = hive.get_writer<TICKS>();
+  EventReader<Tick> reader = hive.get_reader<Tick, TICKS>();
+
+  writer.write({42});
+  writer.write({43});
+
+  std::vector<int> prices;
+  reader.drain([&](const Tick &tick) { prices.push_back(tick.price); });
+  EXPECT_EQ((std::vector<int>{42, 43}), prices);
+}
+
+TEST(StaticMQHiveTest, ChannelsUseTheirDeclaredConfig) {
+  LoggerMock logger;
+  Hive_t     hive(logger);
+
+  EventWriter<std::string> writer = hive.get_writer<NAMES>();
+  writer.write("alice");
+
+  // SPSC, so there's only room for one reader
+  EventReader<std::string> reader = hive.get_reader<NAMES>();
+  EXPECT_THROW(hive.get_reader<NAMES>(), std::runtime_error);
+
+  std::string name;
+  reader.drain([&](const std::string &msg) { name = msg; });
+  EXPECT_EQ("alice", name);
+}
+
+TEST(StaticMQHiveTest, DynamicChannelsAreSeparate) {
+  LoggerMock logger;
+  Hive_t     hive(logger);
+
+  hive.get_writer<TICKS>().write({1});
+  hive.dynamic().get_writer<int>(TICKS).write(2);
+
+  EXPECT_EQ(1, hive.queue<TICKS>().size_approx());
+
+  int value = 0;
+  hive.dynamic().get_reader<int>(TICKS).drain([&](const int msg) { value = msg; });
+  EXPECT_EQ(2, value);
+  hive.get_reader<TICKS>().drain([](const Tick &) { });
+}
@@ -0,0 +1,56 @@
+#include "mgfw/WorkerPool.hpp"
+
+#include "mgfw_test/LoggerMock.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <latch>
+#include <stdexcept>
+
+using mgfw::WorkerPool;
+using mgfw_test::LoggerMock;
+using ::testing::HasSubstr;
+
+TEST(WorkerPoolTest, RunsEveryJob) {
+  LoggerMock logger;
+  WorkerPool pool(logger, 4);
+  EXPECT_EQ(4, pool.size());
+
+  constexpr int    JOBS = 1000;
+  std::atomic<int> ran{0};
+  std::latch       done(JOBS);
+  for(int i = 0; i < JOBS; ++i) {
+    pool.do_now([&] {
+      ran.fetch_add(1);
+      done.count_down();
+    });
+  }
+
+  done.wait();
+  EXPECT_EQ(JOBS, ran.load());
+}
+
+TEST(WorkerPoolTest, LogsJobsThatThrow) {
+  LoggerMock logger;
+  WorkerPool pool(logger, 1);
+
+  EXPECT_CALL(logger, error(HasSubstr("boom")));
+
+  std::latch done(1);
+  pool.do_now([] { throw std::runtime_error("boom"); });
+  pool.do_now([&] { done.count_down(); });
+  done.wait();
+}
+
+TEST(WorkerPoolTest, IgnoresJobsOnceStopped) {
+  LoggerMock logger;
+  WorkerPool pool(logger, 2);
+  pool.stop();
+
+  bool ran = false;
+  pool.do_now([&] { ran = true; });
+  pool.stop();
+  EXPECT_FALSE(ran);
+}
@@ -1,18 +1,48 @@
+#include "mgfw/Coroutine.hpp"
+#include "mgfw/Dispatch.hpp"
 #include "mgfw/EventReader.hpp"
 #include "mgfw/EventWriter.hpp"
+#include "mgfw/Expiring.hpp"
 #include "mgfw/MessageQueue.hpp"
+#include "mgfw/types.hpp"
+#include "mgfw_test/ClockMock.hpp"
 #include "mgfw_test/LoggerMock.hpp"
+#include "mgfw_test/ManualExecutor.hpp"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <format>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <utility>
+#include <variant>
 #include <vector>
 
+using mgfw::DetachedTask;
 using mgfw::EventReader;
 using mgfw::EventWriter;
+using mgfw::Expiring;
 using mgfw::MessageQueue;
+using mgfw::OverflowPolicy;
+using mgfw::Priority;
+using mgfw::QueueBackend;
+using mgfw::TimePoint_t;
+using mgfw_test::ClockMock;
 using mgfw_test::LoggerMock;
+using mgfw_test::ManualExecutor;
+
+using namespace std::chrono_literals;
 
 struct Strukt {
   int  i;
@@ -76,3 +106,1021 @@ TEST(MessageQueueTest, NoWarningLoggedIfNoMessagesRemain) {
     queue.drain([]([[maybe_unused]] const auto &) { });
   }
 }
+
+TEST(MessageQueueTest, DrainBulkRespectsMaxBatch) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventWriter<int>  writer(queue);
+  EventReader<int>  reader(queue);
+
+  const int NUM_MSGS  = 10;
+  const int MAX_BATCH = 4;
+  for(int i = 0; i < NUM_MSGS; ++i) {
+    writer.write(i);
+  }
+
+  std::vector<std::size_t> batchSizes;
+  std::vector<int>         drained;
+  reader.drain_bulk(
+    [&](std::span<int> batch) {
+      batchSizes.push_back(batch.size());
+      drained.insert(drained.end(), batch.begin(), batch.end());
+    },
+    MAX_BATCH);
+
+  EXPECT_EQ(batchSizes, (std::vector<std::size_t>{4, 4, 2}));
+  ASSERT_EQ(drained.size(), NUM_MSGS);
+  for(int i = 0; i < NUM_MSGS; ++i) {
+    EXPECT_EQ(drained[static_cast<std::size_t>(i)], i);
+  }
+}
+
+TEST(MessageQueueTest, DrainBulkAllowsMovingOutOfBatch) {
+  LoggerMock                logger;
+  MessageQueue<std::string> queue(logger, 1);
+  EventWriter<std::string>  writer(queue);
+  EventReader<std::string>  reader(queue);
+
+  writer.emplace("One");
+  writer.emplace("Two");
+
+  std::vector<std::string> drained;
+  reader.drain_bulk([&](std::span<std::string> batch) {
+    for(auto &msg : batch) {
+      drained.emplace_back(std::move(msg));
+    }
+  });
+
+  EXPECT_EQ(drained, (std::vector<std::string>{"One", "Two"}));
+
+  // Nothing left; the callback should not be invoked for an empty queue
+  bool invoked = false;
+  reader.drain_bulk([&]([[maybe_unused]] std::span<std::string> batch) { invoked = true; });
+  EXPECT_FALSE(invoked);
+}
+
+TEST(MessageQueueTest, TokenOverloadsPreserveProducerOrder) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+
+  auto producerToken = queue.make_producer_token();
+  auto consumerToken = queue.make_consumer_token();
+
+  queue.enqueue(producerToken, 1);
+  queue.emplace(producerToken, 2);
+  queue.enqueue_bulk(producerToken, {3, 4});
+
+  std::vector<int> drained;
+  queue.drain(consumerToken, [&](const int &msg) { drained.push_back(msg); });
+
+  EXPECT_EQ(drained, (std::vector<int>{1, 2, 3, 4}));
+}
+
+TEST(MessageQueueTest, WritersOnSeparateThreadsDeliverEverything) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventReader<int>  reader(queue);
+
+  const int NUM_THREADS     = 4;
+  const int MSGS_PER_THREAD = 1000;
+
+  {
+    std::vector<std::jthread> producers;
+    for(int t = 0; t < NUM_THREADS; ++t) {
+      producers.emplace_back([&queue, t] {
+        EventWriter<int> writer(queue);
+        for(int i = 0; i < MSGS_PER_THREAD; ++i) {
+          writer.write((t * MSGS_PER_THREAD) + i);
+        }
+      });
+    }
+  }
+
+  // Each producer's messages should arrive in the order they were written
+  std::vector<int> lastSeen(NUM_THREADS, -1);
+  int              count = 0;
+  reader.drain([&](const int &msg) {
+    auto &last = lastSeen[static_cast<std::size_t>(msg / MSGS_PER_THREAD)];
+    EXPECT_GT(msg, last);
+    last = msg;
+    ++count;
+  });
+
+  EXPECT_EQ(NUM_THREADS * MSGS_PER_THREAD, count);
+}
+
+TEST(MessageQueueTest, EveryBackendDeliversInOrder) {
+  for(const auto backend : {QueueBackend::MPMC, QueueBackend::SPSC, QueueBackend::MPSC}) {
+    LoggerMock                logger;
+    MessageQueue<std::string> queue(logger, 1, {.backend = backend});
+    EventWriter<std::string>  writer(queue);
+    EventReader<std::string>  reader(queue);
+
+    writer.emplace("One");
+    writer.write_bulk({"Two", "Three"});
+    EXPECT_EQ(3, queue.size_approx());
+
+    std::vector<std::string> drained;
+    reader.drain([&](const std::string &msg) { drained.emplace_back(msg); });
+
+    EXPECT_EQ(drained, (std::vector<std::string>{"One", "Two", "Three"}));
+  }
+}
+
+TEST(MessageQueueTest, SingleEndpointBackendsRejectExtraEndpoints) {
+  LoggerMock        logger;
+  MessageQueue<int> spsc(logger, 1, {.backend = QueueBackend::SPSC});
+  MessageQueue<int> mpsc(logger, 2, {.backend = QueueBackend::MPSC});
+
+  {
+    EventWriter<int> writer(spsc);
+    EventReader<int> reader(spsc);
+    EXPECT_THROW({ EventWriter<int> another(spsc); }, std::runtime_error);
+    EXPECT_THROW({ EventReader<int> another(spsc); }, std::runtime_error);
+  }
+
+  // Endpoints give their claim back when destroyed
+  EXPECT_NO_THROW({ EventWriter<int> writer(spsc); });
+
+  EventWriter<int> writer1(mpsc);
+  EventWriter<int> writer2(mpsc);
+  EventReader<int> reader(mpsc);
+  EXPECT_THROW({ EventReader<int> another(mpsc); }, std::runtime_error);
+}
+
+namespace {
+
+std::vector<int> drain_all(EventReader<int> &reader) {
+  std::vector<int> drained;
+  reader.drain([&](const int &msg) { drained.push_back(msg); });
+  return drained;
+}
+
+}  // namespace
+
+TEST(MessageQueueTest, BoundedFailLeavesMessageWithCaller) {
+  LoggerMock                logger;
+  MessageQueue<std::string> queue(logger, 1, {.capacity = 1, .overflow = OverflowPolicy::Fail});
+
+  EXPECT_TRUE(queue.enqueue("first"));
+
+  std::string second = "second";
+  EXPECT_FALSE(queue.enqueue(std::move(second)));
+  // NOLINTNEXTLINE(bugprone-use-after-move,hicpp-invalid-access-moved)
+  EXPECT_EQ("second", second);
+  EXPECT_EQ(1, queue.overflow_stats().rejected);
+
+  // Draining frees up room again
+  queue.drain([]([[maybe_unused]] const auto &) { });
+  EXPECT_TRUE(queue.enqueue(std::move(second)));
+  queue.drain([]([[maybe_unused]] const auto &) { });
+}
+
+TEST(MessageQueueTest, BoundedDropNewest) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1, {.capacity = 2, .overflow = OverflowPolicy::DropNewest});
+  EventWriter<int>  writer(queue);
+  EventReader<int>  reader(queue);
+
+  EXPECT_EQ(2, writer.write_bulk({1, 2, 3, 4}));
+  EXPECT_FALSE(writer.write(5));
+
+  EXPECT_EQ(drain_all(reader), (std::vector<int>{1, 2}));
+  EXPECT_EQ(3, queue.overflow_stats().dropped);
+}
+
+TEST(MessageQueueTest, BoundedOverwriteOldest) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1, {.capacity = 2, .overflow = OverflowPolicy::OverwriteOldest});
+  EventWriter<int>  writer(queue);
+  EventReader<int>  reader(queue);
+
+  for(int i = 1; i <= 5; ++i) {
+    EXPECT_TRUE(writer.write(i));
+  }
+
+  EXPECT_EQ(drain_all(reader), (std::vector<int>{4, 5}));
+  EXPECT_EQ(3, queue.overflow_stats().dropped);
+}
+
+TEST(MessageQueueTest, OverwriteOldestRequiresMpmcBackend) {
+  LoggerMock logger;
+  EXPECT_THROW(
+    {
+      MessageQueue<int> queue(logger,
+                              1,
+                              {
+                                .backend  = QueueBackend::SPSC,
+                                .capacity = 1,
+                                .overflow = OverflowPolicy::OverwriteOldest,
+                              });
+    },
+    std::invalid_argument);
+}
+
+TEST(MessageQueueTest, BoundedBlockWaitsForConsumer) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(
+    logger, 1, {.backend = QueueBackend::SPSC, .capacity = 4, .overflow = OverflowPolicy::Block});
+  EventReader<int> reader(queue);
+
+  const int NUM_MSGS = 1000;
+
+  std::atomic_bool producerDone{false};
+  std::jthread     producer([&] {
+    EventWriter<int> writer(queue);
+    for(int i = 0; i < NUM_MSGS; ++i) {
+      EXPECT_TRUE(writer.write(i));
+      EXPECT_LE(queue.size_approx(), queue.capacity());
+    }
+    producerDone = true;
+  });
+
+  std::vector<int> drained;
+  while(!producerDone || queue.size_approx() > 0) {
+    reader.drain([&](const int &msg) { drained.push_back(msg); });
+  }
+
+  ASSERT_EQ(NUM_MSGS, drained.size());
+  for(int i = 0; i < NUM_MSGS; ++i) {
+    EXPECT_EQ(i, drained[static_cast<std::size_t>(i)]);
+  }
+  EXPECT_EQ(0, queue.overflow_stats().dropped);
+}
+
+TEST(MessageQueueTest, WaitForAnyTimesOutOnEmptyQueue) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventReader<int>  reader(queue);
+
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(reader.wait_for_any(20ms));
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+
+  bool invoked = false;
+  EXPECT_FALSE(
+    reader.wait_and_drain(1ms, [&]([[maybe_unused]] const int &msg) { invoked = true; }));
+  EXPECT_FALSE(invoked);
+}
+
+TEST(MessageQueueTest, WaitForAnyStillBlocksAfterABurst) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventWriter<int>  writer(queue);
+  EventReader<int>  reader(queue);
+
+  // Burst while a consumer is parked; only the first write should post a wake-up
+  {
+    std::jthread waiter([&] { EXPECT_TRUE(reader.wait_for_any(10s)); });
+    std::this_thread::sleep_for(20ms);
+    for(int i = 0; i < 1000; ++i) {
+      writer.write(i);
+    }
+  }
+  EXPECT_EQ(1000, drain_all(reader).size());
+
+  // No permits left over from the burst, so waiting on the empty queue actually blocks
+  for(int i = 0; i < 3; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(reader.wait_for_any(20ms));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+  }
+
+  // ...and the next write still wakes a parked consumer
+  std::jthread producer([&] {
+    std::this_thread::sleep_for(20ms);
+    writer.write(-1);
+  });
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(reader.wait_for_any(10s));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+  EXPECT_EQ(drain_all(reader), (std::vector<int>{-1}));
+}
+
+TEST(MessageQueueTest, WaitForAnyReturnsImmediatelyIfMessagesArePending) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventWriter<int>  writer(queue);
+  EventReader<int>  reader(queue);
+
+  writer.write(1);
+  EXPECT_TRUE(reader.wait_for_any(0ms));
+  EXPECT_EQ(drain_all(reader), (std::vector<int>{1}));
+}
+
+TEST(MessageQueueTest, WaitAndDrainWakesOnEnqueue) {
+  for(const auto backend : {QueueBackend::MPMC, QueueBackend::SPSC, QueueBackend::MPSC}) {
+    LoggerMock        logger;
+    MessageQueue<int> queue(logger, 1, {.backend = backend});
+    EventReader<int>  reader(queue);
+
+    const int NUM_MSGS = 100;
+
+    std::jthread producer([&] {
+      EventWriter<int> writer(queue);
+      for(int i = 0; i < NUM_MSGS; ++i) {
+        writer.write(i);
+        if(i % 10 == 0) {
+          std::this_thread::sleep_for(1ms);
+        }
+      }
+    });
+
+    // Generous timeout; a lost wakeup would show up as the test taking (much) longer than usual
+    std::vector<int> drained;
+    while(drained.size() < NUM_MSGS) {
+      ASSERT_TRUE(
+        reader.wait_and_drain(10s, [&](const int &msg) { drained.push_back(msg); }));
+    }
+
+    for(int i = 0; i < NUM_MSGS; ++i) {
+      EXPECT_EQ(i, drained[static_cast<std::size_t>(i)]);
+    }
+  }
+}
+
+TEST(MessageQueueTest, ReserveCommitOnEveryBackend) {
+  for(const auto backend : {QueueBackend::MPMC, QueueBackend::SPSC, QueueBackend::MPSC}) {
+    LoggerMock                logger;
+    MessageQueue<std::string> queue(logger, 1, {.backend = backend});
+    EventWriter<std::string>  writer(queue);
+    EventReader<std::string>  reader(queue);
+
+    writer.reserve() = "One";
+    EXPECT_EQ(0, queue.size_approx());
+    // Reserving again before committing hands out the same storage
+    writer.reserve() += "!";
+    EXPECT_TRUE(writer.commit());
+    writer.write("Two");
+
+    std::string *msg = reader.peek();
+    ASSERT_NE(nullptr, msg);
+    EXPECT_EQ("One!", *msg);
+    EXPECT_EQ(msg, reader.peek());
+    *msg = "moved out";
+    reader.release();
+
+    msg = reader.peek();
+    ASSERT_NE(nullptr, msg);
+    EXPECT_EQ("Two", *msg);
+    reader.release();
+
+    EXPECT_EQ(nullptr, reader.peek());
+  }
+}
+
+TEST(MessageQueueTest, BoundedCommitAppliesOverflowPolicy) {
+  for(const auto backend : {QueueBackend::MPMC, QueueBackend::SPSC, QueueBackend::MPSC}) {
+    LoggerMock        logger;
+    MessageQueue<int> queue(
+      logger, 1, {.backend = backend, .capacity = 1, .overflow = OverflowPolicy::Fail});
+    EventWriter<int> writer(queue);
+    EventReader<int> reader(queue);
+
+    writer.reserve() = 1;
+    EXPECT_TRUE(writer.commit());
+    writer.reserve() = 2;
+    EXPECT_FALSE(writer.commit());
+
+    // The reservation survives a failed commit, and releasing a peeked message makes room again
+    ASSERT_NE(nullptr, reader.peek());
+    reader.release();
+    EXPECT_EQ(2, writer.reserve());
+    EXPECT_TRUE(writer.commit());
+    EXPECT_EQ(std::vector<int>{2}, drain_all(reader));
+  }
+}
+
+TEST(MessageQueueTest, ReserveCommitAcrossThreads) {
+  constexpr int NUM_MSGS = 100'000;
+
+  for(const auto backend : {QueueBackend::MPMC, QueueBackend::SPSC, QueueBackend::MPSC}) {
+    LoggerMock        logger;
+    MessageQueue<int> queue(logger, 1, {.backend = backend});
+    EventReader<int>  reader(queue);
+
+    std::thread producer([&] {
+      EventWriter<int> writer(queue);
+      for(int i = 0; i < NUM_MSGS; ++i) {
+        writer.reserve() = i;
+        writer.commit();
+      }
+    });
+
+    int expected = 0;
+    while(expected < NUM_MSGS) {
+      if(const int *msg = reader.peek(); msg != nullptr) {
+        ASSERT_EQ(expected, *msg);
+        reader.release();
+        ++expected;
+      }
+    }
+
+    producer.join();
+    EXPECT_EQ(nullptr, reader.peek());
+  }
+}
+
+TEST(MessageQueueTest, HigherLanesAreDrainedFirst) {
+  for(const auto backend : {QueueBackend::MPMC, QueueBackend::SPSC, QueueBackend::MPSC}) {
+    LoggerMock        logger;
+    MessageQueue<int> queue(logger, 1, {.backend = backend, .lanes = 3});
+    EventWriter<int>  writer(queue);
+    EventReader<int>  reader(queue);
+
+    writer.write(30, Priority::Low);
+    writer.write(20);
+    writer.write_bulk({10, 11}, Priority::High);
+    writer.reserve(Priority::Low) = 31;
+    writer.commit();
+    EXPECT_EQ(5, queue.size_approx());
+
+    EXPECT_EQ((std::vector<int>{10, 11, 20, 30, 31}), drain_all(reader));
+  }
+}
+
+TEST(MessageQueueTest, HighPriorityMessagesPreemptADrain) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1, {.lanes = 2});
+  EventWriter<int>  writer(queue);
+  EventReader<int>  reader(queue);
+
+  writer.write_bulk({1, 2, 3});
+
+  // A high-priority message that shows up mid-drain jumps ahead of the remaining bulk traffic
+  std::vector<int> drained;
+  reader.drain([&](const int &msg) {
+    drained.push_back(msg);
+    if(msg == 1) {
+      writer.write(100, Priority::High);
+    }
+  });
+  EXPECT_EQ((std::vector<int>{1, 100, 2, 3}), drained);
+
+  writer.write_bulk({1, 2, 3});
+  std::vector<std::size_t> batchSizes;
+  reader.drain_bulk(
+    [&](std::span<int> batch) {
+      batchSizes.push_back(batch.size());
+      if(batch.front() == 1) {
+        writer.write(100, Priority::High);
+      }
+    },
+    2);
+  EXPECT_EQ((std::vector<std::size_t>{2, 1, 1}), batchSizes);
+}
+
+TEST(MessageQueueTest, LowestPrioritiesShareTheLastLane) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1, {.lanes = 2});
+  EventWriter<int>  writer(queue);
+  EventReader<int>  reader(queue);
+
+  writer.write(1, Priority::Low);
+  writer.write(2, Priority::Normal);
+  writer.write(3, Priority::High);
+  EXPECT_EQ((std::vector<int>{3, 1, 2}), drain_all(reader));
+
+  EXPECT_THROW({ MessageQueue<int> invalid(logger, 2, {.lanes = 0}); }, std::invalid_argument);
+  EXPECT_THROW({ MessageQueue<int> invalid(logger, 3, {.lanes = 4}); }, std::invalid_argument);
+}
+
+TEST(MessageQueueTest, PeekTakesHighestLaneFirst) {
+  for(const auto backend : {QueueBackend::MPMC, QueueBackend::SPSC, QueueBackend::MPSC}) {
+    LoggerMock        logger;
+    MessageQueue<int> queue(logger, 1, {.backend = backend, .lanes = 3});
+    EventWriter<int>  writer(queue);
+    EventReader<int>  reader(queue);
+
+    writer.write(3, Priority::Low);
+    writer.write(1, Priority::High);
+
+    std::vector<int> drained;
+    while(const int *msg = reader.peek()) {
+      drained.push_back(*msg);
+      reader.release();
+    }
+    EXPECT_EQ((std::vector<int>{1, 3}), drained);
+  }
+}
+
+TEST(MessageQueueTest, OverwriteOldestEvictsFromLowestLane) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(
+    logger, 1, {.lanes = 2, .capacity = 2, .overflow = OverflowPolicy::OverwriteOldest});
+  EventWriter<int> writer(queue);
+  EventReader<int> reader(queue);
+
+  writer.write(1, Priority::High);
+  writer.write(2);
+  writer.write(3, Priority::High);
+  EXPECT_EQ((std::vector<int>{1, 3}), drain_all(reader));
+}
+
+TEST(MessageQueueTest, StatsTrackTraffic) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1, {.capacity = 3, .overflow = OverflowPolicy::DropNewest});
+  EventWriter<int>  writer(queue);
+  EventReader<int>  reader(queue);
+
+  EXPECT_EQ(3, writer.write_bulk({1, 2, 3, 4}));
+  drain_all(reader);
+  writer.write(5);
+
+  const auto stats = queue.stats();
+  EXPECT_EQ(4, stats.enqueued);
+  EXPECT_EQ(3, stats.dequeued);
+  EXPECT_EQ(1, stats.depth);
+  EXPECT_EQ(3, stats.highWaterMark);
+  EXPECT_EQ(1, stats.overflow.dropped);
+  EXPECT_FALSE(stats.latency.has_value());
+
+  drain_all(reader);
+}
+
+TEST(MessageQueueTest, SamplesWriteToDrainLatency) {
+  for(const auto backend : {QueueBackend::MPMC, QueueBackend::SPSC, QueueBackend::MPSC}) {
+    LoggerMock        logger;
+    MessageQueue<int> queue(logger, 1, {.backend = backend, .latencySampleInterval = 4});
+    EventWriter<int>  writer(queue);
+    EventReader<int>  reader(queue);
+
+    for(int i = 0; i < 16; ++i) {
+      writer.write(i);
+    }
+    std::this_thread::sleep_for(1ms);
+    drain_all(reader);
+
+    const auto stats = queue.stats();
+    ASSERT_TRUE(stats.latency.has_value());
+    EXPECT_EQ(4, stats.latency->samples());
+    EXPECT_GE(stats.latency->quantile(0.5), 1ms);
+  }
+}
+
+namespace {
+
+struct CopyCounter {
+  CopyCounter() = default;
+
+  explicit CopyCounter(const int valueArg) : value(valueArg) { }
+
+  CopyCounter(const CopyCounter &other) : value(other.value) { ++copies; }
+
+  CopyCounter(CopyCounter &&other) noexcept : value(other.value) { }
+
+  CopyCounter &operator=(const CopyCounter &other) {
+    value = other.value;
+    ++copies;
+    return *this;
+  }
+
+  CopyCounter &operator=(CopyCounter &&other) noexcept {
+    value = other.value;
+    return *this;
+  }
+
+  ~CopyCounter() = default;
+
+  int value = 0;
+
+  static inline int copies = 0;
+};
+
+}  // namespace
+
+TEST(MessageQueueTest, LatencySamplesArePairedWithinALane) {
+  for(const auto backend : {QueueBackend::MPMC, QueueBackend::SPSC, QueueBackend::MPSC}) {
+    LoggerMock        logger;
+    MessageQueue<int> queue(
+      logger, 1, {.backend = backend, .lanes = 2, .latencySampleInterval = 1});
+    EventWriter<int> writer(queue);
+    EventReader<int> reader(queue);
+
+    // The high-priority message overtakes the low one, and is taken right away, while the low one
+    // waits another 10ms; pairing samples across lanes would report ~5ms and ~10ms instead
+    writer.write(1, Priority::Low);
+    std::this_thread::sleep_for(5ms);
+    writer.write(2, Priority::High);
+    ASSERT_EQ(2, *reader.peek());
+    reader.release();
+    std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(drain_all(reader), (std::vector<int>{1}));
+
+    const auto stats = queue.stats();
+    ASSERT_TRUE(stats.latency.has_value());
+    EXPECT_EQ(2, stats.latency->samples());
+    EXPECT_LT(stats.latency->quantile(0.5), 4ms);
+    EXPECT_GE(stats.latency->quantile(1.0), 15ms);
+  }
+}
+
+TEST(MessageQueueTest, PeekUpdatesHighWaterMark) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventWriter<int>  writer(queue);
+  EventReader<int>  reader(queue);
+
+  writer.write_bulk({1, 2, 3, 4, 5});
+
+  std::vector<int> taken;
+  EXPECT_EQ(5, reader.take_bulk(taken, 10));
+  EXPECT_EQ(5, queue.stats().highWaterMark);
+}
+
+TEST(MessageQueueTest, StatsCountWritesFromEveryThread) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventReader<int>  reader(queue);
+
+  const int NUM_THREADS = 12;
+  const int NUM_MSGS    = 1000;
+  {
+    std::vector<std::jthread> producers;
+    for(int t = 0; t < NUM_THREADS; ++t) {
+      producers.emplace_back([&] {
+        EventWriter<int> writer(queue);
+        for(int i = 0; i < NUM_MSGS; ++i) {
+          writer.write(i);
+        }
+      });
+    }
+  }
+
+  EXPECT_EQ(NUM_THREADS * NUM_MSGS, queue.stats().enqueued);
+  EXPECT_EQ(NUM_THREADS * NUM_MSGS, drain_all(reader).size());
+}
+
+TEST(MessageQueueTest, WritesMoveRvalues) {
+  for(const auto backend : {QueueBackend::MPMC, QueueBackend::SPSC, QueueBackend::MPSC}) {
+    LoggerMock                logger;
+    MessageQueue<CopyCounter> queue(logger, 1, {.backend = backend});
+    EventWriter<CopyCounter>  writer(queue);
+    EventReader<CopyCounter>  reader(queue);
+
+    CopyCounter::copies = 0;
+
+    CopyCounter message(1);
+    writer.write(std::move(message));
+    writer.write(CopyCounter(2));
+
+    std::vector<CopyCounter> batch{};
+    batch.emplace_back(3);
+    batch.emplace_back(4);
+    writer.write_bulk(std::move(batch));
+
+    std::array<CopyCounter, 2> moveFrom{CopyCounter(5), CopyCounter(6)};
+    writer.write_bulk(std::ranges::subrange(std::make_move_iterator(moveFrom.begin()),
+                                            std::make_move_iterator(moveFrom.end())));
+    EXPECT_EQ(0, CopyCounter::copies);
+
+    // Lvalues and views are left alone
+    const std::array<CopyCounter, 2> copyFrom{CopyCounter(7), CopyCounter(8)};
+    writer.write_bulk(copyFrom);
+    writer.write_bulk(std::span(copyFrom));
+    EXPECT_EQ(4, CopyCounter::copies);
+
+    std::vector<int> drained;
+    reader.drain([&](const CopyCounter &msg) { drained.push_back(msg.value); });
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 7, 8}), drained);
+  }
+}
+
+TEST(MessageQueueTest, BoundedBulkWriteMovesWhatFits) {
+  LoggerMock                logger;
+  MessageQueue<std::string> queue(logger, 1, {.capacity = 2, .overflow = OverflowPolicy::Fail});
+  EventWriter<std::string>  writer(queue);
+  EventReader<std::string>  reader(queue);
+
+  std::vector<std::string> batch{"one", "two", "three"};
+  EXPECT_EQ(2, writer.write_bulk(std::ranges::subrange(std::make_move_iterator(batch.begin()),
+                                                       std::make_move_iterator(batch.end()))));
+  // The rejected message was never touched
+  EXPECT_EQ("three", batch[2]);
+
+  std::vector<std::string> drained;
+  reader.drain([&](const std::string &msg) { drained.push_back(msg); });
+  EXPECT_EQ((std::vector<std::string>{"one", "two"}), drained);
+}
+
+TEST(MessageQueueTest, TapSeesWritePriorityRatherThanLane) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventWriter<int>  writer(queue);
+  EventReader<int>  reader(queue);
+
+  std::vector<Priority> tapped;
+  queue.set_tap([&](const int &, const Priority priority) { tapped.push_back(priority); });
+
+  writer.write(1, Priority::Low);
+  writer.write_bulk({2}, Priority::High);
+  writer.reserve(Priority::Low) = 3;
+  writer.commit();
+  writer.write(4);
+  queue.set_tap(nullptr);
+
+  EXPECT_EQ(tapped,
+            (std::vector<Priority>{
+              Priority::Low, Priority::High, Priority::Low, Priority::Normal}));
+  EXPECT_EQ((std::vector<int>{1, 2, 3, 4}), drain_all(reader));
+}
+
+TEST(MessageQueueTest, TapSeesAcceptedMessages) {
+  for(const auto backend : {QueueBackend::MPMC, QueueBackend::SPSC, QueueBackend::MPSC}) {
+    LoggerMock        logger;
+    MessageQueue<int> queue(
+      logger, 1, {.backend = backend, .lanes = 2, .capacity = 6, .overflow = OverflowPolicy::Fail});
+    EventWriter<int>  writer(queue);
+    EventReader<int>  reader(queue);
+
+    std::vector<std::pair<int, Priority>> tapped;
+    queue.set_tap(
+      [&](const int &msg, const Priority priority) { tapped.emplace_back(msg, priority); });
+
+    writer.write(1, Priority::High);
+    writer.write_bulk({2, 3});
+    writer.reserve() = 4;
+    writer.commit();
+
+    // Only two of these fit
+    writer.write_bulk({5, 6, 7});
+
+    queue.set_tap(nullptr);
+    reader.drain([](int) { });
+    writer.write(8);
+    reader.drain([](int) { });
+
+    EXPECT_EQ(tapped,
+              (std::vector<std::pair<int, Priority>>{{1, Priority::High},
+                                                     {2, Priority::Normal},
+                                                     {3, Priority::Normal},
+                                                     {4, Priority::Normal},
+                                                     {5, Priority::Normal},
+                                                     {6, Priority::Normal}}));
+  }
+}
+
+TEST(MessageQueueTest, ReplacedTapIsNotCalledOnceSetTapReturns) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventReader<int>  reader(queue);
+
+  std::atomic<int> first{0};
+  std::atomic<int> second{0};
+  queue.set_tap([&](const int &, Priority) { first.fetch_add(1, std::memory_order::relaxed); });
+
+  const int NUM_THREADS     = 4;
+  const int MSGS_PER_THREAD = 20000;
+
+  std::vector<std::jthread> producers;
+  for(int t = 0; t < NUM_THREADS; ++t) {
+    producers.emplace_back([&queue] {
+      EventWriter<int> writer(queue);
+      for(int i = 0; i < MSGS_PER_THREAD; ++i) {
+        writer.write(i);
+      }
+    });
+  }
+
+  while(first.load(std::memory_order::relaxed) == 0) {
+    std::this_thread::yield();
+  }
+  queue.set_tap([&](const int &, Priority) { second.fetch_add(1, std::memory_order::relaxed); });
+  const int firstWhenReplaced = first.load(std::memory_order::relaxed);
+
+  producers.clear();
+
+  // Every message went through exactly one of the taps, and none through the old one late
+  EXPECT_EQ(first.load(), firstWhenReplaced);
+  EXPECT_EQ(first.load() + second.load(), NUM_THREADS * MSGS_PER_THREAD);
+  reader.drain([](int) { });
+}
+
+namespace {
+
+DetachedTask consume(EventReader<int> &reader,
+                     ManualExecutor   &executor,
+                     std::vector<int> &out,
+                     int               count) {
+  for(int i = 0; i < count; ++i) {
+    out.push_back(co_await reader.next(executor));
+  }
+}
+
+DetachedTask consume_batches(EventReader<int>              &reader,
+                             ManualExecutor                &executor,
+                             std::vector<std::vector<int>> &out,
+                             int                            count) {
+  for(int i = 0; i < count; ++i) {
+    out.push_back(co_await reader.next_batch(executor, 3));
+  }
+}
+
+/**
+ * Coroutine that runs eagerly but stays around until the test destroys it
+ */
+struct OwnedTask {
+  struct promise_type {
+    OwnedTask get_return_object() noexcept {
+      return {std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+
+    std::suspend_never initial_suspend() noexcept { return {}; }
+
+    std::suspend_always final_suspend() noexcept { return {}; }
+
+    void return_void() noexcept { }
+
+    [[noreturn]] void unhandled_exception() noexcept { std::terminate(); }
+  };
+
+  std::coroutine_handle<promise_type> handle;
+};
+
+OwnedTask consume_owned(EventReader<int> &reader,
+                        ManualExecutor   &executor,
+                        std::vector<int> &out) {
+  out.push_back(co_await reader.next(executor));
+}
+
+}  // namespace
+
+TEST(MessageQueueTest, AwaitNextResumesOnExecutor) {
+  for(const auto backend : {QueueBackend::MPMC, QueueBackend::SPSC, QueueBackend::MPSC}) {
+    LoggerMock        logger;
+    MessageQueue<int> queue(logger, 1, {.backend = backend});
+    EventWriter<int>  writer(queue);
+    EventReader<int>  reader(queue);
+    ManualExecutor    executor;
+
+    std::vector<int> received;
+    writer.write(1);
+    consume(reader, executor, received, 3);
+
+    // The first message was already there; the second await has to suspend
+    EXPECT_EQ((std::vector<int>{1}), received);
+    EXPECT_TRUE(executor.jobs.empty());
+
+    writer.write(2);
+    EXPECT_EQ((std::vector<int>{1}), received);
+    ASSERT_EQ(1, executor.jobs.size());
+    executor.run_all();
+    EXPECT_EQ((std::vector<int>{1, 2}), received);
+
+    writer.write_bulk({3, 4});
+    executor.run_all();
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), received);
+    EXPECT_EQ(drain_all(reader), (std::vector<int>{4}));
+  }
+}
+
+TEST(MessageQueueTest, AwaitNextBatchTakesWhatIsQueued) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventWriter<int>  writer(queue);
+  EventReader<int>  reader(queue);
+  ManualExecutor    executor;
+
+  std::vector<std::vector<int>> batches;
+  writer.write_bulk({1, 2, 3, 4, 5});
+  consume_batches(reader, executor, batches, 3);
+  EXPECT_EQ((std::vector<std::vector<int>>{{1, 2, 3}, {4, 5}}), batches);
+
+  writer.write(6);
+  executor.run_all();
+  EXPECT_EQ((std::vector<std::vector<int>>{{1, 2, 3}, {4, 5}, {6}}), batches);
+}
+
+TEST(MessageQueueTest, AwaitParksAgainIfAnotherReaderWins) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventWriter<int>  writer(queue);
+  EventReader<int>  first(queue);
+  EventReader<int>  second(queue);
+  ManualExecutor    executor;
+
+  std::vector<int> firstReceived;
+  std::vector<int> secondReceived;
+  consume(first, executor, firstReceived, 1);
+  consume(second, executor, secondReceived, 1);
+
+  // Both readers get woken up, but only one of them finds the message
+  writer.write(1);
+  ASSERT_EQ(2, executor.jobs.size());
+  executor.run_all();
+  EXPECT_EQ(1, firstReceived.size() + secondReceived.size());
+
+  writer.write(2);
+  executor.run_all();
+  EXPECT_EQ(1, firstReceived.size());
+  EXPECT_EQ(1, secondReceived.size());
+}
+
+TEST(MessageQueueTest, DestroyingASuspendedAwaitCancelsIt) {
+  LoggerMock        logger;
+  MessageQueue<int> queue(logger, 1);
+  EventWriter<int>  writer(queue);
+  EventReader<int>  reader(queue);
+  ManualExecutor    executor;
+  std::vector<int>  received;
+
+  // Destroyed while parked on the queue: the next write doesn't post anything
+  consume_owned(reader, executor, received).handle.destroy();
+  writer.write(1);
+  EXPECT_TRUE(executor.jobs.empty());
+
+  // Destroyed after a write posted its resumption: the job does nothing
+  std::vector<int> drained;
+  reader.drain([&](const int msg) { drained.push_back(msg); });
+  OwnedTask task = consume_owned(reader, executor, received);
+  writer.write(2);
+  ASSERT_EQ(1, executor.jobs.size());
+  task.handle.destroy();
+  executor.run_all();
+
+  EXPECT_TRUE(received.empty());
+  reader.drain([&](const int msg) { drained.push_back(msg); });
+  EXPECT_EQ((std::vector<int>{1, 2}), drained);
+}
+
+TEST(MessageQueueTest, DrainSkipsExpiredMessages) {
+  LoggerMock                  logger;
+  ClockMock                   clock(TimePoint_t(1s));
+  MessageQueue<Expiring<int>> queue(logger, 1);
+  EventWriter<Expiring<int>>  writer(queue);
+  EventReader<Expiring<int>>  reader(queue);
+
+  writer.write(1, 100ms, clock);
+  writer.write(2, TimePoint_t(1s + 500ms));
+  writer.write(3, 1s, clock);
+  writer.write({.message = 4});  // Never expires
+
+  clock.set_now(TimePoint_t(1s + 200ms));
+
+  std::vector<int> fresh;
+  reader.drain(clock, [&](const int msg) { fresh.push_back(msg); });
+  EXPECT_EQ((std::vector<int>{2, 3, 4}), fresh);
+  EXPECT_EQ(1, reader.expired());
+
+  writer.write(5, 100ms, clock);
+  writer.write(6, 1s, clock);
+  clock.set_now(TimePoint_t(1s + 400ms));
+
+  fresh.clear();
+  reader.drain(clock, [&](const int msg) { fresh.push_back(msg); });
+  EXPECT_EQ((std::vector<int>{6}), fresh);
+  EXPECT_EQ(2, reader.expired());
+}
+
+namespace {
+
+struct Tick {
+  int price = 0;
+};
+
+struct Fill {
+  int quantity = 0;
+};
+
+using MarketEvent_t = std::variant<Tick, Fill, std::string>;
+
+template<typename... Handlers_t>
+concept CanDispatch = requires(EventReader<MarketEvent_t> &reader, Handlers_t... handlers) {
+  reader.dispatch(handlers...);
+};
+
+}  // namespace
+
+TEST(MessageQueueTest, DispatchHandlesEveryKindInQueueOrder) {
+  LoggerMock                  logger;
+  MessageQueue<MarketEvent_t> queue(logger, 1);
+  EventWriter<MarketEvent_t>  writer(queue);
+  EventReader<MarketEvent_t>  reader(queue);
+
+  writer.write(Tick{1});
+  writer.write(Fill{10});
+  writer.write(std::string("halt"));
+  writer.write(Tick{2});
+
+  std::vector<std::string> seen;
+  reader.dispatch([&](const Tick &tick) { seen.push_back(std::format("tick {}", tick.price)); },
+                  [&](const Fill &fill) { seen.push_back(std::format("fill {}", fill.quantity)); },
+                  [&](const std::string &note) { seen.push_back(note); });
+  EXPECT_EQ((std::vector<std::string>{"tick 1", "fill 10", "halt", "tick 2"}), seen);
+
+  // A catch-all handler covers the alternatives without one of their own
+  writer.write(Fill{20});
+  writer.write(Tick{3});
+  int ticks  = 0;
+  int others = 0;
+  reader.dispatch([&](const Tick &) { ++ticks; }, [&](const auto &) { ++others; });
+  EXPECT_EQ(1, ticks);
+  EXPECT_EQ(1, others);
+
+  // Leaving out an alternative doesn't compile
+  const auto onTick = [](const Tick &) { };
+  const auto onFill = [](const Fill &) { };
+  const auto onNote = [](const std::string &) { };
+  static_assert(CanDispatch<decltype(onTick), decltype(onFill), decltype(onNote)>);
+  static_assert(!CanDispatch<decltype(onTick), decltype(onFill)>);
+}